@@ -797,11 +797,26 @@ namespace graphene { namespace chain {
         * @return true if we switched forks as a result of this push.
         */
         bool database::push_block(const signed_block &new_block, uint32_t skip) {
+            return push_block(new_block, skip, fc::optional<fc::ecc::public_key>());
+        }
+
+        bool database::push_block(
+                const signed_block &new_block, uint32_t skip, const fc::optional<fc::ecc::public_key> &signee
+        ) {
             //fc::time_point begin_time = fc::time_point::now();
 
             bool result;
             with_strong_write_lock([&]() {
                 detail::without_pending_transactions(*this, skip, std::move(_pending_tx), [&]() {
+                    // pending transactions are popped, so the key of witness is taken from the state of the head,
+                    // other blocks can be applied on switching of forks, so it's used only on top of the head
+                    if (signee.valid() && !(skip & skip_witness_signature) && new_block.previous == head_block_id()) {
+                        const auto *witness = find_witness(new_block.witness);
+                        if (witness && witness->signing_key == public_key_type(*signee)) {
+                            skip |= skip_witness_signature;
+                        }
+                    }
+
                     try {
                         result = _push_block(new_block, skip);
                         check_free_memory(false, new_block.block_num());
@@ -944,6 +959,38 @@ namespace graphene { namespace chain {
             FC_CAPTURE_AND_RETHROW((trx))
         }
 
+        std::vector<fc::oexception> database::push_transactions(
+                const std::vector<signed_transaction> &trxs,
+                const std::vector<flat_set<public_key_type>> &signature_keys,
+                uint32_t skip
+        ) {
+            FC_ASSERT(trxs.size() == signature_keys.size());
+            std::vector<fc::oexception> result(trxs.size());
+            const uint32_t prevalidated_steps =
+                skip_authority_check |
+                skip_transaction_signatures |
+                skip_validate_operations;
+
+            with_weak_write_lock([&]() {
+                detail::with_producing(*this, [&]() {
+                    const auto maximum_size = get_dynamic_global_properties().maximum_block_size - 256;
+                    for (size_t i = 0; i < trxs.size(); ++i) {
+                        try {
+                            FC_ASSERT(fc::raw::pack_size(trxs[i]) <= maximum_size);
+                            // only recovering of keys is skipped, the authority can be changed after prevalidation
+                            if (!(skip & (skip_transaction_signatures | skip_authority_check))) {
+                                _verify_authority(trxs[i], signature_keys[i]);
+                            }
+                            _push_transaction(trxs[i], skip | prevalidated_steps);
+                        } catch (const fc::exception &e) {
+                            result[i] = e;
+                        }
+                    }
+                });
+            });
+            return result;
+        }
+
         void database::_push_transaction(const signed_transaction &trx, uint32_t skip) {
             // If this is the first transaction pushed after applying a block, start a new undo session.
             // This allows us to quickly rewind to the clean state of the head block, in case a new block arrives.
@@ -1184,6 +1231,10 @@ namespace graphene { namespace chain {
             notify_post_apply_operation(note);
         }
 
+        void database::notify_pre_apply_block(const signed_block &block) {
+            CHAIN_TRY_NOTIFY(pre_apply_block, block)
+        }
+
         void database::notify_applied_block(const signed_block &block) {
             CHAIN_TRY_NOTIFY(applied_block, block)
         }
@@ -2984,28 +3035,7 @@ namespace graphene { namespace chain {
             }
 
             if (!(skip & (skip_transaction_signatures | skip_authority_check))) {
-                const chain_id_type &chain_id = CHAIN_ID;
-
-                auto get_active = [&](const account_name_type& name) {
-                    return authority(get<account_authority_object, by_account>(name).active);
-                };
-
-                auto get_master = [&](const account_name_type& name) {
-                    return authority(get<account_authority_object, by_account>(name).master);
-                };
-
-                auto get_regular = [&](const account_name_type& name) {
-                    return authority(get<account_authority_object, by_account>(name).regular);
-                };
-
-                try {
-                    trx.verify_authority(chain_id, get_active, get_master, get_regular, CHAIN_MAX_SIG_CHECK_DEPTH);
-                }
-                catch (protocol::tx_missing_active_auth &e) {
-                    if (get_shared_db_merkle().find(head_block_num() + 1) == get_shared_db_merkle().end()) {
-                        throw e;
-                    }
-                }
+                _verify_authority(trx, trx.get_signature_keys(CHAIN_ID));
             }
 
             //Skip all manner of expiration and TaPoS checking if we're on block 1;
@@ -3032,6 +3062,29 @@ namespace graphene { namespace chain {
             }
         }
 
+        void database::_verify_authority(const signed_transaction &trx, const flat_set<public_key_type> &signature_keys) {
+            auto get_active = [&](const account_name_type& name) {
+                return authority(get<account_authority_object, by_account>(name).active);
+            };
+
+            auto get_master = [&](const account_name_type& name) {
+                return authority(get<account_authority_object, by_account>(name).master);
+            };
+
+            auto get_regular = [&](const account_name_type& name) {
+                return authority(get<account_authority_object, by_account>(name).regular);
+            };
+
+            try {
+                protocol::verify_authority(trx.operations, signature_keys, get_active, get_master, get_regular, CHAIN_MAX_SIG_CHECK_DEPTH);
+            }
+            catch (protocol::tx_missing_active_auth &e) {
+                if (get_shared_db_merkle().find(head_block_num() + 1) == get_shared_db_merkle().end()) {
+                    throw e;
+                }
+            }
+        }
+
         void database::notify_changed_objects() {
             try {
                 /*vector< graphene::chainbase::generic_id > ids;
@@ -3068,6 +3121,10 @@ namespace graphene { namespace chain {
             return _block_log;
         }
 
+        void database::set_read_lock_wait_observer(read_lock_wait_observer_type observer) {
+            _read_lock_wait_observer = std::move(observer);
+        }
+
 //////////////////// private methods ////////////////////
 
         void database::apply_block(const signed_block &next_block, uint32_t skip) {
@@ -3142,6 +3199,8 @@ namespace graphene { namespace chain {
                 _current_trx_in_block = 0;
                 _current_virtual_op = 0;
 
+                notify_pre_apply_block(next_block);
+
                 /// modify current witness so transaction evaluators can know who included the transaction,
                 /// this is mostly for POW operations which must pay the current_witness
                 modify(gprops, [&](dynamic_global_property_object &dgp) {
@@ -194,10 +194,28 @@ namespace graphene { namespace chain {
 
             bool push_block(const signed_block &b, uint32_t skip = skip_nothing);
 
+            /**
+             *  Pushes the block, which signee is already recovered. If the block is pushed on top of the head,
+             *  the signee is compared with the signing key of witness instead of recovering it again.
+             */
+            bool push_block(const signed_block &b, uint32_t skip, const fc::optional<fc::ecc::public_key> &signee);
+
             void enable_plugins_on_push_transaction(bool);
 
             void push_transaction(const signed_transaction &trx, uint32_t skip = skip_nothing);
 
+            /**
+             *  Pushes transactions to the pending state under one acquisition of the write lock.
+             *  Operations are validated and keys of signatures are recovered by the caller,
+             *  the authority is checked again by these keys under the write lock, because a previous transaction
+             *  or a block can change it after prevalidation (see verify_authority()).
+             *  @return errors of rejected transactions in the same order, a rejected transaction doesn't affect others
+             */
+            std::vector<fc::oexception> push_transactions(
+                    const std::vector<signed_transaction> &trxs,
+                    const std::vector<flat_set<public_key_type>> &signature_keys,
+                    uint32_t skip = skip_nothing);
+
             void _maybe_warn_multiple_production(uint32_t height) const;
 
             bool _push_block(const signed_block &b, uint32_t skip);
@@ -239,6 +257,8 @@ namespace graphene { namespace chain {
             void notify_post_apply_operation(const operation_notification &note);
 
             inline const void push_virtual_operation(const operation &op, bool force = false); // vops are not needed for low mem. Force will push them on low mem.
+            void notify_pre_apply_block(const signed_block &block);
+
             void notify_applied_block(const signed_block &block);
 
             void notify_on_pending_transaction(const signed_transaction &tx);
@@ -261,6 +281,12 @@ namespace graphene { namespace chain {
              */
             fc::signal<void(const signed_block &)> applied_block;
 
+            /**
+             *  This signal is emitted when a block starts to be applied, before any of its operations.
+             *  If the block fails to apply, applied_block isn't emitted for it.
+             */
+            fc::signal<void(const signed_block &)> pre_apply_block;
+
             /**
              * This signal is emitted any time a new transaction is added to the pending
              * block state.
@@ -416,6 +442,15 @@ namespace graphene { namespace chain {
              */
             uint32_t validate_transaction(const signed_transaction &trx, uint32_t skip = skip_nothing);
 
+            /**
+             *  Checks the authority of transaction by keys of its signatures, which are recovered beforehand.
+             *  Should be called under the read lock, it's an early check, push_transactions() repeats it.
+             *  @throw if the transaction isn't authorized
+             */
+            void verify_authority(const signed_transaction &trx, const flat_set<public_key_type> &signature_keys) {
+                _verify_authority(trx, signature_keys);
+            }
+
             /** when popping a block, the transactions that were removed get cached here so they
              * can be reapplied at the proper time */
             std::deque<signed_transaction> _popped_tx;
@@ -439,6 +474,26 @@ namespace graphene { namespace chain {
 
             const block_log &get_block_log() const;
 
+            using read_lock_wait_observer_type = std::function<void(const fc::microseconds &)>;
+
+            /**
+             * The observer receives time which was spent on waiting of read lock in with_weak_read_lock()
+             */
+            void set_read_lock_wait_observer(read_lock_wait_observer_type observer);
+
+            template<typename Lambda>
+            auto with_weak_read_lock(Lambda &&callback) const -> decltype(callback()) {
+                if (!_read_lock_wait_observer) {
+                    return chainbase::database::with_weak_read_lock(std::forward<Lambda>(callback));
+                }
+
+                auto start = fc::time_point::now();
+                return chainbase::database::with_weak_read_lock([&]() -> decltype(callback()) {
+                    _read_lock_wait_observer(fc::time_point::now() - start);
+                    return callback();
+                });
+            }
+
         protected:
             //Mark pop_undo() as protected -- we do not want outside calling pop_undo(); it should call pop_block() instead
             //void pop_undo() { object_database::pop_undo(); }
@@ -459,6 +514,8 @@ namespace graphene { namespace chain {
 
             void _validate_transaction(const signed_transaction& trx, uint32_t skip);
 
+            void _verify_authority(const signed_transaction& trx, const flat_set<public_key_type>& signature_keys);
+
             void apply_operation(const operation &op, bool is_virtual = false);
 
 
@@ -537,6 +594,8 @@ namespace graphene { namespace chain {
 
             flat_map<std::string, std::shared_ptr<custom_operation_interpreter>> _custom_operation_interpreters;
             std::string _json_schema;
+
+            read_lock_wait_observer_type _read_lock_wait_observer;
         };
 
 } } // graphene::chain
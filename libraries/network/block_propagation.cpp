@@ -0,0 +1,247 @@
+#include <graphene/network/block_propagation.hpp>
+#include <graphene/network/config.hpp>
+
+#include <fc/log/logger.hpp>
+
+#ifdef DEFAULT_LOGGER
+# undef DEFAULT_LOGGER
+#endif
+#define DEFAULT_LOGGER "p2p"
+
+namespace graphene {
+    namespace network {
+
+        // counters of peers, which didn't advertise blocks during this time, are dropped
+        static const fc::microseconds peer_stats_lifetime = fc::hours(1);
+
+        static std::string peer_name(const fc::optional<fc::ip::endpoint> &peer) {
+            return peer ? std::string(*peer) : std::string("unknown");
+        }
+
+        const char *block_propagation_stage_name(block_propagation_stage stage) {
+            switch (stage) {
+                case first_inventory_stage:
+                    return "first_inventory";
+                case requested_stage:
+                    return "requested";
+                case received_stage:
+                    return "received";
+                case deserialized_stage:
+                    return "deserialized";
+                case validated_stage:
+                    return "validated";
+                case applied_stage:
+                    return "applied";
+                case advertised_stage:
+                    return "advertised";
+                default:
+                    return "unknown";
+            }
+        }
+
+        fc::variant_object block_propagation_trace::to_variant_object() const {
+            fc::mutable_variant_object result;
+            result["block_id"] = block_id;
+            result["block_num"] = block_num;
+            result["block_time"] = block_time;
+            if (block_num) {
+                result["inventory_delay_us"] = (stage_times[first_inventory_stage] - fc::time_point(block_time)).count();
+            }
+            result["first_advertiser"] = first_advertiser;
+            result["advertisers"] = advertisers;
+            result["requested_from"] = requested_from;
+            result["received_from"] = received_from;
+
+            fc::mutable_variant_object stages;
+            for (uint32_t i = 0; i < block_propagation_stage_count; ++i) {
+                auto stage = block_propagation_stage(i);
+                if (has_stage(stage)) {
+                    stages[block_propagation_stage_name(stage)] =
+                            (stage_times[stage] - stage_times[first_inventory_stage]).count();
+                }
+            }
+            result["stages_us"] = fc::variant_object(stages);
+            return result;
+        }
+
+        fc::variant_object block_propagation_peer_stats::to_variant_object() const {
+            fc::mutable_variant_object result;
+            result["blocks_advertised"] = blocks_advertised;
+            result["blocks_advertised_first"] = blocks_advertised_first;
+            result["average_advertise_delay_us"] = blocks_advertised
+                    ? advertise_delay.count() / blocks_advertised : 0;
+            result["blocks_received"] = blocks_received;
+            result["average_download_time_us"] = blocks_downloaded
+                    ? download_time.count() / blocks_downloaded : 0;
+            result["last_seen"] = last_seen;
+            return result;
+        }
+
+        block_propagation_trace *block_propagation_tracker::find_trace(const item_hash_t &hash) {
+            auto iter = _traces.find(hash);
+            return iter != _traces.end() ? &iter->second : nullptr;
+        }
+
+        void block_propagation_tracker::on_inventory(const item_hash_t &hash,
+                const fc::optional<fc::ip::endpoint> &endpoint) {
+            const std::string peer = peer_name(endpoint);
+            fc::time_point now = fc::time_point::now();
+            auto &stats = _peer_stats[peer];
+            stats.last_seen = now;
+            ++stats.blocks_advertised;
+
+            auto trace = find_trace(hash);
+            if (trace) {
+                ++trace->advertisers;
+                stats.advertise_delay += now - trace->stage_times[first_inventory_stage];
+                return;
+            }
+
+            ++stats.blocks_advertised_first;
+            if (_trace_order.size() >= GRAPHENE_NET_BLOCK_PROPAGATION_TRACES) {
+                _traces.erase(_trace_order.front());
+                _trace_order.pop_front();
+            }
+            auto &new_trace = _traces[hash];
+            new_trace.first_advertiser = peer;
+            new_trace.advertisers = 1;
+            new_trace.stage_times[first_inventory_stage] = now;
+            _trace_order.push_back(hash);
+        }
+
+        void block_propagation_tracker::on_requested(const item_hash_t &hash,
+                const fc::optional<fc::ip::endpoint> &endpoint) {
+            auto trace = find_trace(hash);
+            if (trace && !trace->has_stage(requested_stage)) {
+                trace->requested_from = peer_name(endpoint);
+                trace->stage_times[requested_stage] = fc::time_point::now();
+            }
+        }
+
+        void block_propagation_tracker::on_received(const item_hash_t &hash,
+                const fc::optional<fc::ip::endpoint> &endpoint, const fc::time_point &received_time) {
+            auto trace = find_trace(hash);
+            if (!trace || trace->has_stage(received_stage)) {
+                return;
+            }
+            const std::string peer = peer_name(endpoint);
+            trace->received_from = peer;
+            trace->stage_times[received_stage] = received_time;
+
+            auto &stats = _peer_stats[peer];
+            stats.last_seen = fc::time_point::now();
+            ++stats.blocks_received;
+            if (trace->requested_from == peer && trace->has_stage(requested_stage)) {
+                ++stats.blocks_downloaded;
+                stats.download_time += received_time - trace->stage_times[requested_stage];
+            }
+        }
+
+        void block_propagation_tracker::on_unpacked(const item_hash_t &hash, const block_message &block) {
+            auto trace = find_trace(hash);
+            if (!trace || trace->has_stage(deserialized_stage)) {
+                return;
+            }
+            trace->block_id = block.block_id;
+            trace->block_num = block.block.block_num();
+            trace->block_time = block.block.timestamp;
+            trace->stage_times[deserialized_stage] = block.deserialized_time;
+            trace->stage_times[validated_stage] = block.validated_time;
+        }
+
+        void block_propagation_tracker::on_applied(const item_hash_t &hash) {
+            auto trace = find_trace(hash);
+            if (trace && !trace->has_stage(applied_stage)) {
+                trace->stage_times[applied_stage] = fc::time_point::now();
+            }
+        }
+
+        void block_propagation_tracker::on_advertised(const item_hash_t &hash) {
+            auto trace = find_trace(hash);
+            if (trace && !trace->has_stage(advertised_stage)) {
+                trace->stage_times[advertised_stage] = fc::time_point::now();
+                record_completed_trace(*trace);
+            }
+        }
+
+        void block_propagation_tracker::record_completed_trace(const block_propagation_trace &trace) {
+            if (!trace.block_num) {
+                // the block was advertised, but it came in the way, which isn't traced
+                return;
+            }
+
+            ++_completed_traces;
+            fc::time_point previous_time = fc::time_point(trace.block_time);
+            for (uint32_t i = 0; i < block_propagation_stage_count; ++i) {
+                auto stage = block_propagation_stage(i);
+                if (!trace.has_stage(stage)) {
+                    continue;
+                }
+                fc::microseconds delay = trace.stage_times[stage] - previous_time;
+                auto &stats = _stage_stats[stage];
+                ++stats.blocks;
+                stats.total_delay += delay;
+                stats.max_delay = std::max(stats.max_delay, delay);
+                previous_time = trace.stage_times[stage];
+            }
+
+            const auto &times = trace.stage_times;
+            auto offset_ms = [&](block_propagation_stage stage) -> int64_t {
+                return trace.has_stage(stage) ? (times[stage] - times[first_inventory_stage]).count() / 1000 : -1;
+            };
+            ilog("block #${n} propagation: first inventory ${i} ms after block time from ${first} (${a} advertisers), "
+                 "requested +${r} ms from ${requested_from}, received +${rc} ms from ${received_from}, "
+                 "deserialized +${d} ms, validated +${v} ms, applied +${ap} ms, advertised +${ad} ms",
+                 ("n", trace.block_num)
+                 ("i", (times[first_inventory_stage] - fc::time_point(trace.block_time)).count() / 1000)
+                 ("first", trace.first_advertiser)("a", trace.advertisers)
+                 ("r", offset_ms(requested_stage))("requested_from", trace.requested_from)
+                 ("rc", offset_ms(received_stage))("received_from", trace.received_from)
+                 ("d", offset_ms(deserialized_stage))("v", offset_ms(validated_stage))
+                 ("ap", offset_ms(applied_stage))("ad", offset_ms(advertised_stage)));
+
+            fc::time_point expiration = fc::time_point::now() - peer_stats_lifetime;
+            for (auto iter = _peer_stats.begin(); iter != _peer_stats.end();) {
+                if (iter->second.last_seen < expiration) {
+                    iter = _peer_stats.erase(iter);
+                } else {
+                    ++iter;
+                }
+            }
+        }
+
+        fc::variant_object block_propagation_tracker::get_stats() const {
+            fc::mutable_variant_object result;
+            result["completed_blocks"] = _completed_traces;
+
+            std::vector<fc::variant> stages;
+            for (uint32_t i = 0; i < block_propagation_stage_count; ++i) {
+                const auto &stats = _stage_stats[i];
+                fc::mutable_variant_object stage;
+                stage["stage"] = block_propagation_stage_name(block_propagation_stage(i));
+                stage["blocks"] = stats.blocks;
+                stage["average_delay_us"] = stats.blocks ? stats.total_delay.count() / stats.blocks : 0;
+                stage["max_delay_us"] = stats.max_delay.count();
+                stages.emplace_back(fc::variant_object(stage));
+            }
+            result["stages"] = stages;
+
+            std::vector<fc::variant> peers;
+            for (const auto &peer_and_stats : _peer_stats) {
+                fc::mutable_variant_object peer(peer_and_stats.second.to_variant_object());
+                peer["peer"] = peer_and_stats.first;
+                peers.emplace_back(fc::variant_object(peer));
+            }
+            result["peers"] = peers;
+
+            // the most recent blocks first
+            std::vector<fc::variant> recent_blocks;
+            for (auto iter = _trace_order.rbegin(); iter != _trace_order.rend(); ++iter) {
+                recent_blocks.emplace_back(_traces.at(*iter).to_variant_object());
+            }
+            result["recent_blocks"] = recent_blocks;
+            return result;
+        }
+
+    }
+} // graphene::network
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <graphene/network/core_messages.hpp>
+
+#include <fc/network/ip.hpp>
+#include <fc/optional.hpp>
+#include <fc/time.hpp>
+#include <fc/variant_object.hpp>
+
+#include <array>
+#include <deque>
+#include <map>
+#include <string>
+
+namespace graphene {
+    namespace network {
+
+        /**
+         *  Stages of a block on its way through the node during normal operation
+         */
+        enum block_propagation_stage {
+            first_inventory_stage, ///< the first peer advertised the block
+            requested_stage,       ///< the block was requested from a peer
+            received_stage,        ///< the block or its compact form was received
+            deserialized_stage,    ///< the block was unpacked in an IO thread
+            validated_stage,       ///< the merkle root was checked and the signee was recovered
+            applied_stage,         ///< the delegate pushed the block
+            advertised_stage,      ///< the block was advertised to other peers
+            block_propagation_stage_count
+        };
+
+        const char *block_propagation_stage_name(block_propagation_stage stage);
+
+        /**
+         *  Times of stages of one block, unset stages have the zero time
+         */
+        struct block_propagation_trace {
+            block_id_type block_id;
+            uint32_t block_num = 0;
+            fc::time_point_sec block_time;
+
+            std::string first_advertiser;
+            std::string requested_from;
+            std::string received_from;
+            uint32_t advertisers = 0;
+
+            std::array<fc::time_point, block_propagation_stage_count> stage_times;
+
+            bool has_stage(block_propagation_stage stage) const {
+                return stage_times[stage] != fc::time_point();
+            }
+
+            /// Offsets of stages are in microseconds since the first inventory
+            fc::variant_object to_variant_object() const;
+        };
+
+        /**
+         *  Counters of a peer, they show which peers deliver new blocks first and how fast
+         */
+        struct block_propagation_peer_stats {
+            uint32_t blocks_advertised = 0;
+            uint32_t blocks_advertised_first = 0;
+            fc::microseconds advertise_delay; /// sum of delays behind the first advertiser
+            uint32_t blocks_received = 0;
+            uint32_t blocks_downloaded = 0;
+            fc::microseconds download_time; /// sum of times from the request to the block from this peer
+            fc::time_point last_seen;
+
+            fc::variant_object to_variant_object() const;
+        };
+
+        /**
+         *  Records the path of new blocks through the node: a trace is started by the first inventory of a block,
+         *  other stages are recorded only for traced blocks, so blocks of sync aren't traced.
+         *  Completed traces are logged and aggregated per stage and per peer. It lives in the p2p thread.
+         */
+        class block_propagation_tracker final {
+        public:
+            void on_inventory(const item_hash_t &hash, const fc::optional<fc::ip::endpoint> &peer);
+
+            void on_requested(const item_hash_t &hash, const fc::optional<fc::ip::endpoint> &peer);
+
+            void on_received(const item_hash_t &hash, const fc::optional<fc::ip::endpoint> &peer,
+                    const fc::time_point &received_time);
+
+            /// Takes times of deserialization and validation of the block in an IO thread
+            void on_unpacked(const item_hash_t &hash, const block_message &block);
+
+            void on_applied(const item_hash_t &hash);
+
+            /// Completes the trace
+            void on_advertised(const item_hash_t &hash);
+
+            fc::variant_object get_stats() const;
+
+        private:
+            /// Delays between consecutive stages of completed traces, the first stage is counted since the block time
+            struct stage_stats {
+                uint32_t blocks = 0;
+                fc::microseconds total_delay;
+                fc::microseconds max_delay;
+            };
+
+            block_propagation_trace *find_trace(const item_hash_t &hash);
+
+            void record_completed_trace(const block_propagation_trace &trace);
+
+            std::map<item_hash_t, block_propagation_trace> _traces;
+            std::deque<item_hash_t> _trace_order;
+            std::map<std::string, block_propagation_peer_stats> _peer_stats;
+            std::array<stage_stats, block_propagation_stage_count> _stage_stats;
+            uint32_t _completed_traces = 0;
+        };
+
+    }
+} // graphene::network
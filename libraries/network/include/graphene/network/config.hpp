@@ -57,6 +57,25 @@
 
 #define GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES        (1024 * 1024)
 
+/**
+ * Memory budget of send queues of all peers. When it's exhausted, peers with queues larger than
+ * GRAPHENE_NET_MINIMUM_QUEUED_MESSAGES_IN_BYTES are disconnected on queueing of new messages,
+ * so a few slow peers can't hold the memory of the node.
+ */
+#define GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES_TOTAL  (64 * 1024 * 1024)
+#define GRAPHENE_NET_MINIMUM_QUEUED_MESSAGES_IN_BYTES        (64 * 1024)
+
+/**
+ * Queued messages are sent to a peer in batches up to this size with one encryption pass and one write
+ */
+#define GRAPHENE_NET_MAX_SEND_BATCH_SIZE                     (64 * 1024)
+
+/**
+ * Blocks and lists of block ids starting from this size are compressed for peers, which support it,
+ * compression of smaller messages doesn't pay off
+ */
+#define GRAPHENE_NET_COMPRESSION_MIN_MESSAGE_SIZE            1024
+
 /**
  * When we receive a message from the network, we advertise it to
  * our peers and save a copy in a cache were we will find it if
@@ -81,6 +100,21 @@
 
 #define GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING      200
 
+/**
+ * During sync the number of blocks requested from a peer at a time follows
+ * the measured throughput of the peer, so a batch arrives in about this time.
+ * Slow peers get small batches and don't hold blocks, which are needed next.
+ */
+#define GRAPHENE_NET_SYNC_REQUEST_DURATION_SEC               5
+#define GRAPHENE_NET_MIN_BLOCKS_PER_PEER_DURING_SYNCING      10
+
+/**
+ * During sync the number of blocks downloaded ahead of the applied ones
+ * follows the measured rate of applying, the backlog covers about this time
+ * of applying.
+ */
+#define GRAPHENE_NET_SYNC_PREFETCH_DURATION_SEC              30
+
 /**
  * During normal operation, how many items will be fetched from each
  * peer at a time.  This will only come into play when the network
@@ -94,6 +128,32 @@
  */
 #define GRAPHENE_NET_MAX_ITEMS_PER_PEER_DURING_NORMAL_OPERATION  1
 
+/**
+ * Transactions are fetched from a peer in batches up to this number per request,
+ * and replies to peers, which support it, are packed into trx_batch_message up to
+ * GRAPHENE_NET_MAX_TRX_BATCH_SIZE bytes.
+ */
+#define GRAPHENE_NET_MAX_TRX_PER_PEER_DURING_NORMAL_OPERATION   100
+#define GRAPHENE_NET_MAX_TRX_BATCH_SIZE                      (64 * 1024)
+
+/**
+ * Maximum number of compact blocks of a peer, which wait for their missing transactions,
+ * a peer sending more of them is disconnected
+ */
+#define GRAPHENE_NET_MAX_PARTIAL_COMPACT_BLOCKS_PER_PEER     4
+
+/**
+ * New transactions are collected during this time before advertising them to peers,
+ * so inventory messages carry many of them. New blocks are advertised at once.
+ */
+#define GRAPHENE_NET_TRANSACTION_AGGREGATION_WINDOW_MS       50
+
+/**
+ * Stages of propagation are kept for this number of recent blocks,
+ * they're reported by node::get_block_propagation_stats()
+ */
+#define GRAPHENE_NET_BLOCK_PROPAGATION_TRACES                100
+
 /**
  * Instead of fetching all item IDs from a peer, then fetching all blocks
  * from a peer, we will interleave them.  Fetch at least this many block IDs,
@@ -103,3 +163,9 @@
 #define GRAPHENE_NET_MIN_BLOCK_IDS_TO_PREFETCH               10000
 
 #define GRAPHENE_NET_MAX_TRX_PER_SECOND                      1000
+
+/**
+ * Bodies of messages starting from this size are decrypted and hashed in p2p IO threads,
+ * smaller ones are cheaper to process in the p2p thread than to pass to another thread.
+ */
+#define GRAPHENE_NET_IO_THREAD_MIN_MESSAGE_SIZE              (16 * 1024)
@@ -35,6 +35,7 @@
 #include <fc/variant_object.hpp>
 #include <fc/exception/exception.hpp>
 #include <fc/io/enum_type.hpp>
+#include <fc/optional.hpp>
 
 
 #include <vector>
@@ -46,6 +47,7 @@ namespace graphene {
         using graphene::protocol::block_id_type;
         using graphene::protocol::transaction_id_type;
         using graphene::protocol::signed_block;
+        using graphene::protocol::signed_block_header;
 
         typedef fc::ecc::public_key_data node_id_t;
         typedef fc::ripemd160 item_hash_t;
@@ -89,6 +91,11 @@ namespace graphene {
             check_firewall_reply_message_type = 5015,
             get_current_connections_request_message_type = 5016,
             get_current_connections_reply_message_type = 5017,
+            compact_block_message_type = 5018,
+            get_block_transactions_message_type = 5019,
+            block_transactions_message_type = 5020,
+            compressed_message_type = 5021,
+            trx_batch_message_type = 5022,
             core_message_type_last = 5099
         };
 
@@ -107,6 +114,17 @@ namespace graphene {
             }
         };
 
+        /**
+         *  Replies to fetch_items_message with several transactions for peers, which told in hello that
+         *  they support it. Items are data of trx_message as is, so the receiver gets the same message
+         *  hashes as for separate messages without packing transactions again.
+         */
+        struct trx_batch_message {
+            static const core_message_type_enum type;
+
+            std::vector<std::vector<char>> trx_messages;
+        };
+
         struct block_message {
             static const core_message_type_enum type;
 
@@ -120,6 +138,87 @@ namespace graphene {
             signed_block block;
             block_id_type block_id;
 
+            /// Results of checks done by node in p2p IO threads before passing the block to the delegate,
+            /// they aren't serialized
+            /// @{
+            bool merkle_root_checked = false;
+            fc::optional<fc::ecc::public_key> signee;
+            fc::time_point deserialized_time;
+            fc::time_point validated_time;
+            /// @}
+
+        };
+
+        /**
+         *  Short id of a transaction in compact blocks, it's the first 8 bytes of the transaction id
+         */
+        typedef uint64_t short_transaction_id_type;
+
+        short_transaction_id_type get_short_transaction_id(const transaction_id_type &id);
+
+        struct prefilled_transaction {
+            uint32_t index;
+            signed_transaction trx;
+
+            prefilled_transaction() {
+            }
+
+            prefilled_transaction(uint32_t index, signed_transaction trx) :
+                    index(index),
+                    trx(std::move(trx)) {
+            }
+        };
+
+        /**
+         *  Is sent instead of block_message to peers, which support compact blocks, in reply to
+         *  fetch_items_message during normal operation. Peers usually already have transactions of the block,
+         *  so they're identified by short ids and the receiver reconstructs the block from the transactions
+         *  it has. Transactions, which the peer doesn't know about, are prefilled.
+         */
+        struct compact_block_message {
+            static const core_message_type_enum type;
+
+            signed_block_header header;
+            block_id_type block_id;
+            std::vector<short_transaction_id_type> short_ids; // of all transactions of the block
+            std::vector<prefilled_transaction> prefilled_transactions;
+        };
+
+        /**
+         *  Requests transactions of the block, which the receiver of compact block can't find
+         */
+        struct get_block_transactions_message {
+            static const core_message_type_enum type;
+
+            block_id_type block_id;
+            std::vector<uint32_t> indexes;
+
+            get_block_transactions_message() {
+            }
+
+            get_block_transactions_message(const block_id_type &block_id, std::vector<uint32_t> indexes) :
+                    block_id(block_id),
+                    indexes(std::move(indexes)) {
+            }
+        };
+
+        struct block_transactions_message {
+            static const core_message_type_enum type;
+
+            block_id_type block_id;
+            std::vector<prefilled_transaction> transactions;
+        };
+
+        /**
+         *  Wraps a message compressed with zlib, it's sent only to peers, which told in hello that they
+         *  support compression. The receiver unpacks it into the original message before handling.
+         */
+        struct compressed_message {
+            static const core_message_type_enum type;
+
+            uint32_t msg_type; // of the original message
+            uint32_t size; // of data of the original message
+            std::vector<char> data;
         };
 
         struct item_ids_inventory_message {
@@ -444,10 +543,21 @@ FC_REFLECT_ENUM(graphene::network::core_message_type_enum,
                 (check_firewall_reply_message_type)
                 (get_current_connections_request_message_type)
                 (get_current_connections_reply_message_type)
+                (compact_block_message_type)
+                (get_block_transactions_message_type)
+                (block_transactions_message_type)
+                (compressed_message_type)
+                (trx_batch_message_type)
                 (core_message_type_last))
 
 FC_REFLECT((graphene::network::trx_message), (trx))
+FC_REFLECT((graphene::network::trx_batch_message), (trx_messages))
 FC_REFLECT((graphene::network::block_message), (block)(block_id))
+FC_REFLECT((graphene::network::prefilled_transaction), (index)(trx))
+FC_REFLECT((graphene::network::compact_block_message), (header)(block_id)(short_ids)(prefilled_transactions))
+FC_REFLECT((graphene::network::get_block_transactions_message), (block_id)(indexes))
+FC_REFLECT((graphene::network::block_transactions_message), (block_id)(transactions))
+FC_REFLECT((graphene::network::compressed_message), (msg_type)(size)(data))
 
 FC_REFLECT((graphene::network::item_id), (item_type)
         (item_hash))
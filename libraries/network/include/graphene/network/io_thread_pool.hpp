@@ -0,0 +1,53 @@
+#pragma once
+
+#include <fc/thread/thread.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace graphene {
+    namespace network {
+
+        /**
+         *  Threads for CPU-bound work on data of p2p connections: decryption of message bodies
+         *  and hashing of messages. Connections and the node live in the p2p thread, the fiber of
+         *  connection yields while its message is processed in an IO thread, so other connections
+         *  are served in the meantime.
+         *
+         *  The pool is process-wide, it's started by the p2p plugin. If it's not started, the work
+         *  is done in the calling thread.
+         */
+        class io_thread_pool final {
+        public:
+            static io_thread_pool &instance();
+
+            void start(uint32_t thread_count);
+
+            void stop();
+
+            bool is_running() const {
+                return !_threads.empty();
+            }
+
+            uint32_t size() const {
+                return (uint32_t)_threads.size();
+            }
+
+            /**
+             *  Runs the function in one of IO threads and waits for it, exceptions are rethrown
+             *  in the calling fiber. The function may use data on the stack of the calling fiber:
+             *  if the fiber is canceled, it doesn't return until the function finishes.
+             */
+            void run(const std::function<void()> &f);
+
+        private:
+            io_thread_pool() = default;
+
+            std::vector<std::unique_ptr<fc::thread>> _threads;
+            std::atomic<uint32_t> _next_thread{0};
+        };
+
+    }
+} // graphene::network
@@ -25,6 +25,7 @@
 
 #include <fc/array.hpp>
 #include <fc/io/varint.hpp>
+#include <fc/optional.hpp>
 #include <fc/network/ip.hpp>
 #include <fc/io/raw.hpp>
 #include <fc/crypto/ripemd160.hpp>
@@ -53,15 +54,21 @@ namespace graphene {
         struct message : public message_header {
             std::vector<char> data;
 
+            /**
+             *  Hash of data, if it's already calculated when the message was received,
+             *  it isn't serialized
+             */
+            fc::optional<message_hash_type> data_hash;
+
             message() {
             }
 
             message(message &&m)
-                    : message_header(m), data(std::move(m.data)) {
+                    : message_header(m), data(std::move(m.data)), data_hash(std::move(m.data_hash)) {
             }
 
             message(const message &m)
-                    : message_header(m), data(m.data) {
+                    : message_header(m), data(m.data), data_hash(m.data_hash) {
             }
 
             /**
@@ -75,6 +82,9 @@ namespace graphene {
             }
 
             fc::uint160_t id() const {
+                if (data_hash.valid()) {
+                    return *data_hash;
+                }
                 return fc::ripemd160::hash(data.data(), (uint32_t)data.size());
             }
 
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <graphene/network/message.hpp>
+
+#include <fc/time.hpp>
+#include <fc/variant_object.hpp>
+
+namespace graphene {
+    namespace network {
+
+        /**
+         *  Counters of compression of messages of a connection, they are reported in get_connected_peers()
+         */
+        struct compression_stats {
+            uint64_t messages_compressed = 0;
+            uint64_t bytes_before_compression = 0;
+            uint64_t bytes_after_compression = 0;
+            fc::microseconds compression_time;
+
+            uint64_t messages_decompressed = 0;
+            uint64_t bytes_before_decompression = 0;
+            uint64_t bytes_after_decompression = 0;
+            fc::microseconds decompression_time;
+
+            fc::variant_object to_variant_object() const;
+        };
+
+        /// Returns true if the message is worth compressing: a block or a list of block ids large enough
+        bool is_compressible_message(const message &m);
+
+        /**
+         *  Packs the message into compressed_message, returns false if it doesn't become smaller:
+         *  text of contents compresses well, but signatures and ids don't compress at all
+         */
+        bool compress_message(const message &m, message &compressed);
+
+        /// Unpacks the original message of compressed_message, throws if the data is malformed
+        void decompress_message(const message &m, message &original);
+
+    }
+} // graphene::network
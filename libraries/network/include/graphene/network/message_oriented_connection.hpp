@@ -58,6 +58,12 @@ namespace graphene {
 
             void send_message(const message &message_to_send);
 
+            /**
+             * Sends several messages with one encryption pass and one write to the socket,
+             * the peer receives them as if they were sent one by one
+             */
+            void send_messages(const std::vector<message> &messages_to_send);
+
             void close_connection();
 
             void destroy_connection();
@@ -277,6 +277,12 @@ namespace graphene {
 
             message_propagation_data get_block_propagation_data(const graphene::protocol::block_id_type &block_id);
 
+            /**
+             * Returns delays of stages of new blocks inside the node: from the first inventory to the request,
+             * receiving, unpacking, applying and advertising, averaged over recent blocks and per peer
+             */
+            fc::variant_object get_block_propagation_stats() const;
+
             node_id_t get_node_id() const;
 
             void set_allowed_peers(const std::vector<node_id_t> &allowed_peers);
@@ -26,6 +26,7 @@
 #include <graphene/network/node.hpp>
 #include <graphene/network/peer_database.hpp>
 #include <graphene/network/message_oriented_connection.hpp>
+#include <graphene/network/message_compression.hpp>
 #include <graphene/network/stcp_socket.hpp>
 #include <graphene/network/config.hpp>
 
@@ -40,6 +41,8 @@
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 
+#include <array>
+#include <map>
 #include <queue>
 #include <boost/container/deque.hpp>
 #include <fc/thread/future.hpp>
@@ -62,6 +65,33 @@ namespace graphene {
 
         class peer_connection;
 
+        /**
+         *  Classes of messages in the send queue of a peer, messages of a class are sent only when
+         *  queues of the previous classes are empty
+         */
+        enum class message_priority : uint8_t {
+            block, /// blocks, their announcements and requests, messages of the connection
+            transaction, /// transactions and their announcements and requests
+            sync /// replies to sync requests: blocks from the block log and lists of block ids
+        };
+
+        constexpr std::size_t message_priority_count = 3;
+
+        /// Returns the class of message, blocks from the block log should be queued with send_item() explicitly
+        message_priority get_message_priority(const message &m);
+
+        /**
+         *  Memory of messages queued for sending to all peers of the node. Sync replies are queued
+         *  as item ids and loaded at send time, so the budget is spent by peers, which don't read
+         *  blocks and transactions in time.
+         */
+        struct send_queue_budget {
+            std::size_t total_size = 0;
+            std::size_t max_size = GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES_TOTAL;
+        };
+
+        typedef std::shared_ptr<send_queue_budget> send_queue_budget_ptr;
+
         class peer_connection_delegate {
         public:
             virtual void on_message(peer_connection *originating_peer,
@@ -70,6 +100,9 @@ namespace graphene {
             virtual void on_connection_closed(peer_connection *originating_peer) = 0;
 
             virtual message get_message_for_item(const item_id &item) = 0;
+
+            /// The budget shared by all peers of the node, peers hold it, so it outlives the node
+            virtual send_queue_budget_ptr get_send_queue_budget() = 0;
         };
 
         class peer_connection;
@@ -168,9 +201,17 @@ namespace graphene {
             };
 
 
+            typedef std::queue<std::unique_ptr<queued_message>, std::list<std::unique_ptr<queued_message>>> queued_messages_type;
+
             size_t _total_queued_messages_size;
-            std::queue<std::unique_ptr<queued_message>, std::list<std::unique_ptr<queued_message>>> _queued_messages;
+            std::array<queued_messages_type, message_priority_count> _queued_messages; /// by message_priority
+            send_queue_budget_ptr _send_queue_budget;
             fc::future<void> _send_queued_messages_done;
+
+            bool has_queued_messages() const;
+
+            /// Removes the first message of the most important class from the queue
+            std::unique_ptr<queued_message> pop_queued_message();
         public:
             fc::time_point connection_initiation_time;
             fc::time_point connection_closed_time;
@@ -239,6 +280,9 @@ namespace graphene {
             item_hash_t last_block_delegate_has_seen; /// the hash of the last block  this peer has told us about that the peer knows
             fc::time_point_sec last_block_time_delegate_has_seen;
             bool inhibit_fetching_sync_blocks;
+            fc::time_point sync_items_request_time; /// the time we requested the current batch of sync items
+            uint32_t sync_items_request_size; /// the number of sync items in the current batch
+            double sync_items_per_second; /// throughput of the peer measured by batches of sync items, 0 if unknown
             /// @}
 
             /// non-synchronization state data
@@ -265,12 +309,26 @@ namespace graphene {
             timestamped_items_set_type inventory_advertised_to_peer;
 
             item_to_time_map_type items_requested_from_peer;  /// items we've requested from this peer during normal operation.  fetch from another peer if this peer disconnects
+
+            /// compact blocks from this peer, which wait for transactions requested by get_block_transactions_message
+            struct partial_compact_block {
+                signed_block block;
+                std::vector<uint32_t> missing_indexes;
+                bool all_transactions_requested = false; /// the reconstructed block didn't match the requested one
+                fc::time_point received_time; /// when the compact block was received, for tracing of propagation
+            };
+            std::map<block_id_type, partial_compact_block> partial_compact_blocks;
             /// @}
 
             // if they're flooding us with transactions, we set this to avoid fetching for a few seconds to let the
             // blockchain catch up
             fc::time_point transaction_fetching_inhibited_until;
 
+            bool supports_compact_blocks; /// the peer told in hello that it can reconstruct compact blocks
+            bool supports_compression; /// both sides told in hello that they can decompress messages
+            bool supports_trx_batches; /// the peer told in hello that it can receive trx_batch_message
+            compression_stats compression;
+
             uint32_t last_known_fork_block_number;
 
             fc::future<void> accept_or_connect_task_done;
@@ -300,11 +358,17 @@ namespace graphene {
 
             void on_connection_closed(message_oriented_connection *originating_connection) override;
 
-            void send_queueable_message(std::unique_ptr<queued_message> &&message_to_send);
+            void send_queueable_message(std::unique_ptr<queued_message> &&message_to_send, message_priority priority);
+
+            /// Returns compressed_message if the peer supports compression and the message is worth it
+            message compress_for_peer(message &&message_to_send);
+
+            message decompress_from_peer(const message &received_message);
 
             void send_message(const message &message_to_send, size_t message_send_time_field_offset = (size_t)-1);
 
-            void send_item(const item_id &item_to_send);
+            /// Queues the item id, the message is generated by the node when it's sent
+            void send_item(const item_id &item_to_send, message_priority priority = message_priority::sync);
 
             void close_connection();
 
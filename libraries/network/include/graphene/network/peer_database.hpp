@@ -53,9 +53,16 @@ namespace graphene {
             uint32_t number_of_failed_connection_attempts;
             fc::optional<fc::exception> last_error;
 
+            /// measured on previous connections, they're used for ordering peers by score()
+            fc::microseconds round_trip_delay;
+            uint32_t average_throughput; /// bytes per second received from the peer
+            uint32_t total_connected_seconds;
+
             potential_peer_record() :
                     number_of_successful_connection_attempts(0),
-                    number_of_failed_connection_attempts(0) {
+                    number_of_failed_connection_attempts(0),
+                    average_throughput(0),
+                    total_connected_seconds(0) {
             }
 
             potential_peer_record(fc::ip::endpoint endpoint,
@@ -66,8 +73,24 @@ namespace graphene {
                     last_seen_time(last_seen_time),
                     last_connection_disposition(last_connection_disposition),
                     number_of_successful_connection_attempts(0),
-                    number_of_failed_connection_attempts(0) {
+                    number_of_failed_connection_attempts(0),
+                    average_throughput(0),
+                    total_connected_seconds(0) {
             }
+
+            /**
+             *  Accounts a finished (or still open) connection: its duration, the number of bytes received
+             *  and the last measured round trip delay
+             */
+            void record_connection(fc::microseconds connected_time, uint64_t bytes_received,
+                    fc::microseconds measured_round_trip_delay);
+
+            /**
+             *  Peers are tried in the order of the score: the last connection succeeded, uptime and throughput
+             *  of previous connections increase it, failed attempts and latency decrease it.
+             *  The score doesn't depend on the current time, it's used as a key of the peer database index.
+             */
+            int64_t score() const;
         };
 
         namespace detail {
@@ -107,6 +130,12 @@ namespace graphene {
 
             ~peer_database();
 
+            /**
+             *  Opens the binary database, if it doesn't exist, records are imported from the json file
+             *  with the same name (the format of old versions).
+             *  Changes are appended to the file as they're made, the file is rewritten on open and close,
+             *  and when the log of changes becomes much longer than the database.
+             */
             void open(const fc::path &databaseFilename);
 
             void close();
@@ -121,6 +150,7 @@ namespace graphene {
 
             fc::optional<potential_peer_record> lookup_entry_for_endpoint(const fc::ip::endpoint &endpointToLookup);
 
+            /// iterates from the best peers to the worst ones, see potential_peer_record::score()
             typedef detail::peer_database_iterator iterator;
 
             iterator begin() const;
@@ -137,4 +167,4 @@ namespace graphene {
 } // end namespace graphene::network
 
 FC_REFLECT_ENUM(graphene::network::potential_peer_last_connection_disposition, (never_attempted_to_connect)(last_connection_failed)(last_connection_rejected)(last_connection_handshaking_failed)(last_connection_succeeded))
-FC_REFLECT((graphene::network::potential_peer_record), (endpoint)(last_seen_time)(last_connection_disposition)(last_connection_attempt_time)(number_of_successful_connection_attempts)(number_of_failed_connection_attempts)(last_error))
+FC_REFLECT((graphene::network::potential_peer_record), (endpoint)(last_seen_time)(last_connection_disposition)(last_connection_attempt_time)(number_of_successful_connection_attempts)(number_of_failed_connection_attempts)(last_error)(round_trip_delay)(average_throughput)(total_connected_seconds))
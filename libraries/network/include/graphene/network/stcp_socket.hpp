@@ -54,6 +54,25 @@ namespace graphene {
 
             virtual size_t readsome(const std::shared_ptr<char> &buf, size_t len, size_t offset);
 
+            /**
+             *  Decrypts data read directly from get_socket(), it continues the stream of readsome()
+             *  calls, so it must be called in the order of reading. The length must be a multiple of 16.
+             *  The ciphertext and the plaintext can be the same buffer.
+             */
+            void decrypt(const char *ciphertext, size_t len, char *plaintext);
+
+            /**
+             *  Reads exactly len bytes into the buffer and decrypts them in place, without copying
+             *  through the internal buffer. The length must be a multiple of 16.
+             */
+            void read_in_place(char *buffer, size_t len);
+
+            /**
+             *  Encrypts the buffer in place and writes it with one call to the socket, the content
+             *  of the buffer is the ciphertext after that. The length must be a multiple of 16.
+             */
+            void write_in_place(char *buffer, size_t len);
+
             virtual bool eof() const;
 
             virtual size_t writesome(const char *buffer, size_t len);
@@ -82,6 +101,7 @@ namespace graphene {
             fc::array<char, 8> _buf;
             //uint32_t             _buf_len;
             fc::tcp_socket _sock;
+            // AES-256-CBC of OpenSSL EVP, it uses AES-NI on CPUs which support it
             fc::aes_encoder _send_aes;
             fc::aes_decoder _recv_aes;
             std::shared_ptr<char> _read_buffer;
@@ -0,0 +1,88 @@
+#include <graphene/network/io_thread_pool.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <condition_variable>
+#include <mutex>
+
+namespace graphene {
+    namespace network {
+
+        io_thread_pool &io_thread_pool::instance() {
+            static io_thread_pool pool;
+            return pool;
+        }
+
+        void io_thread_pool::start(uint32_t thread_count) {
+            stop();
+            for (uint32_t i = 0; i < thread_count; ++i) {
+                _threads.emplace_back(new fc::thread("p2p io " + std::to_string(i)));
+            }
+            if (thread_count) {
+                ilog("Started ${n} p2p IO threads", ("n", thread_count));
+            }
+        }
+
+        void io_thread_pool::stop() {
+            for (auto &t : _threads) {
+                t->quit();
+            }
+            _threads.clear();
+        }
+
+        void io_thread_pool::run(const std::function<void()> &f) {
+            if (_threads.empty()) {
+                f();
+                return;
+            }
+
+            // the function works with data of the calling fiber, so the fiber can't leave while it runs,
+            // even if it's canceled: a queued task is abandoned, a running one is waited for
+            struct task_state {
+                std::mutex mutex;
+                std::condition_variable finished_condition;
+                bool started = false;
+                bool finished = false;
+                bool abandoned = false;
+            };
+            auto state = std::make_shared<task_state>();
+
+            auto &t = *_threads[_next_thread++ % _threads.size()];
+            auto result = t.async([&f, state]() {
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (state->abandoned) {
+                        return;
+                    }
+                    state->started = true;
+                }
+                auto finish = [&]() {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->finished = true;
+                    state->finished_condition.notify_all();
+                };
+                try {
+                    f();
+                } catch (...) {
+                    finish();
+                    throw;
+                }
+                finish();
+            }, "p2p io");
+
+            try {
+                result.wait();
+            } catch (...) {
+                // blocks the thread, but no longer than processing of one message
+                std::unique_lock<std::mutex> lock(state->mutex);
+                if (state->started) {
+                    state->finished_condition.wait(lock, [&]() { return state->finished; });
+                } else {
+                    state->abandoned = true;
+                }
+                throw;
+            }
+        }
+
+    }
+} // graphene::network
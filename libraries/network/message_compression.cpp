@@ -0,0 +1,86 @@
+#include <graphene/network/message_compression.hpp>
+#include <graphene/network/core_messages.hpp>
+#include <graphene/network/config.hpp>
+
+#include <zlib.h>
+
+namespace graphene {
+    namespace network {
+
+        fc::variant_object compression_stats::to_variant_object() const {
+            fc::mutable_variant_object result;
+            result["messages_compressed"] = messages_compressed;
+            result["bytes_before_compression"] = bytes_before_compression;
+            result["bytes_after_compression"] = bytes_after_compression;
+            result["compression_ratio"] = bytes_before_compression
+                    ? double(bytes_after_compression) / bytes_before_compression : 1.0;
+            result["compression_time_us"] = compression_time.count();
+
+            result["messages_decompressed"] = messages_decompressed;
+            result["bytes_before_decompression"] = bytes_before_decompression;
+            result["bytes_after_decompression"] = bytes_after_decompression;
+            result["decompression_ratio"] = bytes_after_decompression
+                    ? double(bytes_before_decompression) / bytes_after_decompression : 1.0;
+            result["decompression_time_us"] = decompression_time.count();
+            return result;
+        }
+
+        bool is_compressible_message(const message &m) {
+            if (m.size < GRAPHENE_NET_COMPRESSION_MIN_MESSAGE_SIZE) {
+                return false;
+            }
+            switch (m.msg_type) {
+                case block_message_type:
+                case blockchain_item_ids_inventory_message_type:
+                case block_transactions_message_type:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        bool compress_message(const message &m, message &compressed) {
+            compressed_message wrapper;
+            wrapper.msg_type = m.msg_type;
+            wrapper.size = m.size;
+
+            // the fastest level, the bottleneck of seed nodes is bandwidth, but CPU time is spent per peer
+            uLongf compressed_size = compressBound(m.size);
+            wrapper.data.resize(compressed_size);
+            int status = compress2(
+                    reinterpret_cast<Bytef *>(wrapper.data.data()), &compressed_size,
+                    reinterpret_cast<const Bytef *>(m.data.data()), m.size, Z_BEST_SPEED);
+            if (status != Z_OK || compressed_size >= m.size) {
+                return false;
+            }
+            wrapper.data.resize(compressed_size);
+
+            compressed.msg_type = compressed_message::type;
+            compressed.data = fc::raw::pack(wrapper);
+            compressed.size = (uint32_t)compressed.data.size();
+            compressed.data_hash.reset();
+            return compressed.size < m.size;
+        }
+
+        void decompress_message(const message &m, message &original) {
+            auto wrapper = m.as<compressed_message>();
+            FC_ASSERT(wrapper.size <= MAX_MESSAGE_SIZE,
+                    "Compressed message is too large", ("size", wrapper.size));
+            FC_ASSERT(wrapper.msg_type != compressed_message_type,
+                    "Compressed message can't contain another compressed message");
+
+            original.msg_type = wrapper.msg_type;
+            original.size = wrapper.size;
+            original.data.resize(wrapper.size);
+            original.data_hash.reset();
+
+            uLongf size = wrapper.size;
+            int status = uncompress(
+                    reinterpret_cast<Bytef *>(original.data.data()), &size,
+                    reinterpret_cast<const Bytef *>(wrapper.data.data()), wrapper.data.size());
+            FC_ASSERT(status == Z_OK && size == wrapper.size,
+                    "Unable to decompress message", ("status", status)("size", size)("expected", wrapper.size));
+        }
+
+    }
+} // graphene::network
@@ -28,6 +28,7 @@
 
 #include <graphene/network/message_oriented_connection.hpp>
 #include <graphene/network/stcp_socket.hpp>
+#include <graphene/network/io_thread_pool.hpp>
 #include <graphene/network/config.hpp>
 
 #ifdef DEFAULT_LOGGER
@@ -83,6 +84,8 @@ namespace graphene {
 
                 void send_message(const message &message_to_send);
 
+                void send_messages(const std::vector<message> &messages_to_send);
+
                 void close_connection();
 
                 void destroy_connection();
@@ -161,7 +164,7 @@ namespace graphene {
                     message m;
                     while (true) {
                         char buffer[BUFFER_SIZE];
-                        _sock.read(buffer, BUFFER_SIZE);
+                        _sock.read_in_place(buffer, BUFFER_SIZE);
                         _bytes_received += BUFFER_SIZE;
                         memcpy((char *)&m, buffer, sizeof(message_header));
 
@@ -175,11 +178,26 @@ namespace graphene {
                         std::copy(
                                 buffer + sizeof(message_header),
                                 buffer + sizeof(buffer), m.data.begin());
-                        if (remaining_bytes_with_padding) {
-                            _sock.read(&m.data[LEFTOVER], remaining_bytes_with_padding);
+                        m.data_hash.reset();
+                        io_thread_pool &io_threads = io_thread_pool::instance();
+                        if (remaining_bytes_with_padding >= GRAPHENE_NET_IO_THREAD_MIN_MESSAGE_SIZE &&
+                            io_threads.is_running()) {
+                            // Large messages are read raw and decrypted in place with hashing in an IO thread,
+                            // the fiber yields meanwhile, so other connections aren't stalled
+                            _sock.get_socket().read(&m.data[LEFTOVER], remaining_bytes_with_padding);
                             _bytes_received += remaining_bytes_with_padding;
+                            io_threads.run([&]() {
+                                _sock.decrypt(&m.data[LEFTOVER], remaining_bytes_with_padding, &m.data[LEFTOVER]);
+                                m.data.resize(m.size); // truncate off the padding bytes
+                                m.data_hash = fc::ripemd160::hash(m.data.data(), (uint32_t)m.data.size());
+                            });
+                        } else {
+                            if (remaining_bytes_with_padding) {
+                                _sock.read_in_place(&m.data[LEFTOVER], remaining_bytes_with_padding);
+                                _bytes_received += remaining_bytes_with_padding;
+                            }
+                            m.data.resize(m.size); // truncate off the padding bytes
                         }
-                        m.data.resize(m.size); // truncate off the padding bytes
 
                         _last_message_received_time = fc::time_point::now();
 
@@ -234,6 +252,21 @@ namespace graphene {
                 }
             }
 
+            static size_t get_padded_size(const message &m) {
+                if (m.size > MAX_MESSAGE_SIZE)
+                    elog("Trying to send a message larger than MAX_MESSAGE_SIZE. This probably won't work...");
+                //pad the message we send to a multiple of 16 bytes
+                return 16 * ((sizeof(message_header) + m.size + 15) / 16);
+            }
+
+            static void copy_padded_message(const message &m, char *buffer, size_t size_with_padding) {
+                size_t size_of_message_and_header = sizeof(message_header) + m.size;
+                memcpy(buffer, (const char *)&m, sizeof(message_header));
+                memcpy(buffer + sizeof(message_header), m.data.data(), m.size);
+                // the padding is zeroed, so no garbage of the heap goes to the peer
+                memset(buffer + size_of_message_and_header, 0, size_with_padding - size_of_message_and_header);
+            }
+
             void message_oriented_connection_impl::send_message(const message &message_to_send) {
                 VERIFY_CORRECT_THREAD();
 #if 0 // this gets too verbose
@@ -264,24 +297,64 @@ namespace graphene {
                 } _verify_no_send_in_progress(_send_message_in_progress);
 
                 try {
-                    size_t size_of_message_and_header =
-                            sizeof(message_header) + message_to_send.size;
-                    if (message_to_send.size > MAX_MESSAGE_SIZE)
-                        elog("Trying to send a message larger than MAX_MESSAGE_SIZE. This probably won't work...");
-                    //pad the message we send to a multiple of 16 bytes
-                    size_t size_with_padding =
-                            16 * ((size_of_message_and_header + 15) / 16);
+                    size_t size_with_padding = get_padded_size(message_to_send);
                     std::unique_ptr<char[]> padded_message(new char[size_with_padding]);
-                    memcpy(padded_message.get(), (char *)&message_to_send, sizeof(message_header));
-                    memcpy(padded_message.get() +
-                           sizeof(message_header), message_to_send.data.data(), message_to_send.size);
-                    _sock.write(padded_message.get(), size_with_padding);
+                    copy_padded_message(message_to_send, padded_message.get(), size_with_padding);
+                    // the whole message is encrypted in place and written with one call
+                    _sock.write_in_place(padded_message.get(), size_with_padding);
                     _sock.flush();
                     _bytes_sent += size_with_padding;
                     _last_message_sent_time = fc::time_point::now();
                 } FC_RETHROW_EXCEPTIONS(warn, "unable to send message");
             }
 
+            void message_oriented_connection_impl::send_messages(const std::vector<message> &messages_to_send) {
+                VERIFY_CORRECT_THREAD();
+                if (messages_to_send.size() == 1) {
+                    send_message(messages_to_send.front());
+                    return;
+                }
+
+                struct verify_no_send_in_progress {
+                    bool &var;
+
+                    verify_no_send_in_progress(bool &var) : var(var) {
+                        if (var)
+                            elog("Error: two tasks are calling message_oriented_connection::send_messages() at the same time");
+                        assert(!var);
+                        var = true;
+                    }
+
+                    ~verify_no_send_in_progress() {
+                        var = false;
+                    }
+                } _verify_no_send_in_progress(_send_message_in_progress);
+
+                try {
+                    // AES-CBC continues the stream from one block to the next one, so encryption of the batch
+                    // produces the same bytes as encryption of each message, only with one pass and one write
+                    size_t total_size = 0;
+                    for (const auto &m : messages_to_send) {
+                        total_size += get_padded_size(m);
+                    }
+                    if (total_size == 0) {
+                        return;
+                    }
+
+                    std::unique_ptr<char[]> batch(new char[total_size]);
+                    size_t offset = 0;
+                    for (const auto &m : messages_to_send) {
+                        size_t size_with_padding = get_padded_size(m);
+                        copy_padded_message(m, batch.get() + offset, size_with_padding);
+                        offset += size_with_padding;
+                    }
+                    _sock.write_in_place(batch.get(), total_size);
+                    _sock.flush();
+                    _bytes_sent += total_size;
+                    _last_message_sent_time = fc::time_point::now();
+                } FC_RETHROW_EXCEPTIONS(warn, "unable to send messages", ("count", messages_to_send.size()));
+            }
+
             void message_oriented_connection_impl::close_connection() {
                 VERIFY_CORRECT_THREAD();
                 _sock.close();
@@ -368,6 +441,10 @@ namespace graphene {
             my->send_message(message_to_send);
         }
 
+        void message_oriented_connection::send_messages(const std::vector<message> &messages_to_send) {
+            my->send_messages(messages_to_send);
+        }
+
         void message_oriented_connection::close_connection() {
             my->close_connection();
         }
@@ -64,6 +64,8 @@
 #include <graphene/network/node.hpp>
 #include <graphene/network/peer_connection.hpp>
 #include <graphene/network/exceptions.hpp>
+#include <graphene/network/io_thread_pool.hpp>
+#include <graphene/network/block_propagation.hpp>
 
 #include <fc/git_revision.hpp>
 
@@ -119,6 +121,8 @@ namespace graphene {
                 };
                 struct block_clock_index {
                 };
+                struct short_transaction_id_index {
+                };
 
                 struct message_info {
                     message_hash_type message_hash;
@@ -128,6 +132,7 @@ namespace graphene {
                     // for network performance stats
                     message_propagation_data propagation_data;
                     fc::uint160_t message_contents_hash; // hash of whatever the message contains (if it's a transaction, this is the transaction id, if it's a block, it's the block_id)
+                    short_transaction_id_type short_transaction_id; // for reconstruction of compact blocks, 0 if it isn't a transaction
 
                     message_info(const message_hash_type &message_hash,
                             const message &message_body,
@@ -138,7 +143,9 @@ namespace graphene {
                             message_body(message_body),
                             block_clock_when_received(block_clock_when_received),
                             propagation_data(propagation_data),
-                            message_contents_hash(message_contents_hash) {
+                            message_contents_hash(message_contents_hash),
+                            short_transaction_id(message_body.msg_type == trx_message_type ?
+                                                 get_short_transaction_id(message_contents_hash) : 0) {
                     }
                 };
 
@@ -149,7 +156,9 @@ namespace graphene {
                                         bmi::ordered_non_unique<bmi::tag<message_contents_hash_index>,
                                                 bmi::member<message_info, fc::uint160_t, &message_info::message_contents_hash>>,
                                         bmi::ordered_non_unique<bmi::tag<block_clock_index>,
-                                                bmi::member<message_info, uint32_t, &message_info::block_clock_when_received>>>
+                                                bmi::member<message_info, uint32_t, &message_info::block_clock_when_received>>,
+                                        bmi::hashed_non_unique<bmi::tag<short_transaction_id_index>,
+                                                bmi::member<message_info, short_transaction_id_type, &message_info::short_transaction_id>>>
                         > message_cache_container;
 
                 message_cache_container _message_cache;
@@ -170,6 +179,10 @@ namespace graphene {
 
                 message_propagation_data get_message_propagation_data(const fc::uint160_t &hash_of_message_contents_to_lookup) const;
 
+                fc::optional<message> find_message_by_contents(const fc::uint160_t &hash_of_message_contents_to_lookup) const;
+
+                fc::optional<signed_transaction> find_transaction(short_transaction_id_type short_id) const;
+
                 size_t size() const {
                     return _message_cache.size();
                 }
@@ -216,6 +229,26 @@ namespace graphene {
                 FC_THROW_EXCEPTION(fc::key_not_found_exception, "Requested message not in cache");
             }
 
+            fc::optional<message> blockchain_tied_message_cache::find_message_by_contents(const fc::uint160_t &hash_of_message_contents_to_lookup) const {
+                const auto &index = _message_cache.get<message_contents_hash_index>();
+                auto iter = index.find(hash_of_message_contents_to_lookup);
+                if (iter != index.end()) {
+                    return iter->message_body;
+                }
+                return fc::optional<message>();
+            }
+
+            fc::optional<signed_transaction> blockchain_tied_message_cache::find_transaction(short_transaction_id_type short_id) const {
+                auto range = _message_cache.get<short_transaction_id_index>().equal_range(short_id);
+                for (auto iter = range.first; iter != range.second; ++iter) {
+                    // on collisions of short ids the first one is used, the merkle root of block is checked anyway
+                    if (iter->message_body.msg_type == trx_message_type) {
+                        return iter->message_body.as<trx_message>().trx;
+                    }
+                }
+                return fc::optional<signed_transaction>();
+            }
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
             // This specifies configuration info for the local node.  It's stored as JSON
@@ -429,7 +462,7 @@ namespace graphene {
                 std::unique_ptr<statistics_gathering_node_delegate_wrapper> _delegate;
 
 #define NODE_CONFIGURATION_FILENAME      "node_config.json"
-#define POTENTIAL_PEER_DATABASE_FILENAME "peers.json"
+#define POTENTIAL_PEER_DATABASE_FILENAME "peers.dat"
                 fc::path _node_configuration_directory;
                 node_configuration _node_configuration;
 
@@ -494,6 +527,9 @@ namespace graphene {
                 fc::promise<void>::ptr _retrigger_advertise_inventory_loop_promise;
                 fc::future<void> _advertise_inventory_loop_done;
                 std::unordered_set<item_id> _new_inventory; /// list of items we have received but not yet advertised to our peers
+                bool _new_inventory_has_blocks; /// blocks in _new_inventory end the aggregation window at once
+                bool _aggregating_inventory; /// the loop waits for more transactions before advertising them
+                fc::microseconds _transaction_aggregation_window;
                 // @}
 
                 fc::future<void> _terminate_inactive_connections_loop_done;
@@ -544,6 +580,7 @@ namespace graphene {
                 std::vector<uint32_t> _hard_fork_block_numbers; /// list of all block numbers where there are hard forks
 
                 blockchain_tied_message_cache _message_cache; /// cache message we have received and might be required to provide to other peers via inventory requests
+                block_propagation_tracker _block_propagation; /// stages of new blocks, which are passing through the node
 
                 fc::rate_limiting_group _rate_limiter;
 
@@ -591,6 +628,15 @@ namespace graphene {
                 unsigned _maximum_number_of_blocks_to_handle_at_one_time;
                 unsigned _maximum_number_of_sync_blocks_to_prefetch;
                 unsigned _maximum_blocks_per_peer_during_syncing;
+                bool _compression_enabled; /// large blocks are compressed for peers, which support it
+                send_queue_budget_ptr _send_queue_budget; /// memory of send queues of all peers
+
+                /// the rate of applying sync blocks by the delegate, the prefetch window follows it
+                /// @{
+                double _sync_blocks_applied_per_second;
+                fc::time_point _sync_apply_rate_period_start;
+                uint32_t _sync_blocks_applied_in_period;
+                /// @}
 
                 std::list<fc::future<void>> _handle_message_calls_in_progress;
                 std::set<message_hash_type> _message_ids_currently_being_processed;
@@ -611,6 +657,16 @@ namespace graphene {
 
                 void request_sync_items_from_peer(const peer_connection_ptr &peer, const std::vector<item_hash_t> &items_to_request);
 
+                unsigned get_sync_request_size(const peer_connection_ptr &peer) const;
+
+                unsigned get_sync_prefetch_window() const;
+
+                void update_sync_apply_rate();
+
+                void update_peer_sync_throughput(peer_connection *peer);
+
+                graphene::network::block_message unpack_block_message(const message &message_to_unpack);
+
                 void fetch_sync_items_loop();
 
                 void trigger_fetch_sync_items_loop();
@@ -715,8 +771,27 @@ namespace graphene {
                 void on_get_current_connections_reply_message(peer_connection *originating_peer,
                         const get_current_connections_reply_message &get_current_connections_reply_message_received);
 
+                message make_compact_block_message(peer_connection *peer, const graphene::network::block_message &block);
+
+                void on_compact_block_message(peer_connection *originating_peer,
+                        const compact_block_message &compact_block_message_received);
+
+                void on_get_block_transactions_message(peer_connection *originating_peer,
+                        const get_block_transactions_message &get_block_transactions_message_received);
+
+                void on_block_transactions_message(peer_connection *originating_peer,
+                        const block_transactions_message &block_transactions_message_received);
+
+                void on_trx_batch_message(peer_connection *originating_peer,
+                        const trx_batch_message &trx_batch_message_received);
+
+                void process_reconstructed_block(peer_connection *originating_peer,
+                        peer_connection::partial_compact_block &&partial_block);
+
                 void on_connection_closed(peer_connection *originating_peer) override;
 
+                void record_connection_statistics(peer_connection *peer);
+
                 void send_sync_block_to_node_delegate(const graphene::network::block_message &block_message_to_send);
 
                 void process_backlog_of_sync_blocks();
@@ -797,6 +872,9 @@ namespace graphene {
 
                 void broadcast(const message &item_to_broadcast, const message_propagation_data &propagation_data);
 
+                void broadcast(const message &item_to_broadcast, const message_hash_type &hash_of_item_to_broadcast,
+                        const fc::uint160_t &hash_of_message_contents, const message_propagation_data &propagation_data);
+
                 void broadcast(const message &item_to_broadcast);
 
                 void sync_from(const item_id &current_head_block, const std::vector<uint32_t> &hard_fork_block_numbers);
@@ -813,6 +891,8 @@ namespace graphene {
 
                 message_propagation_data get_block_propagation_data(const graphene::network::block_id_type &block_id);
 
+                fc::variant_object get_block_propagation_stats() const;
+
                 node_id_t get_node_id() const;
 
                 void set_allowed_peers(const std::vector<node_id_t> &allowed_peers);
@@ -827,6 +907,8 @@ namespace graphene {
 
                 message get_message_for_item(const item_id &item) override;
 
+                send_queue_budget_ptr get_send_queue_budget() override;
+
                 fc::variant_object network_get_info() const;
 
                 fc::variant_object network_get_usage_stats() const;
@@ -864,7 +946,7 @@ namespace graphene {
 #endif
 
 #define MAXIMUM_NUMBER_OF_BLOCKS_TO_HANDLE_AT_ONE_TIME 200
-#define MAXIMUM_NUMBER_OF_BLOCKS_TO_PREFETCH (10 * MAXIMUM_NUMBER_OF_BLOCKS_TO_HANDLE_AT_ONE_TIME)
+#define MAXIMUM_NUMBER_OF_BLOCKS_TO_PREFETCH (50 * MAXIMUM_NUMBER_OF_BLOCKS_TO_HANDLE_AT_ONE_TIME)
 
             node_impl::node_impl(const std::string &user_agent) :
 #ifdef P2P_IN_DEDICATED_THREAD
@@ -877,6 +959,9 @@ namespace graphene {
                     _suspend_fetching_sync_blocks(false),
                     _items_to_fetch_updated(false),
                     _items_to_fetch_sequence_counter(0),
+                    _new_inventory_has_blocks(false),
+                    _aggregating_inventory(false),
+                    _transaction_aggregation_window(fc::milliseconds(GRAPHENE_NET_TRANSACTION_AGGREGATION_WINDOW_MS)),
                     _recent_block_interval_in_seconds(CHAIN_BLOCK_INTERVAL),
                     _user_agent_string(user_agent),
                     _desired_number_of_connections(GRAPHENE_NET_DEFAULT_DESIRED_CONNECTIONS),
@@ -899,7 +984,11 @@ namespace graphene {
                     _node_is_shutting_down(false),
                     _maximum_number_of_blocks_to_handle_at_one_time(MAXIMUM_NUMBER_OF_BLOCKS_TO_HANDLE_AT_ONE_TIME),
                     _maximum_number_of_sync_blocks_to_prefetch(MAXIMUM_NUMBER_OF_BLOCKS_TO_PREFETCH),
-                    _maximum_blocks_per_peer_during_syncing(GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING) {
+                    _maximum_blocks_per_peer_during_syncing(GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING),
+                    _compression_enabled(true),
+                    _send_queue_budget(std::make_shared<send_queue_budget>()),
+                    _sync_blocks_applied_per_second(0),
+                    _sync_blocks_applied_in_period(0) {
                 _rate_limiter.set_actual_rate_time_constant(fc::seconds(2));
                 fc::rand_pseudo_bytes(&_node_id.data[0], (int)_node_id.size());
             }
@@ -979,10 +1068,11 @@ namespace graphene {
                             bool initiated_connection_this_pass = false;
                             _potential_peer_database_updated = false;
 
+                            // the database is ordered by score, so the best peers are tried first,
+                            // candidates are collected before connecting, because connecting changes their score
+                            std::vector<fc::ip::endpoint> candidates;
                             for (peer_database::iterator iter = _potential_peer_db.begin();
-                                 iter != _potential_peer_db.end() &&
-                                 is_wanting_new_connections();
-                                 ++iter) {
+                                 iter != _potential_peer_db.end(); ++iter) {
                                 fc::microseconds delay_until_retry = fc::seconds(
                                         (iter->number_of_failed_connection_attempts +
                                          1) * _peer_connection_retry_timeout);
@@ -997,7 +1087,16 @@ namespace graphene {
                                      (fc::time_point::now() -
                                       iter->last_connection_attempt_time) >
                                      delay_until_retry)) {
-                                    connect_to_endpoint(iter->endpoint);
+                                    candidates.push_back(iter->endpoint);
+                                }
+                            }
+
+                            for (const fc::ip::endpoint &candidate : candidates) {
+                                if (!is_wanting_new_connections()) {
+                                    break;
+                                }
+                                if (!is_connection_to_endpoint_in_progress(candidate)) {
+                                    connect_to_endpoint(candidate);
                                     initiated_connection_this_pass = true;
                                 }
                             }
@@ -1087,9 +1186,91 @@ namespace graphene {
                     peer->last_sync_item_received_time = fc::time_point::now();
                     peer->sync_items_requested_from_peer.insert(item_to_request);
                 }
+                peer->sync_items_request_time = fc::time_point::now();
+                peer->sync_items_request_size = (uint32_t)items_to_request.size();
                 peer->send_message(fetch_items_message(graphene::network::block_message_type, items_to_request));
             }
 
+            unsigned node_impl::get_sync_request_size(const peer_connection_ptr &peer) const {
+                VERIFY_CORRECT_THREAD();
+                unsigned min_size = std::min<unsigned>(GRAPHENE_NET_MIN_BLOCKS_PER_PEER_DURING_SYNCING, _maximum_blocks_per_peer_during_syncing);
+                if (peer->sync_items_per_second == 0) {
+                    // the first batch is small to measure the peer before giving it a big part of the chain
+                    return std::max(min_size, _maximum_blocks_per_peer_during_syncing / 4);
+                }
+                auto size = (unsigned)(peer->sync_items_per_second * GRAPHENE_NET_SYNC_REQUEST_DURATION_SEC);
+                return std::min(_maximum_blocks_per_peer_during_syncing, std::max(min_size, size));
+            }
+
+            void node_impl::update_peer_sync_throughput(peer_connection *peer) {
+                VERIFY_CORRECT_THREAD();
+                if (!peer->sync_items_requested_from_peer.empty() || peer->sync_items_request_size == 0) {
+                    return;
+                }
+
+                // the whole batch is received
+                fc::microseconds elapsed = fc::time_point::now() - peer->sync_items_request_time;
+                double rate = peer->sync_items_request_size * 1000000.0 / std::max<int64_t>(elapsed.count(), 1000);
+                peer->sync_items_per_second = peer->sync_items_per_second == 0
+                                              ? rate
+                                              : 0.7 * peer->sync_items_per_second + 0.3 * rate;
+                peer->sync_items_request_size = 0;
+                dlog("peer ${endpoint} sends ${rate} sync blocks per second",
+                        ("endpoint", peer->get_remote_endpoint())("rate", peer->sync_items_per_second));
+            }
+
+            unsigned node_impl::get_sync_prefetch_window() const {
+                VERIFY_CORRECT_THREAD();
+                if (_sync_blocks_applied_per_second == 0) {
+                    return _maximum_number_of_sync_blocks_to_prefetch;
+                }
+                auto window = (unsigned)(_sync_blocks_applied_per_second * GRAPHENE_NET_SYNC_PREFETCH_DURATION_SEC);
+                return std::min(_maximum_number_of_sync_blocks_to_prefetch,
+                        std::max(window, _maximum_number_of_blocks_to_handle_at_one_time));
+            }
+
+            void node_impl::update_sync_apply_rate() {
+                VERIFY_CORRECT_THREAD();
+                fc::time_point now = fc::time_point::now();
+                fc::microseconds elapsed = now - _sync_apply_rate_period_start;
+                if (elapsed > fc::seconds(10)) {
+                    // sync was paused, the rate is measured again from this block
+                    _sync_apply_rate_period_start = now;
+                    _sync_blocks_applied_in_period = 1;
+                    return;
+                }
+
+                ++_sync_blocks_applied_in_period;
+                if (elapsed >= fc::seconds(1)) {
+                    double rate = _sync_blocks_applied_in_period * 1000000.0 / elapsed.count();
+                    _sync_blocks_applied_per_second = _sync_blocks_applied_per_second == 0
+                                                      ? rate
+                                                      : 0.7 * _sync_blocks_applied_per_second + 0.3 * rate;
+                    _sync_apply_rate_period_start = now;
+                    _sync_blocks_applied_in_period = 0;
+                }
+            }
+
+            graphene::network::block_message node_impl::unpack_block_message(const message &message_to_unpack) {
+                VERIFY_CORRECT_THREAD();
+                // deserialization, the merkle root and the signature recovery don't depend on the state of chain,
+                // so they're done in IO threads while blocks from other peers are received and applied
+                graphene::network::block_message result;
+                io_thread_pool::instance().run([&]() {
+                    result = message_to_unpack.as<graphene::network::block_message>();
+                    result.deserialized_time = fc::time_point::now();
+                    result.merkle_root_checked =
+                            result.block.calculate_merkle_root() == result.block.transaction_merkle_root;
+                    try {
+                        result.signee = result.block.signee();
+                    } catch (const fc::exception &) {
+                        // the delegate rejects the block with the invalid signature
+                    }
+                    result.validated_time = fc::time_point::now();
+                });
+                return result;
+            }
+
             void node_impl::fetch_sync_items_loop() {
                 VERIFY_CORRECT_THREAD();
                 while (!_fetch_sync_items_loop_done.canceled()) {
@@ -1128,7 +1309,7 @@ namespace graphene {
                                                 sync_item_requests_to_send[peer].push_back(item_to_potentially_request);
                                                 sync_items_to_request.insert(item_to_potentially_request);
                                                 if (sync_item_requests_to_send[peer].size() >=
-                                                    _maximum_blocks_per_peer_during_syncing) {
+                                                    get_sync_request_size(peer)) {
                                                         break;
                                                 }
                                             }
@@ -1237,9 +1418,12 @@ namespace graphene {
                                  peer_iter !=
                                  items_by_peer.get<requested_item_count_index>().end(); ++peer_iter) {
                                 const peer_connection_ptr &peer = peer_iter->peer;
-                                // if they have the item and we haven't already decided to ask them for too many other items
-                                if (peer_iter->item_ids.size() <
-                                    GRAPHENE_NET_MAX_ITEMS_PER_PEER_DURING_NORMAL_OPERATION &&
+                                // if they have the item and we haven't already decided to ask them for too many other items,
+                                // transactions are requested in batches
+                                size_t max_items_per_peer = item_iter->item.item_type == graphene::network::trx_message_type
+                                        ? GRAPHENE_NET_MAX_TRX_PER_PEER_DURING_NORMAL_OPERATION
+                                        : GRAPHENE_NET_MAX_ITEMS_PER_PEER_DURING_NORMAL_OPERATION;
+                                if (peer_iter->item_ids.size() < max_items_per_peer &&
                                     peer->inventory_peer_advertised_to_us.find(item_iter->item) !=
                                     peer->inventory_peer_advertised_to_us.end()) {
                                     if (item_iter->item.item_type ==
@@ -1285,6 +1469,7 @@ namespace graphene {
                                         fc_dlog(fc::logger::get("sync"),
                                                 "requesting a block from peer ${endpoint} (message_id is ${id})",
                                                 ("endpoint", peer_and_items.peer->get_remote_endpoint())("id", id));
+                                        _block_propagation.on_requested(id, peer_and_items.peer->get_remote_endpoint());
                                     }
                             }
 
@@ -1326,10 +1511,26 @@ namespace graphene {
             void node_impl::advertise_inventory_loop() {
                 VERIFY_CORRECT_THREAD();
                 while (!_advertise_inventory_loop_done.canceled()) {
+                    // new transactions are collected during the aggregation window, so they're advertised
+                    // with a few inventory messages instead of one per transaction, a block ends the window
+                    if (!_new_inventory.empty() && !_new_inventory_has_blocks &&
+                        _transaction_aggregation_window > fc::microseconds(0)) {
+                        _aggregating_inventory = true;
+                        _retrigger_advertise_inventory_loop_promise = fc::promise<void>::ptr(new fc::promise<void>("graphene::network::retrigger_advertise_inventory_loop"));
+                        try {
+                            _retrigger_advertise_inventory_loop_promise->wait(_transaction_aggregation_window);
+                        }
+                        catch (const fc::timeout_exception &) {
+                        }
+                        _retrigger_advertise_inventory_loop_promise.reset();
+                        _aggregating_inventory = false;
+                    }
+
                     dlog("beginning an iteration of advertise inventory");
                     // swap inventory into local variable, clearing the node's copy
                     std::unordered_set<item_id> inventory_to_advertise;
                     inventory_to_advertise.swap(_new_inventory);
+                    _new_inventory_has_blocks = false;
 
                     // process all inventory to advertise and construct the inventory messages we'll send
                     // first, then send them all in a batch (to avoid any fiber interruption points while
@@ -1376,6 +1577,12 @@ namespace graphene {
                         peer->clear_old_inventory();
                     }
 
+                    for (const item_id &item_to_advertise : inventory_to_advertise) {
+                        if (item_to_advertise.item_type == block_message_type) {
+                            _block_propagation.on_advertised(item_to_advertise.item_hash);
+                        }
+                    }
+
                     for (auto iter = inventory_messages_to_send.begin();
                          iter != inventory_messages_to_send.end(); ++iter) {
                              iter->first->send_message(iter->second);
@@ -1392,7 +1599,9 @@ namespace graphene {
 
             void node_impl::trigger_advertise_inventory_loop() {
                 VERIFY_CORRECT_THREAD();
-                if (_retrigger_advertise_inventory_loop_promise) {
+                // during the aggregation window new transactions don't wake up the loop
+                if (_retrigger_advertise_inventory_loop_promise &&
+                    (!_aggregating_inventory || _new_inventory_has_blocks || _advertise_inventory_loop_done.canceled())) {
                     _retrigger_advertise_inventory_loop_promise->set_value();
                 }
             }
@@ -1923,6 +2132,7 @@ namespace graphene {
                         on_closing_connection_message(originating_peer, received_message.as<closing_connection_message>());
                         break;
                     case core_message_type_enum::block_message_type:
+                        _block_propagation.on_received(message_hash, originating_peer->get_remote_endpoint(), fc::time_point::now());
                         process_block_message(originating_peer, received_message, message_hash);
                         break;
                     case core_message_type_enum::current_time_request_message_type:
@@ -1943,6 +2153,18 @@ namespace graphene {
                     case core_message_type_enum::get_current_connections_reply_message_type:
                         on_get_current_connections_reply_message(originating_peer, received_message.as<get_current_connections_reply_message>());
                         break;
+                    case core_message_type_enum::compact_block_message_type:
+                        on_compact_block_message(originating_peer, received_message.as<compact_block_message>());
+                        break;
+                    case core_message_type_enum::get_block_transactions_message_type:
+                        on_get_block_transactions_message(originating_peer, received_message.as<get_block_transactions_message>());
+                        break;
+                    case core_message_type_enum::block_transactions_message_type:
+                        on_block_transactions_message(originating_peer, received_message.as<block_transactions_message>());
+                        break;
+                    case core_message_type_enum::trx_batch_message_type:
+                        on_trx_batch_message(originating_peer, received_message.as<trx_batch_message>());
+                        break;
 
                     default:
                         // ignore any message in between core_message_type_first and _last that we don't handle above
@@ -1990,6 +2212,11 @@ namespace graphene {
                 }
 
                 user_data["chain_id"] = CHAIN_ID;
+                user_data["compact_blocks"] = true;
+                if (_compression_enabled) {
+                    user_data["compression"] = "zlib";
+                }
+                user_data["trx_batches"] = true;
 
                 return user_data;
             }
@@ -2024,6 +2251,16 @@ namespace graphene {
                 if (user_data.contains("chain_id")) {
                     originating_peer->chain_id = user_data["chain_id"].as<graphene::protocol::chain_id_type>();
                 }
+                if (user_data.contains("compact_blocks")) {
+                    originating_peer->supports_compact_blocks = user_data["compact_blocks"].as_bool();
+                }
+                if (user_data.contains("trx_batches")) {
+                    originating_peer->supports_trx_batches = user_data["trx_batches"].as_bool();
+                }
+                if (user_data.contains("compression")) {
+                    originating_peer->supports_compression = _compression_enabled &&
+                            user_data["compression"].as_string() == "zlib";
+                }
             }
 
             void node_impl::on_hello_message(peer_connection *originating_peer, const hello_message &hello_message_received) {
@@ -2824,9 +3061,20 @@ namespace graphene {
                 }
                 catch (fc::key_not_found_exception &) {
                 }
+                catch (const fc::canceled_exception &) {
+                    throw;
+                }
+                catch (const fc::exception &e) {
+                    // blocks of sync replies are loaded at sending, the block can be popped in the meantime
+                    wlog("Unable to get item ${item} to send: ${e}", ("item", item)("e", e.to_string()));
+                }
                 return item_not_available_message(item);
             }
 
+            send_queue_budget_ptr node_impl::get_send_queue_budget() {
+                return _send_queue_budget;
+            }
+
             void node_impl::on_fetch_items_message(peer_connection *originating_peer, const fetch_items_message &fetch_items_message_received) {
                 VERIFY_CORRECT_THREAD();
                 dlog("received items request for ids ${ids} of type ${type} from peer ${endpoint}",
@@ -2834,61 +3082,118 @@ namespace graphene {
                                 ("type", fetch_items_message_received.item_type)
                                 ("endpoint", originating_peer->get_remote_endpoint()));
 
-                fc::optional<message> last_block_message_sent;
+                fc::optional<item_hash_t> last_block_sent;
 
-                std::list<message> reply_messages;
+                // Blocks are queued as ids and generated at sending: blocks of the cache go before other
+                // messages, blocks of sync replies are loaded from the block log after all other messages
+                struct reply_item {
+                    fc::optional<message> message_to_send;
+                    item_id item_to_send;
+                    message_priority priority; // of items, messages are classified by their types
+                };
+                std::list<reply_item> replies;
                 for (const item_hash_t &item_hash : fetch_items_message_received.items_to_fetch) {
+                    item_id item_to_fetch(fetch_items_message_received.item_type, item_hash);
                     try {
                         message requested_message = _message_cache.get_message(item_hash);
                         dlog("received item request for item ${id} from peer ${endpoint}, returning the item from my message cache",
                                 ("endpoint", originating_peer->get_remote_endpoint())
                                         ("id", requested_message.id()));
-                        reply_messages.push_back(requested_message);
                         if (fetch_items_message_received.item_type ==
                             block_message_type) {
-                                last_block_message_sent = requested_message;
+                                last_block_sent = item_hash;
+                                // blocks are in the cache only during normal operation, when the peer
+                                // has most of their transactions
+                                if (originating_peer->supports_compact_blocks) {
+                                    replies.push_back(reply_item{message(make_compact_block_message(originating_peer,
+                                            requested_message.as<graphene::network::block_message>())), item_to_fetch,
+                                            message_priority::block});
+                                } else {
+                                    replies.push_back(reply_item{fc::optional<message>(), item_to_fetch, message_priority::block});
+                                }
+                                continue;
                         }
+                        replies.push_back(reply_item{requested_message, item_to_fetch, get_message_priority(requested_message)});
                         continue;
                     }
                     catch (fc::key_not_found_exception &) {
                         // it wasn't in our local cache, that's ok ask the client
                     }
 
-                    item_id item_to_fetch(fetch_items_message_received.item_type, item_hash);
+                    if (fetch_items_message_received.item_type == block_message_type) {
+                        if (_delegate->has_item(item_to_fetch)) {
+                            dlog("received item request from peer ${endpoint}, queueing the block ${id} from delegate",
+                                    ("id", item_hash)("endpoint", originating_peer->get_remote_endpoint()));
+                            replies.push_back(reply_item{fc::optional<message>(), item_to_fetch, message_priority::sync});
+                            last_block_sent = item_hash;
+                        } else {
+                            replies.push_back(reply_item{message(item_not_available_message(item_to_fetch)), item_to_fetch,
+                                    message_priority::block});
+                            dlog("received item request from peer ${endpoint} but we don't have it",
+                                    ("endpoint", originating_peer->get_remote_endpoint()));
+                        }
+                        continue;
+                    }
+
                     try {
                         message requested_message = _delegate->get_item(item_to_fetch);
                         dlog("received item request from peer ${endpoint}, returning the item from delegate with id ${id} size ${size}",
                                 ("id", requested_message.id())
                                         ("size", requested_message.size)
                                         ("endpoint", originating_peer->get_remote_endpoint()));
-                        reply_messages.push_back(requested_message);
-                        if (fetch_items_message_received.item_type ==
-                            block_message_type) {
-                                last_block_message_sent = requested_message;
-                        }
+                        replies.push_back(reply_item{requested_message, item_to_fetch, get_message_priority(requested_message)});
                         continue;
                     }
                     catch (fc::key_not_found_exception &) {
-                        reply_messages.push_back(item_not_available_message(item_to_fetch));
+                        replies.push_back(reply_item{message(item_not_available_message(item_to_fetch)), item_to_fetch,
+                                message_priority::transaction});
                         dlog("received item request from peer ${endpoint} but we don't have it",
                                 ("endpoint", originating_peer->get_remote_endpoint()));
                     }
                 }
 
                 // if we sent them a block, update our record of the last block they've seen accordingly
-                if (last_block_message_sent) {
-                    graphene::network::block_message block = last_block_message_sent->as<graphene::network::block_message>();
-                    originating_peer->last_block_delegate_has_seen = block.block_id;
-                    originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(block.block_id);
-                }
+                if (last_block_sent) {
+                    originating_peer->last_block_delegate_has_seen = *last_block_sent;
+                    originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(*last_block_sent);
+                }
+
+                // transactions go to peers, which support it, in batches
+                std::vector<const message *> transactions_to_send;
+                size_t transactions_size = 0;
+                auto send_transactions = [&]() {
+                    if (transactions_to_send.size() == 1) {
+                        originating_peer->send_message(*transactions_to_send.front());
+                    } else if (transactions_to_send.size() > 1) {
+                        trx_batch_message batch;
+                        batch.trx_messages.reserve(transactions_to_send.size());
+                        for (const message *transaction : transactions_to_send) {
+                            batch.trx_messages.push_back(transaction->data);
+                        }
+                        originating_peer->send_message(batch);
+                    }
+                    transactions_to_send.clear();
+                    transactions_size = 0;
+                };
 
-                for (const message &reply : reply_messages) {
-                    if (reply.msg_type == block_message_type) {
-                        originating_peer->send_item(item_id(block_message_type, reply.as<graphene::network::block_message>().block_id));
+                for (const reply_item &reply : replies) {
+                    if (reply.message_to_send && reply.message_to_send->msg_type == trx_message_type &&
+                        originating_peer->supports_trx_batches) {
+                        if (transactions_size + reply.message_to_send->size > GRAPHENE_NET_MAX_TRX_BATCH_SIZE) {
+                            send_transactions();
+                        }
+                        transactions_to_send.push_back(&*reply.message_to_send);
+                        transactions_size += reply.message_to_send->size;
+                        continue;
+                    }
+                    send_transactions();
+                    if (reply.message_to_send) {
+                        originating_peer->send_message(*reply.message_to_send);
                     } else {
-                        originating_peer->send_message(reply);
+                        originating_peer->send_item(reply.item_to_send, reply.priority);
                     }
                 }
+                send_transactions();
             }
 
             void node_impl::on_item_not_available_message(peer_connection *originating_peer, const item_not_available_message &item_not_available_message_received) {
@@ -2936,6 +3241,9 @@ namespace graphene {
                 dlog("received inventory of ${count} items from peer ${endpoint}",
                         ("count", item_ids_inventory_message_received.item_hashes_available.size())("endpoint", originating_peer->get_remote_endpoint()));
                 for (const item_hash_t &item_hash : item_ids_inventory_message_received.item_hashes_available) {
+                    if (item_ids_inventory_message_received.item_type == block_message_type) {
+                        _block_propagation.on_inventory(item_hash, originating_peer->get_remote_endpoint());
+                    }
                     if (_message_ids_currently_being_processed.find(item_hash) !=
                         _message_ids_currently_being_processed.end()) {
                             // we're in the middle of processing this item, no need to fetch it again
@@ -3057,13 +3365,8 @@ namespace graphene {
                     _active_connections.end()) {
                     _active_connections.erase(originating_peer_ptr);
 
-                    if (inbound_endpoint &&
-                        originating_peer_ptr->get_remote_endpoint()) {
-                        fc::optional<potential_peer_record> updated_peer_record = _potential_peer_db.lookup_entry_for_endpoint(*inbound_endpoint);
-                        if (updated_peer_record) {
-                            updated_peer_record->last_seen_time = fc::time_point::now();
-                            _potential_peer_db.update_entry(*updated_peer_record);
-                        }
+                    if (originating_peer_ptr->get_remote_endpoint()) {
+                        record_connection_statistics(originating_peer);
                     }
                 }
 
@@ -3114,6 +3417,21 @@ namespace graphene {
                 schedule_peer_for_deletion(originating_peer_ptr);
             }
 
+            void node_impl::record_connection_statistics(peer_connection *peer) {
+                VERIFY_CORRECT_THREAD();
+                fc::optional<fc::ip::endpoint> inbound_endpoint = peer->get_endpoint_for_connecting();
+                if (!inbound_endpoint) {
+                    return;
+                }
+                fc::optional<potential_peer_record> updated_peer_record = _potential_peer_db.lookup_entry_for_endpoint(*inbound_endpoint);
+                if (updated_peer_record) {
+                    updated_peer_record->last_seen_time = fc::time_point::now();
+                    updated_peer_record->record_connection(fc::time_point::now() - peer->get_connection_time(),
+                            peer->get_total_bytes_received(), peer->round_trip_delay);
+                    _potential_peer_db.update_entry(*updated_peer_record);
+                }
+            }
+
             void node_impl::send_sync_block_to_node_delegate(const graphene::network::block_message &block_message_to_send) {
                 dlog("in send_sync_block_to_node_delegate()");
                 bool client_accepted_block = false;
@@ -3132,6 +3450,7 @@ namespace graphene {
                             ("num", block_message_to_send.block.block_num())
                                     ("id", block_message_to_send.block_id));
                     _most_recent_blocks_accepted.push_back(block_message_to_send.block_id);
+                    update_sync_apply_rate();
 
                     client_accepted_block = true;
                 }
@@ -3387,7 +3706,7 @@ namespace graphene {
                         //ulog("stopping processing sync block backlog because we have ${count} blocks in progress, total on hand: ${received}",
                         //     ("count", _handle_message_calls_in_progress.size())("received", _received_sync_items.size()));
                         if (_received_sync_items.size() >=
-                            _maximum_number_of_sync_blocks_to_prefetch) {
+                            get_sync_prefetch_window()) {
                                 _suspend_fetching_sync_blocks = true;
                         }
                         break;
@@ -3451,6 +3770,7 @@ namespace graphene {
                         _delegate->handle_block(block_message_to_process, false, contained_transaction_message_ids);
                         _message_ids_currently_being_processed.erase(message_hash);
                         message_validated_time = fc::time_point::now();
+                        _block_propagation.on_applied(message_hash);
                         ilog("Successfully pushed block ${num} (id:${id})",
                                 ("num", block_message_to_process.block.block_num())
                                         ("id", block_message_to_process.block_id));
@@ -3583,7 +3903,8 @@ namespace graphene {
                 // (it's possible that we request an item during normal operation and then get kicked into sync
                 // mode before we receive and process the item.  In that case, we should process the item as a normal
                 // item to avoid confusing the sync code)
-                graphene::network::block_message block_message_to_process(message_to_process.as<graphene::network::block_message>());
+                graphene::network::block_message block_message_to_process(unpack_block_message(message_to_process));
+                _block_propagation.on_unpacked(message_hash, block_message_to_process);
                 auto item_iter = originating_peer->items_requested_from_peer.find(item_id(graphene::network::block_message_type, message_hash));
                 if (item_iter !=
                     originating_peer->items_requested_from_peer.end()) {
@@ -3600,6 +3921,7 @@ namespace graphene {
                         originating_peer->sync_items_requested_from_peer.end()) {
                         originating_peer->sync_items_requested_from_peer.erase(sync_item_iter);
                         originating_peer->last_sync_item_received_time = fc::time_point::now();
+                        update_peer_sync_throughput(originating_peer);
                         _active_sync_requests.erase(block_message_to_process.block_id);
                         process_block_during_sync(originating_peer, block_message_to_process, message_hash);
                         if (originating_peer->idle()) {
@@ -3631,6 +3953,179 @@ namespace graphene {
                 disconnect_from_peer(originating_peer, "You sent me a block that I didn't ask for", true, detailed_error);
             }
 
+            message node_impl::make_compact_block_message(peer_connection *peer, const graphene::network::block_message &block) {
+                VERIFY_CORRECT_THREAD();
+                compact_block_message compact;
+                compact.header = block.block;
+                compact.block_id = block.block_id;
+                compact.short_ids.reserve(block.block.transactions.size());
+
+                for (uint32_t i = 0; i < block.block.transactions.size(); ++i) {
+                    const auto &trx = block.block.transactions[i];
+                    compact.short_ids.push_back(get_short_transaction_id(trx.id()));
+
+                    // the peer has the transaction if one of us offered it to another
+                    item_id trx_item(trx_message_type, message(trx_message(trx)).id());
+                    if (peer->inventory_peer_advertised_to_us.find(trx_item) == peer->inventory_peer_advertised_to_us.end() &&
+                        peer->inventory_advertised_to_peer.find(trx_item) == peer->inventory_advertised_to_peer.end()) {
+                        compact.prefilled_transactions.emplace_back(i, trx);
+                    }
+                }
+
+                dlog("sending compact block ${id} to peer ${endpoint} with ${p} of ${n} transactions prefilled",
+                        ("id", block.block_id)("endpoint", peer->get_remote_endpoint())
+                                ("p", compact.prefilled_transactions.size())("n", compact.short_ids.size()));
+                return compact;
+            }
+
+            void node_impl::on_compact_block_message(peer_connection *originating_peer,
+                    const compact_block_message &compact_block_message_received) {
+                VERIFY_CORRECT_THREAD();
+                const auto &compact = compact_block_message_received;
+                const auto transaction_count = compact.short_ids.size();
+
+                // compact blocks are replies to requests of blocks, each of them can wait for transactions,
+                // so unsolicited ones would grow the memory and make us request transactions for nothing
+                size_t blocks_requested = 0;
+                for (const auto &requested_item : originating_peer->items_requested_from_peer) {
+                    if (requested_item.first.item_type == block_message_type) {
+                        ++blocks_requested;
+                    }
+                }
+                const auto partial_blocks = originating_peer->partial_compact_blocks.size();
+                if (partial_blocks >= blocks_requested ||
+                    partial_blocks >= GRAPHENE_NET_MAX_PARTIAL_COMPACT_BLOCKS_PER_PEER) {
+                    wlog("disconnecting peer ${endpoint} because it sent compact block ${id}, which I didn't request",
+                            ("endpoint", originating_peer->get_remote_endpoint())("id", compact.block_id));
+                    disconnect_from_peer(originating_peer, "You sent me a compact block I didn't ask for", true);
+                    return;
+                }
+
+                peer_connection::partial_compact_block partial_block;
+                partial_block.received_time = fc::time_point::now();
+                static_cast<signed_block_header &>(partial_block.block) = compact.header;
+                partial_block.block.transactions.resize(transaction_count);
+
+                std::vector<bool> filled(transaction_count, false);
+                for (const auto &prefilled : compact.prefilled_transactions) {
+                    FC_ASSERT(prefilled.index < transaction_count,
+                            "Prefilled transaction index ${i} is out of the block", ("i", prefilled.index));
+                    partial_block.block.transactions[prefilled.index] = prefilled.trx;
+                    filled[prefilled.index] = true;
+                }
+
+                for (uint32_t i = 0; i < transaction_count; ++i) {
+                    if (filled[i]) {
+                        continue;
+                    }
+                    auto trx = _message_cache.find_transaction(compact.short_ids[i]);
+                    if (trx) {
+                        partial_block.block.transactions[i] = std::move(*trx);
+                    } else {
+                        partial_block.missing_indexes.push_back(i);
+                    }
+                }
+
+                dlog("received compact block ${id} from peer ${endpoint}, ${m} of ${n} transactions are missing",
+                        ("id", compact.block_id)("endpoint", originating_peer->get_remote_endpoint())
+                                ("m", partial_block.missing_indexes.size())("n", transaction_count));
+
+                if (partial_block.missing_indexes.empty()) {
+                    process_reconstructed_block(originating_peer, std::move(partial_block));
+                    return;
+                }
+
+                originating_peer->send_message(get_block_transactions_message(compact.block_id, partial_block.missing_indexes));
+                originating_peer->partial_compact_blocks[compact.block_id] = std::move(partial_block);
+            }
+
+            void node_impl::process_reconstructed_block(peer_connection *originating_peer,
+                    peer_connection::partial_compact_block &&partial_block) {
+                VERIFY_CORRECT_THREAD();
+                auto &block = partial_block.block;
+
+                // the block message is the same as the requested one only if all transactions are the same, they can
+                // differ on a collision of short ids or if the transaction has other signatures (they aren't in its id)
+                message block_message_to_process(graphene::network::block_message(block));
+                message_hash_type message_hash = block_message_to_process.id();
+                if (!partial_block.all_transactions_requested &&
+                    originating_peer->items_requested_from_peer.find(item_id(block_message_type, message_hash)) ==
+                    originating_peer->items_requested_from_peer.end()) {
+                    block_id_type block_id = block.id();
+                    wlog("compact block ${id} from peer ${endpoint} isn't reconstructed, requesting all its transactions",
+                            ("id", block_id)("endpoint", originating_peer->get_remote_endpoint()));
+                    partial_block.missing_indexes.resize(block.transactions.size());
+                    for (uint32_t i = 0; i < block.transactions.size(); ++i) {
+                        partial_block.missing_indexes[i] = i;
+                    }
+                    partial_block.all_transactions_requested = true;
+                    originating_peer->send_message(get_block_transactions_message(block_id, partial_block.missing_indexes));
+                    originating_peer->partial_compact_blocks[block_id] = std::move(partial_block);
+                    return;
+                }
+
+                _block_propagation.on_received(message_hash, originating_peer->get_remote_endpoint(), partial_block.received_time);
+                process_block_message(originating_peer, block_message_to_process, message_hash);
+            }
+
+            void node_impl::on_get_block_transactions_message(peer_connection *originating_peer,
+                    const get_block_transactions_message &get_block_transactions_message_received) {
+                VERIFY_CORRECT_THREAD();
+                const auto &block_id = get_block_transactions_message_received.block_id;
+
+                fc::optional<message> block_message_found = _message_cache.find_message_by_contents(block_id);
+                if (!block_message_found) {
+                    try {
+                        block_message_found = _delegate->get_item(item_id(block_message_type, block_id));
+                    } catch (const fc::key_not_found_exception &) {
+                    }
+                }
+                if (!block_message_found) {
+                    // the peer will time out the request of the block and fetch it from another peer
+                    wlog("peer ${endpoint} requested transactions of block ${id}, which I don't have",
+                            ("endpoint", originating_peer->get_remote_endpoint())("id", block_id));
+                    return;
+                }
+
+                const auto block = block_message_found->as<graphene::network::block_message>().block;
+                block_transactions_message reply;
+                reply.block_id = block_id;
+                reply.transactions.reserve(get_block_transactions_message_received.indexes.size());
+                for (uint32_t index : get_block_transactions_message_received.indexes) {
+                    FC_ASSERT(index < block.transactions.size(),
+                            "Requested transaction index ${i} is out of the block", ("i", index));
+                    reply.transactions.emplace_back(index, block.transactions[index]);
+                }
+                originating_peer->send_message(reply);
+            }
+
+            void node_impl::on_block_transactions_message(peer_connection *originating_peer,
+                    const block_transactions_message &block_transactions_message_received) {
+                VERIFY_CORRECT_THREAD();
+                auto iter = originating_peer->partial_compact_blocks.find(block_transactions_message_received.block_id);
+                if (iter == originating_peer->partial_compact_blocks.end()) {
+                    wlog("received transactions of block ${id} I didn't ask for from peer ${endpoint}",
+                            ("id", block_transactions_message_received.block_id)
+                                    ("endpoint", originating_peer->get_remote_endpoint()));
+                    return;
+                }
+
+                auto partial_block = std::move(iter->second);
+                originating_peer->partial_compact_blocks.erase(iter);
+
+                const auto &transactions = block_transactions_message_received.transactions;
+                FC_ASSERT(transactions.size() == partial_block.missing_indexes.size(),
+                        "Received ${n} transactions of block instead of ${m} requested",
+                        ("n", transactions.size())("m", partial_block.missing_indexes.size()));
+                for (size_t i = 0; i < transactions.size(); ++i) {
+                    FC_ASSERT(transactions[i].index == partial_block.missing_indexes[i],
+                            "Received transaction ${i} of block, which wasn't requested", ("i", transactions[i].index));
+                    partial_block.block.transactions[transactions[i].index] = transactions[i].trx;
+                }
+
+                process_reconstructed_block(originating_peer, std::move(partial_block));
+            }
+
             void node_impl::on_current_time_request_message(peer_connection *originating_peer,
                     const current_time_request_message &current_time_request_message_received) {
                 VERIFY_CORRECT_THREAD();
@@ -3925,10 +4420,13 @@ namespace graphene {
 
                     // Next: have the delegate process the message
                     fc::time_point message_validated_time;
+                    fc::uint160_t hash_of_message_contents;
                     try {
                         if (message_to_process.msg_type == trx_message_type) {
                             trx_message transaction_message_to_process = message_to_process.as<trx_message>();
-                            dlog("passing message containing transaction ${trx} to client", ("trx", transaction_message_to_process.trx.id()));
+                            // the id is calculated once, it's used for broadcasting too
+                            hash_of_message_contents = transaction_message_to_process.trx.id();
+                            dlog("passing message containing transaction ${trx} to client", ("trx", hash_of_message_contents));
                             _delegate->handle_transaction(transaction_message_to_process);
                         } else {
                             _delegate->handle_message(message_to_process);
@@ -3950,7 +4448,38 @@ namespace graphene {
                             message_receive_time, message_validated_time,
                             originating_peer->node_id
                     };
-                    broadcast(message_to_process, propagation_data);
+                    broadcast(message_to_process, message_hash, hash_of_message_contents, propagation_data);
+                }
+            }
+
+            void node_impl::on_trx_batch_message(peer_connection *originating_peer,
+                    const trx_batch_message &trx_batch_message_received) {
+                VERIFY_CORRECT_THREAD();
+                dlog("received a batch of ${count} transactions from peer ${endpoint}",
+                        ("count", trx_batch_message_received.trx_messages.size())
+                                ("endpoint", originating_peer->get_remote_endpoint()));
+                // transactions of the batch are processed concurrently, so the delegate can validate them
+                // in parallel and apply them together, the delegate keeps the order of arrival
+                peer_connection_ptr peer = originating_peer->shared_from_this();
+                std::vector<fc::future<void>> transactions_processed;
+                transactions_processed.reserve(trx_batch_message_received.trx_messages.size());
+                for (const auto &trx_message_data : trx_batch_message_received.trx_messages) {
+                    // the peer is disconnected if it sends a transaction we didn't ask for
+                    if (originating_peer->we_have_requested_close) {
+                        break;
+                    }
+                    message transaction_message;
+                    transaction_message.msg_type = trx_message_type;
+                    transaction_message.size = (uint32_t)trx_message_data.size();
+                    transaction_message.data = trx_message_data;
+                    message_hash_type message_hash = transaction_message.id();
+                    transactions_processed.push_back(fc::async([this, peer, transaction_message, message_hash]() {
+                        process_ordinary_message(peer.get(), transaction_message, message_hash);
+                    }, "process_trx_batch_transaction"));
+                    fc::yield(); // lets the fiber check the request before the next transaction
+                }
+                for (auto &transaction_processed : transactions_processed) {
+                    transaction_processed.wait();
                 }
             }
 
@@ -3987,6 +4516,10 @@ namespace graphene {
                 VERIFY_CORRECT_THREAD();
 
                 try {
+                    // connections are closed after the database, their statistics are saved now
+                    for (const peer_connection_ptr &active_peer : _active_connections) {
+                        record_connection_statistics(active_peer.get());
+                    }
                     _potential_peer_db.close();
                 }
                 catch (const fc::exception &e) {
@@ -4892,6 +5425,9 @@ namespace graphene {
                     peer_details["current_head_block_number"] = _delegate->get_block_number(peer->last_block_delegate_has_seen);
                     peer_details["current_head_block_time"] = peer->last_block_time_delegate_has_seen;
 
+                    peer_details["compression"] = peer->supports_compression;
+                    peer_details["compression_stats"] = peer->compression.to_variant_object();
+
                     this_peer_status.info = peer_details;
                     statuses.push_back(this_peer_status);
                 }
@@ -4917,10 +5453,17 @@ namespace graphene {
                     hash_of_message_contents = transaction_message_to_broadcast.trx.id(); // for debugging
                     dlog("broadcasting trx: ${trx}", ("trx", transaction_message_to_broadcast));
                 }
-                message_hash_type hash_of_item_to_broadcast = item_to_broadcast.id();
+                broadcast(item_to_broadcast, item_to_broadcast.id(), hash_of_message_contents, propagation_data);
+            }
 
+            void node_impl::broadcast(const message &item_to_broadcast, const message_hash_type &hash_of_item_to_broadcast,
+                    const fc::uint160_t &hash_of_message_contents, const message_propagation_data &propagation_data) {
+                VERIFY_CORRECT_THREAD();
                 _message_cache.cache_message(item_to_broadcast, hash_of_item_to_broadcast, propagation_data, hash_of_message_contents);
                 _new_inventory.insert(item_id(item_to_broadcast.msg_type, hash_of_item_to_broadcast));
+                if (item_to_broadcast.msg_type == graphene::network::block_message_type) {
+                    _new_inventory_has_blocks = true;
+                }
                 trigger_advertise_inventory_loop();
             }
 
@@ -4978,6 +5521,16 @@ namespace graphene {
                 if (params.contains("maximum_blocks_per_peer_during_syncing")) {
                     _maximum_blocks_per_peer_during_syncing = params["maximum_blocks_per_peer_during_syncing"].as<uint32_t>();
                 }
+                if (params.contains("transaction_aggregation_window_ms")) {
+                    _transaction_aggregation_window = fc::milliseconds(params["transaction_aggregation_window_ms"].as<uint32_t>());
+                }
+                if (params.contains("maximum_queued_messages_in_bytes_total")) {
+                    _send_queue_budget->max_size = params["maximum_queued_messages_in_bytes_total"].as<uint64_t>();
+                }
+                if (params.contains("compression")) {
+                    // applies to connections, which are established after that
+                    _compression_enabled = params["compression"].as_bool();
+                }
 
                 _desired_number_of_connections = std::min(_desired_number_of_connections, _maximum_number_of_connections);
 
@@ -4998,6 +5551,10 @@ namespace graphene {
                 result["maximum_number_of_blocks_to_handle_at_one_time"] = _maximum_number_of_blocks_to_handle_at_one_time;
                 result["maximum_number_of_sync_blocks_to_prefetch"] = _maximum_number_of_sync_blocks_to_prefetch;
                 result["maximum_blocks_per_peer_during_syncing"] = _maximum_blocks_per_peer_during_syncing;
+                result["compression"] = _compression_enabled;
+                result["transaction_aggregation_window_ms"] = _transaction_aggregation_window.count() / 1000;
+                result["maximum_queued_messages_in_bytes_total"] = uint64_t(_send_queue_budget->max_size);
+                result["queued_messages_in_bytes_total"] = uint64_t(_send_queue_budget->total_size);
                 return result;
             }
 
@@ -5011,6 +5568,11 @@ namespace graphene {
                 return _message_cache.get_message_propagation_data(block_id);
             }
 
+            fc::variant_object node_impl::get_block_propagation_stats() const {
+                VERIFY_CORRECT_THREAD();
+                return _block_propagation.get_stats();
+            }
+
             node_id_t node_impl::get_node_id() const {
                 VERIFY_CORRECT_THREAD();
                 return _node_id;
@@ -5210,6 +5772,10 @@ namespace graphene {
             INVOKE_IN_IMPL(get_block_propagation_data, block_id);
         }
 
+        fc::variant_object node::get_block_propagation_stats() const {
+            INVOKE_IN_IMPL(get_block_propagation_stats);
+        }
+
         node_id_t node::get_node_id() const {
             INVOKE_IN_IMPL(get_node_id);
         }
@@ -22,6 +22,7 @@
  * THE SOFTWARE.
  */
 #include <graphene/network/peer_connection.hpp>
+#include <graphene/network/io_thread_pool.hpp>
 
 #include <fc/thread/thread.hpp>
 
@@ -38,6 +39,27 @@
 
 namespace graphene {
     namespace network {
+        message_priority get_message_priority(const message &m) {
+            switch (m.msg_type) {
+                case trx_message_type:
+                case trx_batch_message_type:
+                    return message_priority::transaction;
+                case blockchain_item_ids_inventory_message_type:
+                    return message_priority::sync;
+                case item_ids_inventory_message_type:
+                case fetch_items_message_type: {
+                    // item_type is the first field of both messages, so they aren't unpacked
+                    uint32_t item_type = 0;
+                    if (m.data.size() >= sizeof(item_type)) {
+                        memcpy(&item_type, m.data.data(), sizeof(item_type));
+                    }
+                    return item_type == trx_message_type ? message_priority::transaction : message_priority::block;
+                }
+                default:
+                    return message_priority::block;
+            }
+        }
+
         message peer_connection::real_queued_message::get_message(peer_connection_delegate *) {
             if (message_send_time_field_offset != (size_t)-1) {
                 // patch the current time into the message.  Since this operates on the packed version of the structure,
@@ -69,6 +91,7 @@ namespace graphene {
                 _node(delegate),
                 _message_connection(this),
                 _total_queued_messages_size(0),
+                _send_queue_budget(delegate->get_send_queue_budget()),
                 direction(peer_connection_direction::unknown),
                 is_firewalled(firewalled_state::unknown),
                 our_state(our_connection_state::disconnected),
@@ -80,7 +103,12 @@ namespace graphene {
                 peer_needs_sync_items_from_us(true),
                 we_need_sync_items_from_peer(true),
                 inhibit_fetching_sync_blocks(false),
+                sync_items_request_size(0),
+                sync_items_per_second(0),
                 transaction_fetching_inhibited_until(fc::time_point::min()),
+                supports_compact_blocks(false),
+                supports_compression(false),
+                supports_trx_batches(false),
                 last_known_fork_block_number(0),
                 firewall_check_state(nullptr)
 #ifndef NDEBUG
@@ -141,6 +169,11 @@ namespace graphene {
                 wlog("Unexpected exception from peer_connection's send_queued_messages_task");
             }
 
+            // return the memory of messages, which won't be sent, to the budget of the node
+            while (has_queued_messages()) {
+                pop_queued_message();
+            }
+
             try {
                 dlog("canceling accept_or_connect_task");
                 accept_or_connect_task_done.cancel_and_wait(__FUNCTION__);
@@ -243,9 +276,75 @@ namespace graphene {
 
         void peer_connection::on_message(message_oriented_connection *originating_connection, const message &received_message) {
             VERIFY_CORRECT_THREAD();
+            if (received_message.msg_type == compressed_message_type) {
+                // the peer can't compress messages if both sides didn't agree on it in hello,
+                // the exception closes the connection as for other malformed messages
+                FC_ASSERT(supports_compression,
+                          "Peer ${peer} sent a compressed message, but compression wasn't negotiated",
+                          ("peer", get_remote_endpoint()));
+                _node->on_message(this, decompress_from_peer(received_message));
+                return;
+            }
             _node->on_message(this, received_message);
         }
 
+        message peer_connection::compress_for_peer(message &&message_to_send) {
+            VERIFY_CORRECT_THREAD();
+            if (!supports_compression || !is_compressible_message(message_to_send)) {
+                return std::move(message_to_send);
+            }
+
+            message compressed;
+            bool is_compressed = false;
+            fc::microseconds elapsed;
+            auto compress = [&]() {
+                fc::time_point start = fc::time_point::now();
+                is_compressed = compress_message(message_to_send, compressed);
+                elapsed = fc::time_point::now() - start;
+            };
+            // large blocks are compressed in an IO thread, so other connections aren't stalled
+            if (message_to_send.size >= GRAPHENE_NET_IO_THREAD_MIN_MESSAGE_SIZE) {
+                io_thread_pool::instance().run(compress);
+            } else {
+                compress();
+            }
+
+            compression.compression_time += elapsed;
+            if (!is_compressed) {
+                return std::move(message_to_send);
+            }
+            compression.messages_compressed++;
+            compression.bytes_before_compression += message_to_send.size;
+            compression.bytes_after_compression += compressed.size;
+            return compressed;
+        }
+
+        message peer_connection::decompress_from_peer(const message &received_message) {
+            VERIFY_CORRECT_THREAD();
+            message original;
+            fc::microseconds elapsed;
+            auto decompress = [&]() {
+                fc::time_point start = fc::time_point::now();
+                decompress_message(received_message, original);
+                if (original.size >= GRAPHENE_NET_IO_THREAD_MIN_MESSAGE_SIZE) {
+                    original.data_hash = fc::ripemd160::hash(original.data.data(), (uint32_t)original.data.size());
+                }
+                elapsed = fc::time_point::now() - start;
+            };
+            // compressed blocks are several times smaller than the original ones
+            if (received_message.size >= GRAPHENE_NET_IO_THREAD_MIN_MESSAGE_SIZE / 4) {
+                io_thread_pool::instance().run(decompress);
+            } else {
+                decompress();
+            }
+
+            compression.messages_decompressed++;
+            compression.bytes_before_decompression += received_message.size;
+            compression.bytes_after_decompression += original.size;
+            compression.decompression_time += elapsed;
+            return original;
+        }
+
         void peer_connection::on_connection_closed(message_oriented_connection *originating_connection) {
             VERIFY_CORRECT_THREAD();
             negotiation_status = connection_negotiation_status::closed;
@@ -269,14 +368,24 @@ namespace graphene {
                     --_send_message_queue_tasks_counter; /* dlog("leaving peer_connection::send_queued_messages_task()"); */ }
             } concurrent_invocation_counter(_send_message_queue_tasks_running);
 #endif
-            while (!_queued_messages.empty()) {
-                _queued_messages.front()->transmission_start_time = fc::time_point::now();
-                message message_to_send = _queued_messages.front()->get_message(_node);
+            while (has_queued_messages()) {
+                // Messages waiting in the queue are sent together with one encryption pass and one write,
+                // the batch is limited, so a long queue doesn't delay the start of transmission too much.
+                // A block queued while a batch of sync blocks is loaded goes to the next batch before them.
+                std::vector<std::unique_ptr<queued_message>> batch;
+                std::vector<message> messages_to_send;
+                size_t batch_size = 0;
+                while (has_queued_messages() && batch_size < GRAPHENE_NET_MAX_SEND_BATCH_SIZE) {
+                    batch.emplace_back(pop_queued_message());
+                    batch.back()->transmission_start_time = fc::time_point::now();
+                    messages_to_send.emplace_back(compress_for_peer(batch.back()->get_message(_node)));
+                    batch_size += messages_to_send.back().size;
+                }
                 try {
-                    //dlog("peer_connection::send_queued_messages_task() calling message_oriented_connection::send_message() "
-                    //     "to send message of type ${type} for peer ${endpoint}",
-                    //     ("type", message_to_send.msg_type)("endpoint", get_remote_endpoint()));
-                    _message_connection.send_message(message_to_send);
+                    //dlog("peer_connection::send_queued_messages_task() calling message_oriented_connection::send_messages() "
+                    //     "to send ${count} messages for peer ${endpoint}",
+                    //     ("count", messages_to_send.size())("endpoint", get_remote_endpoint()));
+                    _message_connection.send_messages(messages_to_send);
                     //dlog("peer_connection::send_queued_messages_task()'s call to message_oriented_connection::send_message() completed normally for peer ${endpoint}",
                     //     ("endpoint", get_remote_endpoint()));
                 }
@@ -300,21 +409,52 @@ namespace graphene {
                 catch (...) {
                     elog("message_oriented_exception::send_message() threw an unhandled exception");
                 }
-                _queued_messages.front()->transmission_finish_time = fc::time_point::now();
-                _total_queued_messages_size -= _queued_messages.front()->get_size_in_queue();
-                _queued_messages.pop();
+                fc::time_point transmission_finish_time = fc::time_point::now();
+                for (auto &sent : batch) {
+                    sent->transmission_finish_time = transmission_finish_time;
+                }
             }
             //dlog("leaving peer_connection::send_queued_messages_task() due to queue exhaustion");
         }
 
-        void peer_connection::send_queueable_message(std::unique_ptr<queued_message> &&message_to_send) {
+        bool peer_connection::has_queued_messages() const {
+            for (const auto &queue : _queued_messages) {
+                if (!queue.empty()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::unique_ptr<peer_connection::queued_message> peer_connection::pop_queued_message() {
+            for (auto &queue : _queued_messages) {
+                if (!queue.empty()) {
+                    std::unique_ptr<queued_message> result = std::move(queue.front());
+                    queue.pop();
+                    size_t size = result->get_size_in_queue();
+                    _total_queued_messages_size -= size;
+                    _send_queue_budget->total_size -= size;
+                    return result;
+                }
+            }
+            return nullptr;
+        }
+
+        void peer_connection::send_queueable_message(std::unique_ptr<queued_message> &&message_to_send, message_priority priority) {
             VERIFY_CORRECT_THREAD();
-            _total_queued_messages_size += message_to_send->get_size_in_queue();
-            _queued_messages.emplace(std::move(message_to_send));
+            size_t size = message_to_send->get_size_in_queue();
+            _total_queued_messages_size += size;
+            _send_queue_budget->total_size += size;
+            _queued_messages[static_cast<size_t>(priority)].emplace(std::move(message_to_send));
+
+            bool exceeds_budget = _send_queue_budget->total_size > _send_queue_budget->max_size &&
+                                  _total_queued_messages_size > GRAPHENE_NET_MINIMUM_QUEUED_MESSAGES_IN_BYTES;
             if (_total_queued_messages_size >
-                GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES) {
-                elog("send queue exceeded maximum size of ${max} bytes (current size ${current} bytes)",
-                        ("max", GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES)("current", _total_queued_messages_size));
+                GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES || exceeds_budget) {
+                elog("send queue exceeded maximum size of ${max} bytes (current size ${current} bytes, "
+                     "all peers ${total} of ${budget} bytes)",
+                        ("max", GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES)("current", _total_queued_messages_size)
+                        ("total", _send_queue_budget->total_size)("budget", _send_queue_budget->max_size));
                 try {
                     close_connection();
                 }
@@ -342,15 +482,15 @@ namespace graphene {
             //dlog("peer_connection::send_message() enqueueing message of type ${type} for peer ${endpoint}",
             //     ("type", message_to_send.msg_type)("endpoint", get_remote_endpoint()));
             std::unique_ptr<queued_message> message_to_enqueue(new real_queued_message(message_to_send, message_send_time_field_offset));
-            send_queueable_message(std::move(message_to_enqueue));
+            send_queueable_message(std::move(message_to_enqueue), get_message_priority(message_to_send));
         }
 
-        void peer_connection::send_item(const item_id &item_to_send) {
+        void peer_connection::send_item(const item_id &item_to_send, message_priority priority) {
             VERIFY_CORRECT_THREAD();
             //dlog("peer_connection::send_item() enqueueing message of type ${type} for peer ${endpoint}",
             //     ("type", item_to_send.item_type)("endpoint", get_remote_endpoint()));
             std::unique_ptr<queued_message> message_to_enqueue(new virtual_queued_message(item_to_send));
-            send_queueable_message(std::move(message_to_enqueue));
+            send_queueable_message(std::move(message_to_enqueue), priority);
         }
 
         void peer_connection::close_connection() {
@@ -26,39 +26,115 @@
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/mem_fun.hpp>
+#include <boost/filesystem.hpp>
 
 #include <fc/io/raw.hpp>
 #include <fc/io/json.hpp>
 
 #include <graphene/network/peer_database.hpp>
 
+#include <fstream>
+#include <limits>
+
+#define MAXIMUM_PEERDB_SIZE 1000
+
+// the binary file: the header, then a log of changes, each of them is the operation, the size and packed data
+#define PEERDB_FILE_MAGIC   0x4244505a  // "ZPDB"
+#define PEERDB_FILE_VERSION 1
+#define PEERDB_FLUSH_INTERVAL_SECONDS 10
+
 
 namespace graphene {
     namespace network {
+
+        void potential_peer_record::record_connection(fc::microseconds connected_time, uint64_t bytes_received,
+                fc::microseconds measured_round_trip_delay) {
+            if (connected_time > fc::seconds(0)) {
+                total_connected_seconds += (uint32_t)connected_time.to_seconds();
+                uint32_t throughput = (uint32_t)std::min<uint64_t>(
+                        bytes_received * 1000000 / connected_time.count(), std::numeric_limits<uint32_t>::max());
+                // recent connections matter as much as all the previous ones
+                average_throughput = average_throughput ? (average_throughput / 2 + throughput / 2) : throughput;
+            }
+            if (measured_round_trip_delay > fc::microseconds(0)) {
+                round_trip_delay = round_trip_delay > fc::microseconds(0)
+                        ? fc::microseconds((round_trip_delay.count() + measured_round_trip_delay.count()) / 2)
+                        : measured_round_trip_delay;
+            }
+        }
+
+        int64_t potential_peer_record::score() const {
+            int64_t result = 0;
+            switch (last_connection_disposition) {
+                case last_connection_succeeded:
+                    result += 1000;
+                    break;
+                case last_connection_failed:
+                case last_connection_rejected:
+                case last_connection_handshaking_failed:
+                    result -= 1000;
+                    break;
+                default:
+                    break;
+            }
+            // a point per minute of uptime up to a day, a point per KiB/s of throughput up to 1 MiB/s
+            result += std::min<int64_t>(total_connected_seconds / 60, 24 * 60);
+            result += std::min<int64_t>(average_throughput / 1024, 1024);
+            // a point per 2 ms of latency up to a second
+            result -= std::min<int64_t>(round_trip_delay.count() / 2000, 500);
+            result += std::min<int64_t>(number_of_successful_connection_attempts, 100) * 5;
+            result -= std::min<int64_t>(number_of_failed_connection_attempts, 100) * 20;
+            return result;
+        }
+
         namespace detail {
             using namespace boost::multi_index;
 
             class peer_database_impl {
             public:
+                struct score_index {
+                };
                 struct last_seen_time_index {
                 };
                 struct endpoint_index {
                 };
                 typedef boost::multi_index_container<potential_peer_record,
-                        indexed_by<ordered_non_unique<tag<last_seen_time_index>,
-                                member<potential_peer_record,
-                                        fc::time_point_sec,
-                                        &potential_peer_record::last_seen_time>>,
+                        indexed_by<ordered_non_unique<tag<score_index>,
+                                const_mem_fun<potential_peer_record,
+                                        int64_t,
+                                        &potential_peer_record::score>,
+                                std::greater<int64_t>>,
+                                ordered_non_unique<tag<last_seen_time_index>,
+                                        member<potential_peer_record,
+                                                fc::time_point_sec,
+                                                &potential_peer_record::last_seen_time>>,
                                 hashed_unique<tag<endpoint_index>,
                                         member<potential_peer_record,
                                                 fc::ip::endpoint,
                                                 &potential_peer_record::endpoint>,
                                         std::hash<fc::ip::endpoint>>>> potential_peer_set;
 
+                enum log_operation : uint8_t {
+                    update_operation = 1,
+                    erase_operation = 2
+                };
+
             private:
                 potential_peer_set _potential_peer_set;
                 fc::path _peer_database_filename;
 
+                std::ofstream _log;
+                size_t _log_entries = 0;
+                fc::time_point _last_flush_time;
+
+                void load_json(const fc::path &filename);
+
+                void load_binary();
+
+                void append_to_log(log_operation operation, const std::vector<char> &data);
+
+                void rewrite_file();
+
             public:
                 void open(const fc::path &databaseFilename);
 
@@ -83,10 +159,10 @@ namespace graphene {
 
             class peer_database_iterator_impl {
             public:
-                typedef peer_database_impl::potential_peer_set::index<peer_database_impl::last_seen_time_index>::type::iterator last_seen_time_index_iterator;
-                last_seen_time_index_iterator _iterator;
+                typedef peer_database_impl::potential_peer_set::index<peer_database_impl::score_index>::type::iterator score_index_iterator;
+                score_index_iterator _iterator;
 
-                peer_database_iterator_impl(const last_seen_time_index_iterator &iterator)
+                peer_database_iterator_impl(const score_index_iterator &iterator)
                         :
                         _iterator(iterator) {
                 }
@@ -97,54 +173,175 @@ namespace graphene {
                     boost::iterator_facade<peer_database_iterator, const potential_peer_record, boost::forward_traversal_tag>(c) {
             }
 
-            void peer_database_impl::open(const fc::path &peer_database_filename) {
-                _peer_database_filename = peer_database_filename;
-                if (fc::exists(_peer_database_filename)) {
-                    try {
-                        std::vector<potential_peer_record> peer_records = fc::json::from_file(_peer_database_filename).as<std::vector<potential_peer_record>>();
-                        std::copy(peer_records.begin(), peer_records.end(), std::inserter(_potential_peer_set, _potential_peer_set.end()));
-#define MAXIMUM_PEERDB_SIZE 1000
-                        if (_potential_peer_set.size() > MAXIMUM_PEERDB_SIZE) {
-                            // prune database to a reasonable size
-                            auto iter = _potential_peer_set.begin();
-                            std::advance(iter, MAXIMUM_PEERDB_SIZE);
-                            _potential_peer_set.erase(iter, _potential_peer_set.end());
+            void peer_database_impl::load_json(const fc::path &filename) {
+                std::vector<potential_peer_record> peer_records = fc::json::from_file(filename).as<std::vector<potential_peer_record>>();
+                std::copy(peer_records.begin(), peer_records.end(), std::inserter(_potential_peer_set, _potential_peer_set.end()));
+            }
+
+            void peer_database_impl::load_binary() {
+                std::ifstream stream(_peer_database_filename.string(), std::ios::in | std::ios::binary);
+                std::vector<char> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+                fc::datastream<const char *> ds(data.data(), data.size());
+                uint32_t magic = 0;
+                uint32_t version = 0;
+                fc::raw::unpack(ds, magic);
+                fc::raw::unpack(ds, version);
+                FC_ASSERT(magic == PEERDB_FILE_MAGIC && version == PEERDB_FILE_VERSION,
+                        "Unknown format of the peer database", ("magic", magic)("version", version));
+
+                auto &endpoint_idx = _potential_peer_set.get<endpoint_index>();
+                while (ds.remaining() >= sizeof(uint8_t) + sizeof(uint32_t)) {
+                    uint8_t operation = 0;
+                    uint32_t size = 0;
+                    fc::raw::unpack(ds, operation);
+                    fc::raw::unpack(ds, size);
+                    if (ds.remaining() < size) {
+                        // the tail wasn't written completely, changes after the last flush are lost
+                        wlog("peer database ${peer_database_filename} is truncated, ignoring the last change",
+                                ("peer_database_filename", _peer_database_filename));
+                        break;
+                    }
+                    fc::datastream<const char *> entry(ds.pos(), size);
+                    ds.skip(size);
+
+                    if (operation == update_operation) {
+                        potential_peer_record record;
+                        fc::raw::unpack(entry, record);
+                        auto iter = endpoint_idx.find(record.endpoint);
+                        if (iter != endpoint_idx.end()) {
+                            endpoint_idx.replace(iter, record);
+                        } else {
+                            endpoint_idx.insert(record);
                         }
+                    } else if (operation == erase_operation) {
+                        fc::ip::endpoint endpoint;
+                        fc::raw::unpack(entry, endpoint);
+                        endpoint_idx.erase(endpoint);
+                    }
+                }
+            }
+
+            void peer_database_impl::append_to_log(log_operation operation, const std::vector<char> &data) {
+                if (!_log.is_open()) {
+                    return;
+                }
+                _log.put(operation);
+                uint32_t size = (uint32_t)data.size();
+                auto packed_size = fc::raw::pack(size);
+                _log.write(packed_size.data(), packed_size.size());
+                _log.write(data.data(), data.size());
+                ++_log_entries;
+
+                // the log is compacted when most of its entries are outdated
+                if (_log_entries > 2 * _potential_peer_set.size() + MAXIMUM_PEERDB_SIZE) {
+                    try {
+                        rewrite_file();
                     }
                     catch (const fc::exception &e) {
-                        elog("error opening peer database file ${peer_database_filename}, starting with a clean database",
-                                ("peer_database_filename", _peer_database_filename));
+                        elog("error saving peer database to file ${peer_database_filename}: ${e}",
+                                ("peer_database_filename", _peer_database_filename)("e", e));
                     }
+                } else if (fc::time_point::now() - _last_flush_time > fc::seconds(PEERDB_FLUSH_INTERVAL_SECONDS)) {
+                    _log.flush();
+                    _last_flush_time = fc::time_point::now();
                 }
             }
 
-            void peer_database_impl::close() {
-                std::vector<potential_peer_record> peer_records;
-                peer_records.reserve(_potential_peer_set.size());
-                std::copy(_potential_peer_set.begin(), _potential_peer_set.end(), std::back_inserter(peer_records));
+            void peer_database_impl::rewrite_file() {
+                if (_log.is_open()) {
+                    _log.close();
+                }
+
+                fc::path peer_database_filename_dir = _peer_database_filename.parent_path();
+                if (!fc::exists(peer_database_filename_dir)) {
+                    fc::create_directories(peer_database_filename_dir);
+                }
+
+                // a new file is written completely before it replaces the old one
+                std::string temporary_filename = _peer_database_filename.string() + ".tmp";
+                {
+                    std::ofstream stream(temporary_filename, std::ios::out | std::ios::binary | std::ios::trunc);
+                    auto magic = fc::raw::pack((uint32_t)PEERDB_FILE_MAGIC);
+                    auto version = fc::raw::pack((uint32_t)PEERDB_FILE_VERSION);
+                    stream.write(magic.data(), magic.size());
+                    stream.write(version.data(), version.size());
+                    for (const potential_peer_record &record : _potential_peer_set) {
+                        auto data = fc::raw::pack(record);
+                        auto packed_size = fc::raw::pack((uint32_t)data.size());
+                        stream.put(update_operation);
+                        stream.write(packed_size.data(), packed_size.size());
+                        stream.write(data.data(), data.size());
+                    }
+                    stream.flush();
+                    FC_ASSERT(stream.good(), "Unable to write the peer database", ("filename", temporary_filename));
+                }
+                fc::rename(temporary_filename, _peer_database_filename);
+
+                _log.open(_peer_database_filename.string(), std::ios::out | std::ios::binary | std::ios::app);
+                _log_entries = _potential_peer_set.size();
+                _last_flush_time = fc::time_point::now();
+            }
 
+            void peer_database_impl::open(const fc::path &peer_database_filename) {
+                _peer_database_filename = peer_database_filename;
+                boost::filesystem::path json_filename(_peer_database_filename.string());
+                json_filename.replace_extension(".json");
                 try {
-                    fc::path peer_database_filename_dir = _peer_database_filename.parent_path();
-                    if (!fc::exists(peer_database_filename_dir)) {
-                        fc::create_directories(peer_database_filename_dir);
+                    if (fc::exists(_peer_database_filename)) {
+                        load_binary();
+                    } else if (fc::exists(json_filename)) {
+                        ilog("importing peer database from ${filename}", ("filename", json_filename.string()));
+                        load_json(json_filename);
                     }
-                    fc::json::save_to_file(peer_records, _peer_database_filename);
+                    if (_potential_peer_set.size() > MAXIMUM_PEERDB_SIZE) {
+                        // prune database to a reasonable size, the best peers are kept
+                        auto iter = _potential_peer_set.begin();
+                        std::advance(iter, MAXIMUM_PEERDB_SIZE);
+                        _potential_peer_set.erase(iter, _potential_peer_set.end());
+                    }
+                }
+                catch (const fc::exception &e) {
+                    elog("error opening peer database file ${peer_database_filename}, starting with a clean database",
+                            ("peer_database_filename", _peer_database_filename));
+                    _potential_peer_set.clear();
+                }
+
+                try {
+                    rewrite_file();
+                }
+                catch (const fc::exception &e) {
+                    elog("error saving peer database to file ${peer_database_filename}",
+                            ("peer_database_filename", _peer_database_filename));
+                }
+            }
+
+            void peer_database_impl::close() {
+                try {
+                    rewrite_file();
                 }
                 catch (const fc::exception &e) {
                     elog("error saving peer database to file ${peer_database_filename}",
                             ("peer_database_filename", _peer_database_filename));
                 }
+                if (_log.is_open()) {
+                    _log.close();
+                }
                 _potential_peer_set.clear();
             }
 
             void peer_database_impl::clear() {
                 _potential_peer_set.clear();
+                if (_log.is_open()) {
+                    rewrite_file();
+                }
             }
 
             void peer_database_impl::erase(const fc::ip::endpoint &endpointToErase) {
                 auto iter = _potential_peer_set.get<endpoint_index>().find(endpointToErase);
                 if (iter != _potential_peer_set.get<endpoint_index>().end()) {
                     _potential_peer_set.get<endpoint_index>().erase(iter);
+                    append_to_log(erase_operation, fc::raw::pack(endpointToErase));
                 }
             }
 
@@ -155,6 +352,7 @@ namespace graphene {
                 } else {
                     _potential_peer_set.get<endpoint_index>().insert(updatedRecord);
                 }
+                append_to_log(update_operation, fc::raw::pack(updatedRecord));
             }
 
             potential_peer_record peer_database_impl::lookup_or_create_entry_for_endpoint(const fc::ip::endpoint &endpointToLookup) {
@@ -174,11 +372,11 @@ namespace graphene {
             }
 
             peer_database::iterator peer_database_impl::begin() const {
-                return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<last_seen_time_index>().begin()));
+                return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<score_index>().begin()));
             }
 
             peer_database::iterator peer_database_impl::end() const {
-                return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<last_seen_time_index>().end()));
+                return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<score_index>().end()));
             }
 
             size_t peer_database_impl::size() const {
@@ -125,6 +125,28 @@ namespace graphene {
             return readsome(buf.get() + offset, len);
         }
 
+        void stcp_socket::decrypt(const char *ciphertext, size_t len, char *plaintext) {
+            assert((len % 16) == 0);
+            _recv_aes.decode(ciphertext, len, plaintext);
+        }
+
+        void stcp_socket::read_in_place(char *buffer, size_t len) {
+            try {
+                assert((len % 16) == 0);
+                _sock.read(buffer, len);
+                _recv_aes.decode(buffer, len, buffer);
+            } FC_RETHROW_EXCEPTIONS(warn, "", ("len", len))
+        }
+
+        void stcp_socket::write_in_place(char *buffer, size_t len) {
+            try {
+                assert((len % 16) == 0);
+                uint32_t ciphertext_len = _send_aes.encode(buffer, len, buffer);
+                assert(ciphertext_len == len);
+                _sock.write(buffer, ciphertext_len);
+            } FC_RETHROW_EXCEPTIONS(warn, "", ("len", len))
+        }
+
         bool stcp_socket::eof() const {
             return _sock.eof();
         }
@@ -158,7 +180,6 @@ namespace graphene {
                     _write_buffer.reset(new char[write_buffer_length], [](char *p) { delete[] p; });
                 }
                 len = std::min<size_t>(write_buffer_length, len);
-                memset(_write_buffer.get(), 0, len); // just in case aes.encode screws up
                 /**
                  * every sizeof(crypt_buf) bytes the aes channel
                  * has an error and doesn't decrypt properly...  disable
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace graphene { namespace plugins { namespace account_history {
+
+    /**
+     * Number of sequence numbers in one chunk of bitmap of operation type
+     */
+    constexpr uint32_t account_history_bitmap_chunk_size = 4096;
+
+    /**
+     * As in roaring bitmaps, a chunk with up to this number of sequences is stored as a sorted array of 16-bit offsets,
+     * it takes no more space than the bitmap of the chunk (account_history_bitmap_chunk_size / 8 bytes).
+     */
+    constexpr uint32_t account_history_bitmap_array_limit = account_history_bitmap_chunk_size / 16;
+
+    inline bool is_history_bitmap(uint32_t count) {
+        return count > account_history_bitmap_array_limit;
+    }
+
+    /**
+     * Adds offset of sequence in the chunk, offsets are added in the ascending order
+     */
+    template <typename Buffer>
+    void add_to_history_bitmap(Buffer &data, uint32_t &count, uint16_t offset) {
+        if (count < account_history_bitmap_array_limit) {
+            const auto *ptr = reinterpret_cast<const char *>(&offset);
+            data.insert(data.end(), ptr, ptr + sizeof(offset));
+        } else {
+            if (count == account_history_bitmap_array_limit) {
+                std::vector<char> bitmap(account_history_bitmap_chunk_size / 8, 0);
+                for (uint32_t i = 0; i < count; ++i) {
+                    uint16_t value;
+                    std::memcpy(&value, data.data() + i * sizeof(value), sizeof(value));
+                    bitmap[value / 8] |= char(1 << (value % 8));
+                }
+                data.assign(bitmap.begin(), bitmap.end());
+            }
+            data[offset / 8] |= char(1 << (offset % 8));
+        }
+        ++count;
+    }
+
+    /**
+     * Calls visitor for offsets which are not greater than max_offset in the descending order,
+     * stops when visitor returns false.
+     */
+    template <typename Visitor>
+    void for_each_history_bitmap_desc(
+        const char *data, uint32_t count, uint32_t max_offset, Visitor &&visitor
+    ) {
+        if (is_history_bitmap(count)) {
+            max_offset = std::min(max_offset, account_history_bitmap_chunk_size - 1);
+            for (int64_t offset = max_offset; offset >= 0;) {
+                const auto byte = uint8_t(data[offset / 8]);
+                if (byte == 0) {
+                    offset = (offset / 8) * 8 - 1;
+                    continue;
+                }
+                if (((byte >> (offset % 8)) & 1) && !visitor(uint32_t(offset))) {
+                    return;
+                }
+                --offset;
+            }
+            return;
+        }
+
+        for (int64_t i = int64_t(count) - 1; i >= 0; --i) {
+            uint16_t value;
+            std::memcpy(&value, data + i * sizeof(value), sizeof(value));
+            if (value <= max_offset && !visitor(uint32_t(value))) {
+                return;
+            }
+        }
+    }
+
+} } } // graphene::plugins::account_history
@@ -10,6 +10,8 @@
 #include <graphene/chain/chain_object_types.hpp>
 
 #include <graphene/plugins/operation_history/history_object.hpp>
+#include <graphene/plugins/account_history/history_page.hpp>
+#include <graphene/plugins/account_history/history_bitmap.hpp>
 
 #include <boost/multi_index/composite_key.hpp>
 
@@ -32,7 +34,8 @@
 namespace graphene { namespace plugins { namespace account_history {
 
     enum account_object_types {
-        account_history_object_type = (ACCOUNT_HISTORY_SPACE_ID << 8)
+        account_history_page_object_type = (ACCOUNT_HISTORY_SPACE_ID << 8),
+        account_history_type_bitmap_object_type = (ACCOUNT_HISTORY_SPACE_ID << 8) + 1
     };
 
     using namespace graphene::chain;
@@ -40,39 +43,105 @@ namespace graphene { namespace plugins { namespace account_history {
 
     using graphene::plugins::operation_history::operation_id_type;
 
-    class account_history_object final: public object<account_history_object_type, account_history_object> {
+    /**
+     * Page of operations of account with sequence numbers from page * account_history_page_size.
+     * Ids of operations after the first one are stored as deltas from the previous id (see history_page.hpp),
+     * so reading of a range is a sequential scan of a few pages.
+     */
+    class account_history_page_object final: public object<account_history_page_object_type, account_history_page_object> {
     public:
+        account_history_page_object() = delete;
+
         template <typename Constructor, typename Allocator>
-        account_history_object(Constructor &&c, allocator <Allocator> a) {
+        account_history_page_object(Constructor &&c, allocator <Allocator> a)
+            : data(a.get_segment_manager()) {
             c(*this);
         }
 
         id_type id;
 
         account_name_type account;
-        uint32_t sequence = 0;
-        operation_id_type op;
+        uint32_t page = 0;
+        uint32_t count = 0;
+        int64_t first_op = 0;
+        int64_t last_op = 0;
+        buffer_type data;
+
+        uint32_t first_sequence() const {
+            return page * account_history_page_size;
+        }
+
+        uint32_t last_sequence() const {
+            return first_sequence() + count - 1;
+        }
     };
 
-    using account_history_id_type = object_id<account_history_object>;
+    using account_history_page_id_type = object_id<account_history_page_object>;
 
     struct by_account;
-    using account_history_index = multi_index_container<
-        account_history_object,
+    using account_history_page_index = multi_index_container<
+        account_history_page_object,
         indexed_by<
             ordered_unique<
                 tag<by_id>,
-                member<account_history_object, account_history_id_type, &account_history_object::id>>,
+                member<account_history_page_object, account_history_page_id_type, &account_history_page_object::id>>,
             ordered_unique<tag<by_account>,
-                composite_key<account_history_object,
-                    member<account_history_object, account_name_type, &account_history_object::account>,
-                    member<account_history_object, uint32_t, &account_history_object::sequence>>,
+                composite_key<account_history_page_object,
+                    member<account_history_page_object, account_name_type, &account_history_page_object::account>,
+                    member<account_history_page_object, uint32_t, &account_history_page_object::page>>,
                 composite_key_compare<std::less<account_name_type>, std::greater<uint32_t>>>>,
-        allocator<account_history_object>>;
+        allocator<account_history_page_object>>;
+
+    /**
+     * Sequence numbers of operations of one type of account
+     * from chunk * account_history_bitmap_chunk_size (see history_bitmap.hpp).
+     */
+    class account_history_type_bitmap_object final:
+        public object<account_history_type_bitmap_object_type, account_history_type_bitmap_object> {
+    public:
+        account_history_type_bitmap_object() = delete;
+
+        template <typename Constructor, typename Allocator>
+        account_history_type_bitmap_object(Constructor &&c, allocator <Allocator> a)
+            : data(a.get_segment_manager()) {
+            c(*this);
+        }
+
+        id_type id;
+
+        account_name_type account;
+        uint16_t op_type = 0; ///< operation::which()
+        uint32_t chunk = 0;
+        uint32_t count = 0;
+        buffer_type data;
+    };
+
+    using account_history_type_bitmap_id_type = object_id<account_history_type_bitmap_object>;
+
+    struct by_account_type;
+    using account_history_type_bitmap_index = multi_index_container<
+        account_history_type_bitmap_object,
+        indexed_by<
+            ordered_unique<
+                tag<by_id>,
+                member<
+                    account_history_type_bitmap_object,
+                    account_history_type_bitmap_id_type,
+                    &account_history_type_bitmap_object::id>>,
+            ordered_unique<tag<by_account_type>,
+                composite_key<account_history_type_bitmap_object,
+                    member<account_history_type_bitmap_object, account_name_type, &account_history_type_bitmap_object::account>,
+                    member<account_history_type_bitmap_object, uint16_t, &account_history_type_bitmap_object::op_type>,
+                    member<account_history_type_bitmap_object, uint32_t, &account_history_type_bitmap_object::chunk>>,
+                composite_key_compare<std::less<account_name_type>, std::less<uint16_t>, std::greater<uint32_t>>>>,
+        allocator<account_history_type_bitmap_object>>;
 
 } } } // graphene::plugins::account_history
 
 CHAINBASE_SET_INDEX_TYPE(
-    graphene::plugins::account_history::account_history_object,
-    graphene::plugins::account_history::account_history_index)
+    graphene::plugins::account_history::account_history_page_object,
+    graphene::plugins::account_history::account_history_page_index)
 
+CHAINBASE_SET_INDEX_TYPE(
+    graphene::plugins::account_history::account_history_type_bitmap_object,
+    graphene::plugins::account_history::account_history_type_bitmap_index)
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace graphene { namespace plugins { namespace account_history {
+
+    /**
+     * Number of operations in one page of account history,
+     * so the page of an operation with a sequence number is sequence / account_history_page_size.
+     */
+    constexpr uint32_t account_history_page_size = 256;
+
+    /**
+     * Appends the difference between ids of two adjacent operations of account as zigzag varint
+     */
+    template <typename Buffer>
+    void append_history_delta(Buffer &data, int64_t delta) {
+        auto value = (uint64_t(delta) << 1) ^ uint64_t(delta >> 63);
+        while (value >= 0x80) {
+            data.push_back(char(value | 0x80));
+            value >>= 7;
+        }
+        data.push_back(char(value));
+    }
+
+    /**
+     * Sequentially decodes ids of operations of one page, it starts from the first operation of page
+     */
+    class history_page_reader final {
+    public:
+        history_page_reader(int64_t first_op, const char *data, std::size_t size)
+            : op_(first_op),
+              pos_(data),
+              end_(data + size) {
+        }
+
+        int64_t op() const {
+            return op_;
+        }
+
+        bool next() {
+            if (pos_ == end_) {
+                return false;
+            }
+
+            uint64_t value = 0;
+            for (uint32_t shift = 0; pos_ != end_; shift += 7) {
+                const auto byte = uint8_t(*pos_++);
+                value |= uint64_t(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) {
+                    break;
+                }
+            }
+
+            op_ += int64_t(value >> 1) ^ -int64_t(value & 1);
+            return true;
+        }
+
+    private:
+        int64_t op_;
+        const char *pos_;
+        const char *end_;
+    };
+
+} } } // graphene::plugins::account_history
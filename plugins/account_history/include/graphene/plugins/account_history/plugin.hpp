@@ -51,6 +51,7 @@ namespace graphene { namespace plugins { namespace account_history {
     using plugins::json_rpc::msg_pack_transfer;
 
     DEFINE_API_ARGS(get_account_history, msg_pack, get_account_history_return_type)
+    DEFINE_API_ARGS(get_account_history_by_types, msg_pack, get_account_history_return_type)
 
    /**
     *  This plugin is designed to track a range of operations by account so that one node
@@ -88,6 +89,15 @@ namespace graphene { namespace plugins { namespace account_history {
              *  @param limit - the maximum number of items that can be queried (0 to 1000], must be less than from
              */
             (get_account_history)
+
+            /**
+             *  Returns the most recent operations of the specified types with sequence numbers not greater than from
+             *
+             *  @param from - the absolute sequence number, -1 means most recent
+             *  @param limit - the maximum number of returned operations (0 to 10000]
+             *  @param op_types - names of operation types, for example ["transfer_operation"]
+             */
+            (get_account_history_by_types)
         )
 
     private:
@@ -32,44 +32,28 @@ if( options.count(name) ) { \
 }
 //
 
-    struct operation_visitor final {
-        operation_visitor(
-            graphene::chain::database& db,
-            const graphene::chain::operation_notification& op_note,
-            std::string op_account)
-            : database(db),
-              note(op_note),
-              account(op_account){
+    struct operation_name_visitor final {
+        operation_name_visitor(std::map<std::string, uint16_t>& names_map, uint16_t op_type)
+            : names(names_map),
+              type(op_type) {
         }
 
         using result_type = void;
 
-        graphene::chain::database& database;
-        const graphene::chain::operation_notification& note;
-        std::string account;
-
-        template<typename Op>
-        void operator()(Op &&) const {
-            const auto& idx = database.get_index<account_history_index>().indices().get<by_account>();
-
-            auto itr = idx.lower_bound(std::make_tuple(account, uint32_t(-1)));
-            uint32_t sequence = 0;
-            if (itr != idx.end() && itr->account == account) {
-                sequence = itr->sequence + 1;
-            }
+        std::map<std::string, uint16_t>& names;
+        uint16_t type;
 
-            database.create<account_history_object>([&](account_history_object& history) {
-                history.account = account;
-                history.sequence = sequence;
-                history.op = operation_history::operation_id_type(note.db_id);
-            });
+        template <typename T>
+        void operator()(const T&) const {
+            names[fc::get_typename<T>::name()] = type;
         }
     };
 
     struct plugin::plugin_impl final {
     public:
         plugin_impl( )
-            : database(appbase::app().get_plugin<chain::plugin>().db()) {
+            : database(appbase::app().get_plugin<chain::plugin>().db()),
+              history(appbase::app().get_plugin<operation_history::plugin>()) {
         }
 
         ~plugin_impl() = default;
@@ -87,9 +71,158 @@ if( options.count(name) ) { \
                 if (!tracked_accounts.size() ||
                     (itr != tracked_accounts.end() && itr->first <= item && item <= itr->second)
                 ) {
-                    note.op.visit(operation_visitor(database, note, item));
+                    const auto sequence = add_operation(item, note.db_id);
+                    add_operation_type(item, note.op.which(), sequence);
+                }
+            }
+        }
+
+        // Returns sequence number of operation of account
+        uint32_t add_operation(const account_name_type& account, int64_t op) {
+            const auto& idx = database.get_index<account_history_page_index>().indices().get<by_account>();
+
+            // Pages are ordered from the last one
+            auto itr = idx.lower_bound(std::make_tuple(account));
+            if (itr != idx.end() && itr->account == account && itr->count < account_history_page_size) {
+                database.modify(*itr, [&](account_history_page_object& page) {
+                    append_history_delta(page.data, op - page.last_op);
+                    page.last_op = op;
+                    ++page.count;
+                });
+                return itr->last_sequence();
+            }
+
+            uint32_t page_num = 0;
+            if (itr != idx.end() && itr->account == account) {
+                page_num = itr->page + 1;
+            }
+
+            database.create<account_history_page_object>([&](account_history_page_object& page) {
+                page.account = account;
+                page.page = page_num;
+                page.count = 1;
+                page.first_op = op;
+                page.last_op = op;
+            });
+            return page_num * account_history_page_size;
+        }
+
+        void add_operation_type(const account_name_type& account, uint16_t op_type, uint32_t sequence) {
+            const auto& idx = database.get_index<account_history_type_bitmap_index>().indices().get<by_account_type>();
+            const auto chunk = sequence / account_history_bitmap_chunk_size;
+            const uint16_t offset = sequence % account_history_bitmap_chunk_size;
+
+            auto itr = idx.find(std::make_tuple(account, op_type, chunk));
+            if (itr != idx.end()) {
+                database.modify(*itr, [&](account_history_type_bitmap_object& bitmap) {
+                    add_to_history_bitmap(bitmap.data, bitmap.count, offset);
+                });
+                return;
+            }
+
+            database.create<account_history_type_bitmap_object>([&](account_history_type_bitmap_object& bitmap) {
+                bitmap.account = account;
+                bitmap.op_type = op_type;
+                bitmap.chunk = chunk;
+                add_to_history_bitmap(bitmap.data, bitmap.count, offset);
+            });
+        }
+
+        // Returns sequence number of the last operation of account
+        fc::optional<uint32_t> last_sequence(const account_name_type& account) const {
+            const auto& idx = database.get_index<account_history_page_index>().indices().get<by_account>();
+            auto itr = idx.lower_bound(std::make_tuple(account));
+            if (itr == idx.end() || itr->account != account) {
+                return {};
+            }
+            return itr->last_sequence();
+        }
+
+        // Fills ids of operations by the ascending sequence numbers, pages are decoded only once
+        void find_operations(
+            const account_name_type& account,
+            const std::vector<uint32_t>& sequences,
+            std::map<uint32_t, applied_operation>& result
+        ) {
+            const auto& idx = database.get_index<account_history_page_index>().indices().get<by_account>();
+
+            auto seq_itr = sequences.begin();
+            while (seq_itr != sequences.end()) {
+                auto itr = idx.find(std::make_tuple(account, *seq_itr / account_history_page_size));
+                FC_ASSERT(itr != idx.end(), "Page of account history is lost", ("account", account)("sequence", *seq_itr));
+
+                history_page_reader reader(itr->first_op, itr->data.data(), itr->data.size());
+                auto sequence = itr->first_sequence();
+                const auto last = itr->last_sequence();
+                for (; seq_itr != sequences.end() && *seq_itr <= last; ++seq_itr) {
+                    while (sequence < *seq_itr && reader.next()) {
+                        ++sequence;
+                    }
+                    result[sequence] = history.get_operation(operation_history::operation_id_type(reader.op()));
+                }
+            }
+        }
+
+        uint16_t operation_type(const std::string& name) const {
+            static const auto types = []() {
+                std::map<std::string, uint16_t> result;
+                operation op;
+                for (int i = 0; i < operation::count(); ++i) {
+                    op.set_which(i);
+                    op.visit(operation_name_visitor(result, i));
+                }
+                return result;
+            }();
+
+            auto itr = types.find(NAMESPACE_PREFIX + name);
+            FC_ASSERT(itr != types.end(), "Unknown operation ${n}", ("n", name));
+            return itr->second;
+        }
+
+        std::map<uint32_t, applied_operation> get_account_history_by_types(
+            const std::string& account,
+            uint64_t from,
+            uint32_t limit,
+            const std::vector<std::string>& op_types
+        ) {
+            FC_ASSERT(limit <= 10000, "Limit of ${l} is greater than maxmimum allowed", ("l", limit));
+            FC_ASSERT(!op_types.empty(), "At least one operation type should be specified");
+
+            fc::flat_set<uint16_t> types;
+            for (const auto& name: op_types) {
+                types.insert(operation_type(name));
+            }
+
+            std::map<uint32_t, applied_operation> result;
+            auto last_seq = last_sequence(account);
+            if (!last_seq.valid() || limit == 0) {
+                return result;
+            }
+            const uint32_t last = std::min<uint64_t>(from, *last_seq);
+
+            // The most recent `limit` sequences of each type, then the most recent `limit` of all of them
+            std::vector<uint32_t> sequences;
+            const auto& idx = database.get_index<account_history_type_bitmap_index>().indices().get<by_account_type>();
+            for (auto type: types) {
+                uint32_t found = 0;
+                auto itr = idx.lower_bound(std::make_tuple(account, type, last / account_history_bitmap_chunk_size));
+                for (; itr != idx.end() && itr->account == account && itr->op_type == type && found < limit; ++itr) {
+                    const auto base = itr->chunk * account_history_bitmap_chunk_size;
+                    for_each_history_bitmap_desc(itr->data.data(), itr->count, last - base, [&](uint32_t offset) {
+                        sequences.push_back(base + offset);
+                        return ++found < limit;
+                    });
                 }
             }
+
+            std::sort(sequences.begin(), sequences.end(), std::greater<uint32_t>());
+            if (sequences.size() > limit) {
+                sequences.resize(limit);
+            }
+            std::reverse(sequences.begin(), sequences.end());
+
+            find_operations(account, sequences, result);
+            return result;
         }
 
         std::map<uint32_t, applied_operation> get_account_history(
@@ -99,24 +232,49 @@ if( options.count(name) ) { \
         ) {
             FC_ASSERT(limit <= 10000, "Limit of ${l} is greater than maxmimum allowed", ("l", limit));
             FC_ASSERT(from >= limit, "From must be greater than limit");
-            //   idump((account)(from)(limit));
-            const auto& idx = database.get_index<account_history_index>().indices().get<by_account>();
-            auto itr = idx.lower_bound(std::make_tuple(account, from));
-            //   if( itr != idx.end() ) idump((*itr));
-            auto end = idx.upper_bound(std::make_tuple(account, std::max(int64_t(0), int64_t(itr->sequence) - limit)));
-            //   if( end != idx.end() ) idump((*end));
-
             std::map<uint32_t, applied_operation> result;
-            for (; itr != end; ++itr) {
-                result[itr->sequence] = database.get(itr->op);
+
+            const auto& idx = database.get_index<account_history_page_index>().indices().get<by_account>();
+            auto itr = idx.lower_bound(std::make_tuple(account));
+            if (itr == idx.end() || itr->account != account) {
+                return result;
+            }
+
+            const uint32_t last = std::min<uint64_t>(from, itr->last_sequence());
+            const uint32_t first = std::max(int64_t(0), int64_t(last) - limit);
+
+            // Pages are ordered from the last one, so the scan goes from the last needed page to the first one
+            itr = idx.lower_bound(std::make_tuple(account, last / account_history_page_size));
+            for (; itr != idx.end() && itr->account == account && itr->last_sequence() >= first; ++itr) {
+                history_page_reader reader(itr->first_op, itr->data.data(), itr->data.size());
+                auto sequence = itr->first_sequence();
+                do {
+                    if (sequence >= first && sequence <= last) {
+                        result[sequence] = history.get_operation(operation_history::operation_id_type(reader.op()));
+                    }
+                    ++sequence;
+                } while (sequence <= last && reader.next());
             }
             return result;
         }
 
         fc::flat_map<std::string, std::string> tracked_accounts;
         graphene::chain::database& database;
+        operation_history::plugin& history;
     };
 
+    DEFINE_API(plugin, get_account_history_by_types) {
+        CHECK_ARG_SIZE(4)
+        auto account = args.args->at(0).as<std::string>();
+        auto from = args.args->at(1).as<uint64_t>();
+        auto limit = args.args->at(2).as<uint32_t>();
+        auto op_types = args.args->at(3).as<std::vector<std::string>>();
+
+        return pimpl->database.with_weak_read_lock([&]() {
+            return pimpl->get_account_history_by_types(account, from, limit, op_types);
+        });
+    }
+
     DEFINE_API(plugin, get_account_history) {
         CHECK_ARG_SIZE(3)
         auto account = args.args->at(0).as<std::string>();
@@ -370,7 +528,8 @@ if( options.count(name) ) { \
             pimpl->on_operation(note);
         });
 
-        graphene::chain::add_plugin_index<account_history_index>(pimpl->database);
+        graphene::chain::add_plugin_index<account_history_page_index>(pimpl->database);
+        graphene::chain::add_plugin_index<account_history_type_bitmap_index>(pimpl->database);
 
         using pairstring = std::pair<std::string, std::string>;
         LOAD_VALUE_SET(options, "track-account-range", pimpl->tracked_accounts, pairstring);
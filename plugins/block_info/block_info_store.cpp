@@ -0,0 +1,143 @@
+#include <graphene/plugins/block_info/block_info_store.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <cstring>
+#include <fstream>
+
+namespace graphene {
+namespace plugins {
+namespace block_info {
+
+struct block_info_store::record {
+    uint64_t aslot;
+    char block_id[20];
+    uint32_t block_size;
+    uint32_t average_block_size;
+    uint32_t last_irreversible_block_num;
+};
+
+struct block_info_store::header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t head_block_num;
+};
+
+static_assert(sizeof(graphene::chain::block_id_type) == 20, "Unexpected size of block id");
+
+namespace {
+    constexpr uint64_t store_magic = 0x4f464e494b4c4256ULL; // "VBLKINFO"
+    constexpr uint32_t store_version = 1;
+    constexpr uint32_t grow_records = 100000;
+} // namespace
+
+block_info_store::block_info_store() = default;
+
+block_info_store::~block_info_store() {
+    close();
+}
+
+void block_info_store::open(const fc::path& file) { try {
+    static_assert(sizeof(record) == 40, "Records should have the fixed size on all platforms");
+    static_assert(sizeof(header) <= sizeof(record), "Header should fit into the first record");
+
+    close();
+    path_ = file.string();
+
+    const bool exists = boost::filesystem::is_regular_file(path_) && boost::filesystem::file_size(path_) > 0;
+    if (!exists) {
+        boost::filesystem::create_directories(boost::filesystem::path(path_).parent_path());
+        std::ofstream stream(path_, std::ios::out | std::ios::binary);
+        stream.close();
+        boost::filesystem::resize_file(path_, sizeof(record) * grow_records);
+    }
+
+    file_.open(path_, boost::iostreams::mapped_file::readwrite);
+
+    auto& h = get_header();
+    if (!exists) {
+        h.magic = store_magic;
+        h.version = store_version;
+        h.record_size = sizeof(record);
+        h.head_block_num = 0;
+        return;
+    }
+
+    FC_ASSERT(file_.size() >= sizeof(record), "Block info file ${f} is too small", ("f", path_));
+    FC_ASSERT(h.magic == store_magic && h.version == store_version && h.record_size == sizeof(record),
+        "Block info file ${f} has unknown format, remove it to create a new one", ("f", path_));
+    FC_ASSERT(file_.size() / sizeof(record) > h.head_block_num,
+        "Block info file ${f} is truncated, remove it to create a new one", ("f", path_));
+} FC_LOG_AND_RETHROW() }
+
+void block_info_store::close() {
+    if (file_.is_open()) {
+        file_.close();
+    }
+}
+
+bool block_info_store::is_open() const {
+    return file_.is_open();
+}
+
+uint32_t block_info_store::head_block_num() const {
+    return get_header().head_block_num;
+}
+
+block_info_store::header& block_info_store::get_header() const {
+    return *reinterpret_cast<header*>(file_.data());
+}
+
+block_info_store::record& block_info_store::get_record(uint32_t block_num) const {
+    return *reinterpret_cast<record*>(file_.data() + std::size_t(block_num) * sizeof(record));
+}
+
+void block_info_store::reserve(uint32_t block_num) {
+    const auto records = file_.size() / sizeof(record);
+    if (block_num < records) {
+        return;
+    }
+
+    // The file is remapped, so references to records are invalidated
+    const auto size = (std::size_t(block_num) + grow_records) * sizeof(record);
+    file_.resize(size);
+}
+
+void block_info_store::write(uint32_t block_num, const block_info& info) {
+    FC_ASSERT(block_num > 0);
+
+    reserve(block_num);
+
+    auto& r = get_record(block_num);
+    r.aslot = info.aslot;
+    std::memcpy(r.block_id, info.block_id.data(), sizeof(r.block_id));
+    r.block_size = info.block_size;
+    r.average_block_size = info.average_block_size;
+    r.last_irreversible_block_num = info.last_irreversible_block_num;
+
+    // After switching to a shorter fork records of popped blocks are unreachable
+    get_header().head_block_num = block_num;
+}
+
+void block_info_store::truncate(uint32_t block_num) {
+    auto& h = get_header();
+    if (block_num < h.head_block_num) {
+        h.head_block_num = block_num;
+    }
+}
+
+block_info block_info_store::read(uint32_t block_num) const {
+    FC_ASSERT(block_num > 0 && block_num <= head_block_num());
+
+    const auto& r = get_record(block_num);
+    block_info info;
+    info.aslot = r.aslot;
+    std::memcpy(info.block_id.data(), r.block_id, sizeof(r.block_id));
+    info.block_size = r.block_size;
+    info.average_block_size = r.average_block_size;
+    info.last_irreversible_block_num = r.last_irreversible_block_num;
+    return info;
+}
+
+} } } // graphene::plugins::block_info
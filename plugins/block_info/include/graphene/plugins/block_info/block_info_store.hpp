@@ -0,0 +1,56 @@
+#pragma once
+
+#include <graphene/plugins/block_info/block_info.hpp>
+
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <fc/filesystem.hpp>
+
+namespace graphene {
+namespace plugins {
+namespace block_info {
+
+/**
+ * Persistent storage of block_info in a memory-mapped file with fixed-size records,
+ * the record of block is at the offset of block_num * record size.
+ *
+ * The first record is the header with the number of the last written block. Records of popped blocks
+ * are overwritten by blocks of the new fork. The file grows by chunks of records, so it isn't remapped
+ * on each block.
+ */
+class block_info_store final {
+public:
+    block_info_store();
+
+    ~block_info_store();
+
+    void open(const fc::path& file);
+
+    void close();
+
+    bool is_open() const;
+
+    /// Number of the last written block, 0 if there are no records
+    uint32_t head_block_num() const;
+
+    void write(uint32_t block_num, const block_info& info);
+
+    /// Forgets records after the block, e.g. if the state of chain is older than the file
+    void truncate(uint32_t block_num);
+
+    block_info read(uint32_t block_num) const;
+
+private:
+    struct header;
+    struct record;
+
+    header& get_header() const;
+
+    record& get_record(uint32_t block_num) const;
+
+    void reserve(uint32_t block_num);
+
+    boost::iostreams::mapped_file file_;
+    std::string path_;
+};
+
+} } } // graphene::plugins::block_info
@@ -1,6 +1,7 @@
 #include <graphene/chain/database.hpp>
 
 #include <graphene/plugins/block_info/plugin.hpp>
+#include <graphene/plugins/block_info/block_info_store.hpp>
 
 #include <graphene/protocol/types.hpp>
 #include <graphene/plugins/json_rpc/utility.hpp>
@@ -28,14 +29,23 @@ public:
     // PLUGIN_METHODS
     void on_applied_block(const protocol::signed_block &b);
 
+    void fill_missing_blocks();
+
+    optional<signed_block> read_block(uint32_t block_num) const;
+
+    // Records after the head of chain aren't applied yet, they can be left from a fork
+    uint32_t head_block_num() const {
+        return std::min(store_.head_block_num(), db_.head_block_num());
+    }
+
     // HELPING METHODS
     graphene::chain::database &database() {
         return db_;
     }
 // protected:
     boost::signals2::scoped_connection applied_block_conn_;
+    block_info_store store_;
 private:
-    std::vector<block_info> block_info_;
 
     graphene::chain::database & db_;
 };
@@ -45,12 +55,12 @@ std::vector<block_info> plugin::plugin_impl::get_block_info(uint32_t start_block
 
     FC_ASSERT(start_block_num > 0);
     FC_ASSERT(count <= 10000);
-    uint32_t n = std::min(uint32_t(block_info_.size()),
-    start_block_num + count);
+    uint64_t n = std::min(uint64_t(head_block_num()) + 1,
+    uint64_t(start_block_num) + count);
 
     for (uint32_t block_num = start_block_num;
         block_num < n; block_num++) {
-        result.emplace_back(block_info_[block_num]);
+        result.emplace_back(store_.read(block_num));
     }
 
     return result;
@@ -59,39 +69,85 @@ std::vector<block_info> plugin::plugin_impl::get_block_info(uint32_t start_block
 std::vector<block_with_info> plugin::plugin_impl::get_blocks_with_info(
         uint32_t start_block_num, uint32_t count) {
     std::vector<block_with_info> result;
-    const auto & db = database();
 
     FC_ASSERT(start_block_num > 0);
     FC_ASSERT(count <= 10000);
-    uint32_t n = std::min( uint32_t( block_info_.size() ), start_block_num + count );
+    uint64_t n = std::min( uint64_t( head_block_num() ) + 1, uint64_t( start_block_num ) + count );
 
     uint64_t total_size = 0;
     for (uint32_t block_num = start_block_num;
          block_num < n; block_num++) {
+        auto info = store_.read(block_num);
         uint64_t new_size =
-                total_size + block_info_[block_num].block_size;
+                total_size + info.block_size;
         if ((new_size > 8 * 1024 * 1024) &&
             (block_num != start_block_num)) {
                 break;
         }
+        auto block = read_block(block_num);
+        if (!block) {
+            break;
+        }
         total_size = new_size;
         result.emplace_back();
-        result.back().block = *db.fetch_block_by_number(block_num);
-        result.back().info = block_info_[block_num];
+        result.back().block = std::move(*block);
+        result.back().info = info;
     }
 
     return result;
 }
 
+optional<signed_block> plugin::plugin_impl::read_block(uint32_t block_num) const {
+    // Irreversible blocks are read from the block log directly, without the lookup in the fork database
+    const auto &db = db_;
+    if (block_num <= db.last_non_undoable_block_num()) {
+        auto block = db.get_block_log().read_block_by_num(block_num);
+        if (block) {
+            return block;
+        }
+    }
+    return db.fetch_block_by_number(block_num);
+}
+
+void plugin::plugin_impl::fill_missing_blocks() {
+    auto &db = database();
+    const auto head_block_num = db.head_block_num();
+
+    // The state of chain can be older than the file, e.g. after a replay or a restore of shared memory
+    if (store_.head_block_num() > head_block_num) {
+        wlog("Block info is ahead of the chain, dropping records from ${f} to ${h}",
+            ("f", head_block_num + 1)("h", store_.head_block_num()));
+        store_.truncate(head_block_num);
+    }
+
+    const auto first_block_num = store_.head_block_num() + 1;
+    if (first_block_num > head_block_num) {
+        return;
+    }
+
+    // Properties of the time of applying are unknown for blocks applied without the plugin,
+    // so only id and size are restored for them
+    ilog("Filling block info of blocks from ${f} to ${h}", ("f", first_block_num)("h", head_block_num));
+    for (uint32_t block_num = first_block_num; block_num <= head_block_num; ++block_num) {
+        auto block = read_block(block_num);
+        FC_ASSERT(block.valid(), "Block ${n} not found", ("n", block_num));
+
+        block_info info;
+        info.block_id = block->id();
+        info.block_size = fc::raw::pack_size(*block);
+        store_.write(block_num, info);
+
+        if (block_num % 100000 == 0) {
+            ilog("Filled block info up to block ${n}", ("n", block_num));
+        }
+    }
+}
+
 void plugin::plugin_impl::on_applied_block(const protocol::signed_block &b) {
     uint32_t block_num = b.block_num();
     const auto &db = appbase::app().get_plugin<chain::plugin>().db();
 
-    while (block_num >= block_info_.size()) {
-        block_info_.emplace_back();
-    }
-
-    block_info &info = block_info_[block_num];
+    block_info info;
     const dynamic_global_property_object &dgpo = db.get_dynamic_global_properties();
 
     info.block_id = b.id();
@@ -99,6 +155,7 @@ void plugin::plugin_impl::on_applied_block(const protocol::signed_block &b) {
     info.average_block_size = dgpo.average_block_size;
     info.aslot = dgpo.current_aslot;
     info.last_irreversible_block_num = dgpo.last_irreversible_block_num;
+    store_.write(block_num, info);
     return;
 }
 
@@ -137,6 +194,9 @@ void plugin::plugin_initialize(const boost::program_options::variables_map &opti
 
     my.reset(new plugin_impl);
 
+    // Records are applied with blocks during replay, so the file is opened before the start of chain
+    my->store_.open(appbase::app().data_dir() / "blockchain" / "block_info");
+
     my->applied_block_conn_ = db.applied_block.connect([this](const protocol::signed_block &b) {
         on_applied_block(b);
     });
@@ -145,9 +205,11 @@ void plugin::plugin_initialize(const boost::program_options::variables_map &opti
 }
 
 void plugin::plugin_startup() {
+    my->fill_missing_blocks();
 }
 
 void plugin::plugin_shutdown() {
+    my->store_.close();
 }
 
 } } } // graphene::plugin::block_info
@@ -0,0 +1,207 @@
+#include <graphene/plugins/chain/applied_block_queue.hpp>
+
+namespace graphene { namespace plugins { namespace chain {
+
+    applied_block_subscription::applied_block_subscription(
+        std::string name, applied_block_delivery delivery, applied_block_content content,
+        std::size_t max_queue_size, applied_block_handler handler)
+        : name_(std::move(name)),
+          delivery_(delivery),
+          content_(content),
+          max_queue_size_(std::max(max_queue_size, std::size_t(1))),
+          handler_(std::move(handler)) {
+    }
+
+    applied_block_subscription::~applied_block_subscription() {
+        stop();
+    }
+
+    void applied_block_subscription::start() {
+        boost::lock_guard<boost::mutex> guard(mutex_);
+        if (thread_.joinable()) {
+            return;
+        }
+        stopping_ = false;
+        thread_ = boost::thread([this]() { run(); });
+    }
+
+    void applied_block_subscription::stop() {
+        {
+            boost::lock_guard<boost::mutex> guard(mutex_);
+            stopping_ = true;
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    void applied_block_subscription::push(applied_block_event event) {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        if (queue_.size() >= max_queue_size_ && !stopping_) {
+            ++producer_waits_;
+            if (producer_waits_ % 1000 == 1) {
+                wlog("Subscriber ${n} of applied blocks is slow, waited for it ${w} times",
+                    ("n", name_)("w", producer_waits_.load()));
+            }
+            not_full_.wait(lock, [&]() { return queue_.size() < max_queue_size_ || stopping_; });
+        }
+        if (stopping_) {
+            return;
+        }
+
+        queue_.push_back(std::move(event));
+        lock.unlock();
+        not_empty_.notify_one();
+    }
+
+    std::size_t applied_block_subscription::queue_size() const {
+        boost::lock_guard<boost::mutex> guard(mutex_);
+        return queue_.size();
+    }
+
+    void applied_block_subscription::run() {
+        while (true) {
+            applied_block_event event;
+            {
+                boost::unique_lock<boost::mutex> lock(mutex_);
+                not_empty_.wait(lock, [&]() { return !queue_.empty() || stopping_; });
+                if (queue_.empty()) {
+                    return;
+                }
+                event = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            not_full_.notify_one();
+
+            try {
+                handler_(event);
+            } catch (const fc::exception &e) {
+                elog("Subscriber ${n} failed on block ${b}: ${e}", ("n", name_)("b", event.block_num)("e", e.to_detail_string()));
+            } catch (const std::exception &e) {
+                elog("Subscriber ${n} failed on block ${b}: ${e}", ("n", name_)("b", event.block_num)("e", e.what()));
+            }
+            ++processed_;
+        }
+    }
+
+    void applied_block_dispatcher::add(applied_block_subscription_ptr subscription) {
+        has_irreversible_ |= (subscription->delivery() == applied_block_delivery::irreversible);
+        subscriptions_.push_back(std::move(subscription));
+    }
+
+    void applied_block_dispatcher::connect(graphene::chain::database &db) {
+        db.pre_apply_block.connect([this](const signed_block &block) {
+            on_pre_apply_block(block);
+        });
+        db.post_apply_operation.connect([this](const graphene::chain::operation_notification &note) {
+            on_operation(note);
+        });
+        db.applied_block.connect([this, &db](const signed_block &block) {
+            on_applied_block(block, db.get_dynamic_global_properties().last_irreversible_block_num);
+        });
+    }
+
+    void applied_block_dispatcher::start() {
+        for (auto &subscription: subscriptions_) {
+            subscription->start();
+        }
+    }
+
+    void applied_block_dispatcher::stop() {
+        for (auto &subscription: subscriptions_) {
+            subscription->stop();
+        }
+        reversible_.clear();
+    }
+
+    void applied_block_dispatcher::on_pre_apply_block(const signed_block &block) {
+        applying_block_num_ = block.block_num();
+        collect_operations_ = (wanted_content() == applied_block_content::operations);
+        operations_.clear();
+    }
+
+    void applied_block_dispatcher::on_operation(const graphene::chain::operation_notification &note) {
+        // Operations of pending transactions aren't part of any block
+        if (!collect_operations_ || note.block != applying_block_num_) {
+            return;
+        }
+
+        block_operation op;
+        op.trx_id = note.trx_id;
+        op.trx_in_block = note.trx_in_block;
+        op.op_in_trx = note.op_in_trx;
+        op.virtual_op = note.virtual_op;
+        op.op = note.op;
+        operations_.push_back(std::move(op));
+    }
+
+    void applied_block_dispatcher::on_applied_block(const signed_block &block, uint32_t last_irreversible_block_num) {
+        const auto block_num = block.block_num();
+
+        // Blocks after the previous head were popped by switching to a fork
+        while (!reversible_.empty() && reversible_.back().block_num >= block_num) {
+            applied_block_event event;
+            event.type = applied_block_event_type::rolled_back;
+            event.block_num = reversible_.back().block_num;
+            event.block_id = reversible_.back().block_id;
+            dispatch(event, applied_block_delivery::reversible);
+            reversible_.pop_back();
+        }
+
+        // Only ids are kept for inactive subscriptions, they are needed to detect switching to a fork
+        applied_block_event event;
+        event.block_num = block_num;
+        event.block_id = block.id();
+        if (wanted_content() != applied_block_content::nothing) {
+            event.block = std::make_shared<const signed_block>(block);
+        }
+        if (collect_operations_ && applying_block_num_ == block_num) {
+            event.operations = std::make_shared<const std::vector<block_operation>>(std::move(operations_));
+        }
+        operations_.clear();
+        applying_block_num_ = 0;
+        collect_operations_ = false;
+
+        dispatch(event, applied_block_delivery::reversible);
+        reversible_.push_back(std::move(event));
+
+        while (!reversible_.empty() && reversible_.front().block_num <= last_irreversible_block_num) {
+            if (has_irreversible_) {
+                dispatch(reversible_.front(), applied_block_delivery::irreversible);
+            }
+            reversible_.pop_front();
+        }
+    }
+
+    void applied_block_dispatcher::dispatch(const applied_block_event &event, applied_block_delivery delivery) {
+        for (auto &subscription: subscriptions_) {
+            if (subscription->delivery() != delivery) {
+                continue;
+            }
+
+            const auto content = subscription->content();
+            if (content == applied_block_content::nothing) {
+                continue;
+            }
+            // Subscription was activated after the block started to apply, it doesn't get an incomplete block
+            if (event.type == applied_block_event_type::applied && (!event.block ||
+                (content == applied_block_content::operations && !event.operations))
+            ) {
+                continue;
+            }
+            subscription->push(event);
+        }
+    }
+
+    applied_block_content applied_block_dispatcher::wanted_content() const {
+        auto result = applied_block_content::nothing;
+        for (const auto &subscription: subscriptions_) {
+            result = std::max(result, subscription->content());
+        }
+        return result;
+    }
+
+} } } // graphene::plugins::chain
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <graphene/protocol/block.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/operation_notification.hpp>
+
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace graphene { namespace plugins { namespace chain {
+
+    using graphene::protocol::signed_block;
+    using graphene::protocol::block_id_type;
+
+    struct block_operation final {
+        protocol::transaction_id_type trx_id;
+        uint32_t trx_in_block = 0;
+        uint16_t op_in_trx = 0;
+        uint32_t virtual_op = 0;
+        protocol::operation op;
+    };
+
+    enum class applied_block_event_type : uint8_t {
+        applied,    ///< block with all its operations was applied
+        rolled_back ///< previously delivered block was removed from the chain by switching to a fork
+    };
+
+    struct applied_block_event final {
+        applied_block_event_type type = applied_block_event_type::applied;
+        uint32_t block_num = 0;
+        block_id_type block_id;
+        std::shared_ptr<const signed_block> block;                       ///< isn't set for rolled_back
+        std::shared_ptr<const std::vector<block_operation>> operations;  ///< set only if subscription wants them
+    };
+
+    /**
+     * What subscriber wants to receive, the dispatcher collects only what at least one subscriber wants
+     */
+    enum class applied_block_content : uint8_t {
+        nothing,   ///< subscription is inactive, events aren't pushed to it
+        block,     ///< applied blocks without operations
+        operations ///< applied blocks with all their operations (including virtual)
+    };
+
+    /**
+     * Which blocks are delivered to subscriber
+     */
+    enum class applied_block_delivery : uint8_t {
+        reversible,  ///< every applied block, and rolled_back events on switching to a fork
+        irreversible ///< only blocks which became irreversible, they are never rolled back
+    };
+
+    using applied_block_handler = std::function<void(const applied_block_event &)>;
+
+    /**
+     * Ordered bounded queue of applied blocks, which are processed by the handler on the own thread of subscription.
+     *
+     * If the queue is full, the write thread of database waits for the subscriber,
+     * so the subscriber never misses blocks, but a slow subscriber slows down applying of blocks.
+     *
+     * The content can be changed at any time, e.g. a subscription is inactive while it has no consumers.
+     * After a change the subscriber gets only blocks, which started to apply after it, and it can get
+     * rolled_back events for blocks which it didn't receive.
+     */
+    class applied_block_subscription final {
+    public:
+        applied_block_subscription(
+            std::string name, applied_block_delivery delivery, applied_block_content content,
+            std::size_t max_queue_size, applied_block_handler handler);
+
+        ~applied_block_subscription();
+
+        const std::string &name() const {
+            return name_;
+        }
+
+        applied_block_delivery delivery() const {
+            return delivery_;
+        }
+
+        applied_block_content content() const {
+            return content_.load(std::memory_order_relaxed);
+        }
+
+        void set_content(applied_block_content content) {
+            content_.store(content, std::memory_order_relaxed);
+        }
+
+        void start();
+
+        // Processes the rest of queue and stops the thread
+        void stop();
+
+        // Is called from the write thread of database
+        void push(applied_block_event event);
+
+        std::size_t queue_size() const;
+
+        uint64_t processed() const {
+            return processed_.load(std::memory_order_relaxed);
+        }
+
+        // How many times the write thread of database waited for free space in the queue
+        uint64_t producer_waits() const {
+            return producer_waits_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        void run();
+
+        std::string name_;
+        applied_block_delivery delivery_;
+        std::atomic<applied_block_content> content_;
+        std::size_t max_queue_size_;
+        applied_block_handler handler_;
+
+        mutable boost::mutex mutex_;
+        boost::condition_variable not_empty_;
+        boost::condition_variable not_full_;
+        std::deque<applied_block_event> queue_;
+        bool stopping_ = false;
+        boost::thread thread_;
+
+        std::atomic<uint64_t> processed_ = {0};
+        std::atomic<uint64_t> producer_waits_ = {0};
+    };
+
+    using applied_block_subscription_ptr = std::shared_ptr<applied_block_subscription>;
+
+    /**
+     * Collects applied blocks with their operations and dispatches them to subscriptions.
+     * Blocks are copied only if some subscription is active, operations only if some subscription wants them.
+     */
+    class applied_block_dispatcher final {
+    public:
+        void add(applied_block_subscription_ptr subscription);
+
+        bool empty() const {
+            return subscriptions_.empty();
+        }
+
+        void connect(graphene::chain::database &db);
+
+        void start();
+
+        void stop();
+
+    private:
+        void on_pre_apply_block(const signed_block &block);
+
+        void on_operation(const graphene::chain::operation_notification &note);
+
+        void on_applied_block(const signed_block &block, uint32_t last_irreversible_block_num);
+
+        void dispatch(const applied_block_event &event, applied_block_delivery delivery);
+
+        applied_block_content wanted_content() const;
+
+        std::vector<applied_block_subscription_ptr> subscriptions_;
+        bool has_irreversible_ = false;
+
+        // Applied blocks, which aren't irreversible yet
+        std::deque<applied_block_event> reversible_;
+
+        // Operations of the block which is being applied
+        uint32_t applying_block_num_ = 0;
+        bool collect_operations_ = false;
+        std::vector<block_operation> operations_;
+    };
+
+} } } // graphene::plugins::chain
+
+FC_REFLECT((graphene::plugins::chain::block_operation), (trx_id)(trx_in_block)(op_in_trx)(virtual_op)(op))
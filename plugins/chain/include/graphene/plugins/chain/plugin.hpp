@@ -9,6 +9,7 @@
 
 #include <graphene/plugins/json_rpc/utility.hpp>
 #include <graphene/plugins/json_rpc/plugin.hpp>
+#include <graphene/plugins/chain/applied_block_queue.hpp>
 // for api
 #include <fc/optional.hpp>
 
@@ -43,12 +44,46 @@ namespace graphene {
 
                 bool accept_block(const protocol::signed_block &block, bool currently_syncing = false, uint32_t skip = 0);
 
+                /**
+                 * Accepts the block, which signee is already recovered. If the block is pushed on top of the head,
+                 * the signee is compared with the signing key of witness instead of recovering it again.
+                 */
+                bool accept_block(
+                    const protocol::signed_block &block, bool currently_syncing, uint32_t skip,
+                    const fc::optional<fc::ecc::public_key> &signee);
+
                 void accept_transaction(const protocol::signed_transaction &trx);
 
+                /**
+                 * Accepts transactions, which operations are validated and signatures are recovered beforehand,
+                 * all of them are pushed under one acquisition of the write lock.
+                 * Returns errors of rejected transactions in the same order.
+                 */
+                std::vector<fc::oexception> accept_transactions(
+                    const std::vector<protocol::signed_transaction> &trxs,
+                    const std::vector<fc::flat_set<protocol::public_key_type>> &signature_keys);
+
                 bool block_is_on_preferred_chain(const protocol::block_id_type &block_id);
 
                 void check_time_in_block(const protocol::signed_block &block);
 
+                /**
+                 * Subscribes to applied blocks with their operations, the handler is called on the own thread
+                 * of subscription, so plugins which derive secondary data into their own storage
+                 * don't slow down applying of blocks under the write lock.
+                 *
+                 * Operations are collected only if the content asks for them, the content can be changed later
+                 * by the returned subscription, e.g. to not copy blocks while there is nobody to process them.
+                 *
+                 * Should be called in plugin_initialize(), blocks are delivered since plugin_startup() of this plugin.
+                 */
+                applied_block_subscription_ptr subscribe_applied_blocks(
+                        const std::string &name,
+                        applied_block_delivery delivery,
+                        applied_block_content content,
+                        std::size_t max_queue_size,
+                        applied_block_handler handler);
+
                 template<typename MultiIndexType>
                 bool has_index() const {
                     return db().has_index<MultiIndexType>();
@@ -1,6 +1,7 @@
 #include <graphene/chain/database_exceptions.hpp>
 #include <graphene/chain/database.hpp>
 #include <graphene/plugins/chain/plugin.hpp>
+#include <graphene/plugins/json_rpc/metrics.hpp>
 
 #include <fc/io/json.hpp>
 #include <fc/string.hpp>
@@ -54,6 +55,8 @@ namespace chain {
 
         bool single_write_thread = false;
 
+        applied_block_dispatcher applied_blocks;
+
         plugin_impl() {
             // get default settings
             read_wait_micro = db.read_wait_micro();
@@ -79,8 +82,13 @@ namespace chain {
         }
 
         void check_time_in_block(const protocol::signed_block &block);
-        bool accept_block(const protocol::signed_block &block, bool currently_syncing, uint32_t skip);
+        bool accept_block(
+            const protocol::signed_block &block, bool currently_syncing, uint32_t skip,
+            const fc::optional<fc::ecc::public_key> &signee);
         void accept_transaction(const protocol::signed_transaction &trx);
+        std::vector<fc::oexception> accept_transactions(
+            const std::vector<protocol::signed_transaction> &trxs,
+            const std::vector<fc::flat_set<protocol::public_key_type>> &signature_keys);
         void wipe_db(const bfs::path &data_dir, bool wipe_block_log);
         void replay_db(const bfs::path &data_dir, bool force_replay);
     };
@@ -93,7 +101,10 @@ namespace chain {
         FC_ASSERT(block.timestamp.sec_since_epoch() <= max_accept_time);
     }
 
-    bool plugin::plugin_impl::accept_block(const protocol::signed_block &block, bool currently_syncing, uint32_t skip) {
+    bool plugin::plugin_impl::accept_block(
+        const protocol::signed_block &block, bool currently_syncing, uint32_t skip,
+        const fc::optional<fc::ecc::public_key> &signee
+    ) {
         if (currently_syncing && block.block_num() % 10000 == 0) {
             ilog("Syncing Blockchain --- Got block: #${n} time: ${t} producer: ${p}",
                  ("t", block.timestamp)("n", block.block_num())("p", block.witness));
@@ -109,14 +120,14 @@ namespace chain {
 
             io_service().post([&]{
                 try {
-                    promise.set_value(db.push_block(block, skip));
+                    promise.set_value(db.push_block(block, skip, signee));
                 } catch(...) {
                     promise.set_exception(std::current_exception());
                 }
             });
             return result.get(); // if an exception was, it will be thrown
         } else {
-            return db.push_block(block, skip);
+            return db.push_block(block, skip, signee);
         }
     }
 
@@ -166,6 +177,27 @@ namespace chain {
         }
     }
 
+    std::vector<fc::oexception> plugin::plugin_impl::accept_transactions(
+        const std::vector<protocol::signed_transaction> &trxs,
+        const std::vector<fc::flat_set<protocol::public_key_type>> &signature_keys
+    ) {
+        if (single_write_thread) {
+            std::promise<std::vector<fc::oexception>> promise;
+            auto result = promise.get_future();
+
+            io_service().post([&]{
+                try {
+                    promise.set_value(db.push_transactions(trxs, signature_keys));
+                } catch(...) {
+                    promise.set_exception(std::current_exception());
+                }
+            });
+            return result.get(); // if an exception was, it will be thrown
+        } else {
+            return db.push_transactions(trxs, signature_keys);
+        }
+    }
+
     plugin::plugin() {
     }
 
@@ -332,6 +364,8 @@ namespace chain {
         my->db.set_write_wait_micro(my->write_wait_micro);
         my->db.set_max_write_wait_retries(my->max_write_wait_retries);
 
+        my->db.set_read_lock_wait_observer(&json_rpc::record_lock_wait);
+
         my->db.set_inc_shared_memory_size(my->inc_shared_memory_size);
         my->db.set_min_free_shared_memory_size(my->min_free_shared_memory_size);
 
@@ -345,6 +379,11 @@ namespace chain {
 
         my->db.enable_plugins_on_push_transaction(my->enable_plugins_on_push_transaction);
 
+        if (!my->applied_blocks.empty()) {
+            my->applied_blocks.connect(my->db);
+            my->applied_blocks.start();
+        }
+
         try {
             ilog("Opening shared memory from ${path}", ("path", my->shared_memory_dir.generic_string()));
             my->db.open(data_dir, my->shared_memory_dir, CHAIN_INIT_SUPPLY, my->shared_memory_size, chainbase::database::read_write/*, my->validate_invariants*/ );
@@ -390,19 +429,35 @@ namespace chain {
     }
 
     void plugin::plugin_shutdown() {
+        my->applied_blocks.stop();
+
         ilog("closing chain database");
         my->db.close();
         ilog("database closed successfully");
     }
 
     bool plugin::accept_block(const protocol::signed_block &block, bool currently_syncing, uint32_t skip) {
-        return my->accept_block(block, currently_syncing, skip);
+        return my->accept_block(block, currently_syncing, skip, fc::optional<fc::ecc::public_key>());
+    }
+
+    bool plugin::accept_block(
+        const protocol::signed_block &block, bool currently_syncing, uint32_t skip,
+        const fc::optional<fc::ecc::public_key> &signee
+    ) {
+        return my->accept_block(block, currently_syncing, skip, signee);
     }
 
     void plugin::accept_transaction(const protocol::signed_transaction &trx) {
         my->accept_transaction(trx);
     }
 
+    std::vector<fc::oexception> plugin::accept_transactions(
+        const std::vector<protocol::signed_transaction> &trxs,
+        const std::vector<fc::flat_set<protocol::public_key_type>> &signature_keys
+    ) {
+        return my->accept_transactions(trxs, signature_keys);
+    }
+
     bool plugin::block_is_on_preferred_chain(const protocol::block_id_type &block_id) {
         // If it's not known, it's not preferred.
         if (!db().is_known_block(block_id)) {
@@ -418,6 +473,19 @@ namespace chain {
         my->check_time_in_block(block);
     }
 
+    applied_block_subscription_ptr plugin::subscribe_applied_blocks(
+        const std::string &name,
+        applied_block_delivery delivery,
+        applied_block_content content,
+        std::size_t max_queue_size,
+        applied_block_handler handler
+    ) {
+        auto subscription = std::make_shared<applied_block_subscription>(
+            name, delivery, content, max_queue_size, std::move(handler));
+        my->applied_blocks.add(subscription);
+        return subscription;
+    }
+
 }
 }
 } // namespace graphene::plugis::chain::chain_apis
@@ -1,4 +1,5 @@
 #include <graphene/plugins/database_api/plugin.hpp>
+#include <graphene/plugins/database_api/block_applied_hub.hpp>
 
 #include <graphene/plugins/follow/plugin.hpp>
 
@@ -24,33 +25,6 @@ namespace graphene { namespace plugins { namespace database_api {
 
 using protocol::share_type;
 
-struct block_applied_callback_info {
-    using ptr = std::shared_ptr<block_applied_callback_info>;
-    using cont = std::list<ptr>;
-
-    block_applied_callback callback;
-    boost::signals2::connection connection;
-    cont::iterator it;
-
-    void connect(
-        boost::signals2::signal<void(const signed_block &)> &sig,
-        cont &free_cont,
-        block_applied_callback cb
-    ) {
-        callback = cb;
-
-        connection = sig.connect([this, &free_cont](const signed_block &block) {
-            try {
-                this->callback(fc::variant(block));
-            } catch (...) {
-                free_cont.push_back(*this->it);
-                this->connection.disconnect();
-            }
-        });
-    }
-};
-
-
 struct plugin::api_impl final {
 public:
     api_impl();
@@ -62,8 +36,6 @@ public:
     // Subscriptions
     void set_subscribe_callback(std::function<void(const variant &)> cb, bool clear_filter);
     void set_pending_transaction_callback(std::function<void(const variant &)> cb);
-    void set_block_applied_callback(block_applied_callback cb);
-    void clear_block_applied_callback();
     void cancel_all_subscriptions();
 
     // Blocks and transactions
@@ -125,8 +97,7 @@ public:
         return _db;
     }
 
-    block_applied_callback_info::cont active_block_applied_callback;
-    block_applied_callback_info::cont free_block_applied_callback;
+    block_applied_hub block_applied;
 
 private:
 
@@ -241,40 +212,27 @@ optional<signed_block> plugin::api_impl::get_block(uint32_t block_num) const {
 DEFINE_API(plugin, set_block_applied_callback) {
     CHECK_ARG_SIZE(1)
 
+    auto mode = block_applied_mode::block;
+    const auto &type = args.args->at(0);
+    if (type.is_string()) {
+        const auto &value = type.get_string();
+        if (value == "header") {
+            mode = block_applied_mode::header;
+        } else if (value == "operations") {
+            mode = block_applied_mode::operations;
+        }
+    }
+
     // Delegate connection handlers to callback
     msg_pack_transfer transfer(args);
 
-    my->database().with_weak_read_lock([&]{
-        my->set_block_applied_callback([msg = transfer.msg()](const fc::variant & block_header) {
-            msg->unsafe_result(fc::variant(block_header));
-        });
-    });
+    my->block_applied.subscribe(transfer.msg(), mode);
 
     transfer.complete();
 
     return {};
 }
 
-void plugin::api_impl::set_block_applied_callback(std::function<void(const variant &block_header)> callback) {
-    auto info_ptr = std::make_shared<block_applied_callback_info>();
-
-    active_block_applied_callback.push_back(info_ptr);
-    info_ptr->it = std::prev(active_block_applied_callback.end());
-
-    info_ptr->connect(database().applied_block, free_block_applied_callback, callback);
-}
-
-void plugin::api_impl::clear_block_applied_callback() {
-    for (auto &info: free_block_applied_callback) {
-        active_block_applied_callback.erase(info->it);
-    }
-    free_block_applied_callback.clear();
-}
-
-void plugin::clear_block_applied_callback() {
-    my->clear_block_applied_callback();
-}
-
 //////////////////////////////////////////////////////////////////////
 //                                                                  //
 // Globals                                                          //
@@ -834,18 +792,47 @@ DEFINE_API(plugin, get_proposed_transactions) {
     });
 }
 
+void plugin::set_program_options(boost::program_options::options_description &cli, boost::program_options::options_description &cfg) {
+    cfg.add_options()
+        ("block-applied-callback-threads", boost::program_options::value<uint32_t>()->default_value(2),
+            "Number of threads which send applied blocks to subscribers of set_block_applied_callback")
+        ("block-applied-callback-queue-size", boost::program_options::value<uint32_t>()->default_value(32),
+            "Maximum number of undelivered applied blocks for one subscriber")
+        ("block-applied-callback-slow-policy", boost::program_options::value<std::string>()->default_value("drop"),
+            "What to do with a subscriber when its queue is full: drop (the oldest block) or disconnect");
+}
+
 void plugin::plugin_initialize(const boost::program_options::variables_map &options) {
     ilog("database_api plugin: plugin_initialize() begin");
     my = std::make_unique<api_impl>();
+
+    auto policy = options.at("block-applied-callback-slow-policy").as<std::string>();
+    FC_ASSERT(policy == "drop" || policy == "disconnect",
+        "block-applied-callback-slow-policy should be drop or disconnect, was ${p}", ("p", policy));
+
+    const auto queue_size = options.at("block-applied-callback-queue-size").as<uint32_t>();
+    my->block_applied.configure(
+        options.at("block-applied-callback-threads").as<uint32_t>(),
+        queue_size,
+        policy == "drop" ? slow_subscriber_policy::drop : slow_subscriber_policy::disconnect);
+
     JSON_RPC_REGISTER_API(plugin_name)
-    my->database().applied_block.connect([this](const protocol::signed_block &) {
-        this->clear_block_applied_callback();
-    });
+    // The subscription is inactive until the first call of set_block_applied_callback
+    my->block_applied.set_subscription(appbase::app().get_plugin<chain::plugin>().subscribe_applied_blocks(
+        plugin_name, chain::applied_block_delivery::reversible, chain::applied_block_content::nothing, queue_size,
+        [this](const chain::applied_block_event &event) {
+            my->block_applied.on_applied_block(event);
+        }));
     ilog("database_api plugin: plugin_initialize() end");
 }
 
 void plugin::plugin_startup() {
     my->startup();
+    my->block_applied.start();
+}
+
+void plugin::plugin_shutdown() {
+    my->block_applied.stop();
 }
 
 } } } // graphene::plugins::database_api
@@ -0,0 +1,244 @@
+#include <graphene/plugins/database_api/block_applied_hub.hpp>
+#include <graphene/plugins/json_rpc/plugin.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+namespace graphene { namespace plugins { namespace database_api {
+
+    struct block_applied_hub::subscriber final {
+        subscriber(msg_ptr m, block_applied_mode md)
+            : msg(std::move(m)),
+              mode(md) {
+        }
+
+        msg_ptr msg;
+        block_applied_mode mode;
+
+        // All fields below are guarded by the mutex of hub
+        std::deque<payload_ptr> queue;
+        bool sending = false;
+        bool closed = false;
+        bool too_slow = false;
+        uint64_t dropped = 0;
+    };
+
+    block_applied_hub::block_applied_hub() = default;
+
+    block_applied_hub::~block_applied_hub() {
+        stop();
+    }
+
+    void block_applied_hub::configure(uint32_t threads, uint32_t max_queue_size, slow_subscriber_policy policy) {
+        threads_ = std::max(threads, uint32_t(1));
+        max_queue_size_ = std::max(max_queue_size, uint32_t(1));
+        policy_ = policy;
+    }
+
+    void block_applied_hub::set_subscription(chain::applied_block_subscription_ptr subscription) {
+        boost::lock_guard<boost::mutex> guard(mutex_);
+        subscription_ = std::move(subscription);
+        update_content();
+    }
+
+    void block_applied_hub::start() {
+        work_ = std::make_unique<boost::asio::io_service::work>(ios_);
+        for (uint32_t i = 0; i < threads_; ++i) {
+            thread_pool_.create_thread([this]() { ios_.run(); });
+        }
+    }
+
+    void block_applied_hub::stop() {
+        work_.reset();
+        ios_.stop();
+        thread_pool_.join_all();
+
+        boost::lock_guard<boost::mutex> guard(mutex_);
+        subscribers_.clear();
+        update_content();
+    }
+
+    void block_applied_hub::subscribe(msg_ptr msg, block_applied_mode mode) {
+        auto sub = std::make_shared<subscriber>(std::move(msg), mode);
+
+        boost::lock_guard<boost::mutex> guard(mutex_);
+        subscribers_.push_back(sub);
+        update_content();
+    }
+
+    std::size_t block_applied_hub::subscribers_count() const {
+        boost::lock_guard<boost::mutex> guard(mutex_);
+        return subscribers_.size();
+    }
+
+    void block_applied_hub::on_applied_block(const chain::applied_block_event &event) {
+        // Subscribers don't receive blocks, which are rolled back by switching to a fork
+        if (event.type != chain::applied_block_event_type::applied) {
+            return;
+        }
+
+        std::vector<subscriber_ptr> subscribers;
+        {
+            boost::lock_guard<boost::mutex> guard(mutex_);
+            subscribers.assign(subscribers_.begin(), subscribers_.end());
+        }
+        if (subscribers.empty()) {
+            return;
+        }
+
+        const signed_block &block = *event.block;
+        payload_ptr block_payload;
+        payload_ptr header_payload;
+        payload_ptr operations_payload;
+
+        auto get_payload = [&](block_applied_mode mode) -> payload_ptr {
+            switch (mode) {
+                case block_applied_mode::header:
+                    if (!header_payload) {
+                        const graphene::protocol::signed_block_header &header = block;
+                        header_payload = std::make_shared<const std::string>(fc::json::to_string(fc::variant(header)));
+                    }
+                    return header_payload;
+
+                case block_applied_mode::operations:
+                    if (!operations_payload && event.operations) {
+                        std::vector<applied_operation_info> operations;
+                        operations.reserve(event.operations->size());
+                        for (const auto &op: *event.operations) {
+                            applied_operation_info info;
+                            info.block = event.block_num;
+                            info.trx_id = op.trx_id;
+                            info.trx_in_block = op.trx_in_block;
+                            info.op_in_trx = op.op_in_trx;
+                            info.virtual_op = op.virtual_op;
+                            info.op = op.op;
+                            operations.push_back(std::move(info));
+                        }
+
+                        fc::mutable_variant_object result;
+                        result("block", block)("operations", operations);
+                        operations_payload = std::make_shared<const std::string>(fc::json::to_string(fc::variant(result)));
+                    }
+                    return operations_payload;
+
+                default:
+                    if (!block_payload) {
+                        block_payload = std::make_shared<const std::string>(fc::json::to_string(fc::variant(block)));
+                    }
+                    return block_payload;
+            }
+        };
+
+        for (auto &sub: subscribers) {
+            auto payload = get_payload(sub->mode);
+            // Subscriber came after the block was applied without operations, it gets the next one
+            if (payload) {
+                enqueue(sub, std::move(payload));
+            }
+        }
+    }
+
+    void block_applied_hub::enqueue(const subscriber_ptr &sub, payload_ptr payload) {
+        {
+            boost::lock_guard<boost::mutex> guard(mutex_);
+            if (sub->closed) {
+                return;
+            }
+
+            if (sub->queue.size() >= max_queue_size_) {
+                if (policy_ == slow_subscriber_policy::drop) {
+                    sub->queue.pop_front();
+                    if (++sub->dropped % max_queue_size_ == 1) {
+                        wlog("Slow subscriber of applied blocks, dropped ${n} blocks", ("n", sub->dropped));
+                    }
+                } else {
+                    sub->closed = true;
+                    sub->too_slow = true;
+                    sub->queue.clear();
+                }
+            }
+
+            if (!sub->closed) {
+                sub->queue.push_back(std::move(payload));
+            }
+
+            if (sub->sending) {
+                return;
+            }
+            sub->sending = true;
+        }
+
+        ios_.post([this, sub]() {
+            send_next(sub);
+        });
+    }
+
+    void block_applied_hub::send_next(const subscriber_ptr &sub) {
+        payload_ptr payload;
+        bool too_slow = false;
+        {
+            boost::lock_guard<boost::mutex> guard(mutex_);
+            if (sub->closed) {
+                too_slow = sub->too_slow;
+            } else if (sub->queue.empty()) {
+                sub->sending = false;
+                return;
+            } else {
+                payload = std::move(sub->queue.front());
+                sub->queue.pop_front();
+            }
+        }
+
+        if (!payload) {
+            if (too_slow) {
+                sub->msg->error(JSON_RPC_SERVER_BUSY, "Subscriber can't receive applied blocks in time, unsubscribed");
+            }
+            unsubscribe(sub);
+            return;
+        }
+
+        try {
+            sub->msg->unsafe_raw_result(*payload);
+        } catch (...) {
+            // Connection is closed
+            {
+                boost::lock_guard<boost::mutex> guard(mutex_);
+                sub->closed = true;
+            }
+            unsubscribe(sub);
+            return;
+        }
+
+        ios_.post([this, sub]() {
+            send_next(sub);
+        });
+    }
+
+    void block_applied_hub::unsubscribe(const subscriber_ptr &sub) {
+        boost::lock_guard<boost::mutex> guard(mutex_);
+        auto itr = std::find(subscribers_.begin(), subscribers_.end(), sub);
+        if (itr == subscribers_.end()) {
+            return;
+        }
+
+        subscribers_.erase(itr);
+        update_content();
+    }
+
+    void block_applied_hub::update_content() {
+        if (!subscription_) {
+            return;
+        }
+
+        auto content = chain::applied_block_content::nothing;
+        for (const auto &sub: subscribers_) {
+            if (sub->mode == block_applied_mode::operations) {
+                content = chain::applied_block_content::operations;
+                break;
+            }
+            content = chain::applied_block_content::block;
+        }
+        subscription_->set_content(content);
+    }
+
+} } } // graphene::plugins::database_api
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <graphene/protocol/block.hpp>
+#include <graphene/plugins/chain/applied_block_queue.hpp>
+#include <graphene/plugins/json_rpc/utility.hpp>
+
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace graphene { namespace plugins { namespace database_api {
+
+    using graphene::protocol::signed_block;
+    using graphene::protocol::operation;
+    using graphene::protocol::transaction_id_type;
+
+    /**
+     * What is sent to a subscriber of set_block_applied_callback
+     */
+    enum class block_applied_mode : uint8_t {
+        block,      ///< full signed block
+        header,     ///< only header of block
+        operations  ///< full signed block with all applied operations (including virtual)
+    };
+
+    /**
+     * What to do with subscriber, which can't receive blocks as fast as they are applied
+     */
+    enum class slow_subscriber_policy : uint8_t {
+        drop,       ///< drop the oldest undelivered block
+        disconnect  ///< send error and unsubscribe
+    };
+
+    struct applied_operation_info {
+        uint32_t block = 0;
+        transaction_id_type trx_id;
+        uint32_t trx_in_block = 0;
+        uint16_t op_in_trx = 0;
+        uint32_t virtual_op = 0;
+        operation op;
+    };
+
+    /**
+     * Delivers applied blocks to subscribers of set_block_applied_callback.
+     *
+     * Applied blocks come from the queue of chain plugin, so the write thread of database only copies the block,
+     * serialization happens once per mode on the thread of queue in order of applying,
+     * and the same buffer is sent to all subscribers from the own IO threads.
+     * Each subscriber has a bounded queue of undelivered blocks, so a slow connection can't grow memory usage.
+     * While there are no subscribers the queue is inactive, operations are collected only for `operations` mode.
+     */
+    class block_applied_hub final {
+    public:
+        using msg_ptr = json_rpc::msg_pack_transfer::ptr;
+
+        block_applied_hub();
+
+        ~block_applied_hub();
+
+        void configure(uint32_t threads, uint32_t max_queue_size, slow_subscriber_policy policy);
+
+        // The content of subscription follows modes of subscribers
+        void set_subscription(chain::applied_block_subscription_ptr subscription);
+
+        void start();
+
+        void stop();
+
+        void subscribe(msg_ptr msg, block_applied_mode mode);
+
+        // Is called from the thread of applied blocks subscription
+        void on_applied_block(const chain::applied_block_event &event);
+
+        std::size_t subscribers_count() const;
+
+    private:
+        struct subscriber;
+
+        using subscriber_ptr = std::shared_ptr<subscriber>;
+        using payload_ptr = std::shared_ptr<const std::string>;
+
+        void enqueue(const subscriber_ptr &sub, payload_ptr payload);
+
+        void send_next(const subscriber_ptr &sub);
+
+        void unsubscribe(const subscriber_ptr &sub);
+
+        // Should be called under the mutex
+        void update_content();
+
+        uint32_t threads_ = 1;
+        uint32_t max_queue_size_ = 32;
+        slow_subscriber_policy policy_ = slow_subscriber_policy::drop;
+
+        boost::asio::io_service ios_;
+        std::unique_ptr<boost::asio::io_service::work> work_;
+        boost::thread_group thread_pool_;
+
+        chain::applied_block_subscription_ptr subscription_;
+
+        mutable boost::mutex mutex_;
+        std::list<subscriber_ptr> subscribers_;
+    };
+
+} } } // graphene::plugins::database_api
+
+FC_REFLECT(
+    (graphene::plugins::database_api::applied_operation_info),
+    (block)(trx_id)(trx_in_block)(op_in_trx)(virtual_op)(op))
@@ -119,8 +119,6 @@ struct subaccount_on_sale_api_object {
     }
 };
 
-using block_applied_callback = std::function<void(const variant &block_header)>;
-
 ///               API,                                    args,                return
 DEFINE_API_ARGS(get_block_header,                 msg_pack, optional<block_header>)
 DEFINE_API_ARGS(get_block,                        msg_pack, optional<signed_block>)
@@ -175,13 +173,13 @@ public:
             (chain::plugin)
     )
 
-    void set_program_options(boost::program_options::options_description &cli, boost::program_options::options_description &cfg) override{}
+    void set_program_options(boost::program_options::options_description &cli, boost::program_options::options_description &cfg) override;
 
     void plugin_initialize(const boost::program_options::variables_map &options) override;
 
     void plugin_startup() override;
 
-    void plugin_shutdown() override{}
+    void plugin_shutdown() override;
 
     plugin();
 
@@ -203,12 +201,6 @@ public:
     void cancel_all_subscriptions();
 
 
-    /**
-     * @brief Clear disconnected callbacks on applied block
-     */
-
-    void clear_block_applied_callback();
-
     DECLARE_API(
         /**
          *  This API is a short-cut for returning all of the state required for a particular URL
@@ -236,7 +228,7 @@ public:
 
         /**
          * @brief Set callback which is triggered on each generated block
-         * @param callback function which should be called
+         * @param type what to send: "block" (default), "header" or "operations" (block with all applied operations)
          */
         (set_block_applied_callback)
 
@@ -1,6 +1,7 @@
 #include <graphene/plugins/follow/follow_operations.hpp>
 #include <graphene/plugins/follow/follow_objects.hpp>
 #include <graphene/plugins/follow/follow_evaluators.hpp>
+#include <graphene/plugins/follow/follow_feed.hpp>
 #include <graphene/chain/account_object.hpp>
 #include <graphene/chain/content_object.hpp>
 
@@ -145,47 +146,17 @@ namespace graphene {
                         });
                     }
 
-                    const auto &feed_idx = db().get_index<feed_index>().indices().get<by_feed>();
-                    const auto &content_idx = db().get_index<feed_index>().indices().get<by_content>();
+                    // Followers read reblogs of accounts with many followers from the blog
+                    if (is_feed_pulled(db(), o.account, _plugin->feed_fanout_limit())) {
+                        return;
+                    }
+
                     const auto &idx = db().get_index<follow_index>().indices().get<by_following_follower>();
                     auto itr = idx.find(o.account);
 
                     while (itr != idx.end() && itr->following == o.account) {
-
                         if (itr->what & (1 << blog)) {
-                            uint32_t next_id = 0;
-                            auto last_feed = feed_idx.lower_bound(itr->follower);
-
-                            if (last_feed != feed_idx.end() && last_feed->account == itr->follower) {
-                                next_id = last_feed->account_feed_id + 1;
-                            }
-
-                            auto feed_itr = content_idx.find(boost::make_tuple(c.id, itr->follower));
-
-                            if (feed_itr == content_idx.end()) {
-                                db().create<feed_object>([&](feed_object &f) {
-                                    f.account = itr->follower;
-                                    f.reblogged_by.push_back(o.account);
-                                    f.first_reblogged_by = o.account;
-                                    f.first_reblogged_on = db().head_block_time();
-                                    f.content = c.id;
-                                    f.reblogs = 1;
-                                    f.account_feed_id = next_id;
-                                });
-                            } else {
-                                db().modify(*feed_itr, [&](feed_object &f) {
-                                    f.reblogged_by.push_back(o.account);
-                                    f.reblogs++;
-                                });
-                            }
-
-                            const auto &old_feed_idx = db().get_index<feed_index>().indices().get<by_old_feed>();
-                            auto old_feed = old_feed_idx.lower_bound(itr->follower);
-
-                            while (old_feed->account == itr->follower && next_id - old_feed->account_feed_id > _plugin->max_feed_size()) {
-                                db().remove(*old_feed);
-                                old_feed = old_feed_idx.lower_bound(itr->follower);
-                            };
+                            add_feed_entry(db(), itr->follower, c.id, o.account, _plugin->max_feed_size());
                         }
 
                         ++itr;
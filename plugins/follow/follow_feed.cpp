@@ -0,0 +1,273 @@
+#include <graphene/plugins/follow/follow_feed.hpp>
+#include <graphene/plugins/follow/follow_forward.hpp>
+
+#include <algorithm>
+
+namespace graphene {
+    namespace plugins {
+        namespace follow {
+
+            bool is_feed_pulled(const database &db, const account_name_type &author, uint32_t fanout_limit) {
+                if (fanout_limit == 0) {
+                    return false;
+                }
+
+                const auto *count = db.find<follow_count_object, by_account>(author);
+                return count != nullptr && count->follower_count > fanout_limit;
+            }
+
+            const feed_object &add_feed_entry(
+                    database &db, const account_name_type &follower, content_object::id_type content,
+                    const account_name_type &reblogged_by, uint32_t max_feed_size) {
+                const auto &content_idx = db.get_index<feed_index>().indices().get<by_content>();
+                auto feed_itr = content_idx.find(boost::make_tuple(content, follower));
+
+                if (feed_itr != content_idx.end()) {
+                    if (reblogged_by != account_name_type()) {
+                        db.modify(*feed_itr, [&](feed_object &f) {
+                            f.reblogged_by.push_back(reblogged_by);
+                            f.reblogs++;
+                        });
+                    }
+                    return *feed_itr;
+                }
+
+                const auto &feed_idx = db.get_index<feed_index>().indices().get<by_feed>();
+                uint32_t next_id = 0;
+                auto last_feed = feed_idx.lower_bound(follower);
+
+                if (last_feed != feed_idx.end() && last_feed->account == follower) {
+                    next_id = last_feed->account_feed_id + 1;
+                }
+
+                const auto &feed = db.create<feed_object>([&](feed_object &f) {
+                    f.account = follower;
+                    f.content = content;
+                    f.account_feed_id = next_id;
+                    f.reblogs = 0;
+                    if (reblogged_by != account_name_type()) {
+                        f.reblogged_by.push_back(reblogged_by);
+                        f.first_reblogged_by = reblogged_by;
+                        f.first_reblogged_on = db.head_block_time();
+                        f.reblogs = 1;
+                    }
+                });
+
+                // Old entries are removed by moving the iterator, without a lookup of index after each removal
+                const auto &old_feed_idx = db.get_index<feed_index>().indices().get<by_old_feed>();
+                auto old_feed = old_feed_idx.lower_bound(follower);
+
+                while (old_feed != old_feed_idx.end() && old_feed->account == follower &&
+                       next_id - old_feed->account_feed_id > max_feed_size) {
+                    const auto &removed = *old_feed;
+                    ++old_feed;
+                    db.remove(removed);
+                }
+
+                return feed;
+            }
+
+            feed_reader::feed_reader(
+                    const database &db, const account_name_type &account,
+                    uint32_t start_entry_id, uint32_t fanout_limit,
+                    const content_object *start_content)
+                    : db_(db),
+                      account_(account) {
+                const auto &feed_idx = db_.get_index<feed_index>().indices().get<by_feed>();
+                feed_itr_ = feed_idx.lower_bound(boost::make_tuple(account, start_entry_id));
+                feed_end_ = feed_idx.end();
+
+                collect_pulled_authors(fanout_limit);
+
+                // Entries, which are newer than the start entry, were on the previous pages
+                if (start_content != nullptr) {
+                    start_.time = start_time(*start_content);
+                    start_.content = start_content->id;
+                    has_start_ = true;
+
+                    // Without the position in the stored feed its newer entries are skipped
+                    if (start_entry_id == uint32_t(~0)) {
+                        while (feed_valid() && !is_after_start({entry_time(*feed_itr_), feed_itr_->content})) {
+                            ++feed_itr_;
+                        }
+                    }
+                } else if (start_entry_id != uint32_t(~0)) {
+                    if (feed_valid()) {
+                        start_.time = entry_time(*feed_itr_);
+                        start_.content = feed_itr_->content;
+                    } else {
+                        start_.time = time_point_sec::min();
+                    }
+                    has_start_ = true;
+                }
+
+                const auto &blog_idx = db_.get_index<blog_index>().indices().get<by_blog>();
+                blogs_.reserve(pulled_authors_.size());
+                for (const auto &author: pulled_authors_) {
+                    blog_cursor cursor;
+                    cursor.itr = blog_idx.lower_bound(author);
+                    cursor.account = author;
+                    if (advance_blog(cursor)) {
+                        blogs_.push_back(cursor);
+                    }
+                }
+                std::make_heap(blogs_.begin(), blogs_.end(), [](const blog_cursor &a, const blog_cursor &b) {
+                    return a.key < b.key;
+                });
+
+                next();
+            }
+
+            void feed_reader::collect_pulled_authors(uint32_t fanout_limit) {
+                if (fanout_limit == 0) {
+                    return;
+                }
+
+                const auto *reader = db_.find<follow_count_object, by_account>(account_);
+                if (reader == nullptr || reader->following_count == 0) {
+                    return;
+                }
+
+                const auto &follow_idx = db_.get_index<follow_index>().indices().get<by_follower_following>();
+
+                // Usually there are a few authors with many followers, so they are checked instead of all followed
+                // accounts. If there are more of them than followed accounts, the followed accounts are checked.
+                const auto &count_idx = db_.get_index<follow_count_index>().indices().get<by_followers>();
+                std::vector<account_name_type> popular;
+                bool too_many = false;
+                for (auto itr = count_idx.begin(); itr != count_idx.end() && itr->follower_count > fanout_limit; ++itr) {
+                    if (popular.size() >= reader->following_count) {
+                        too_many = true;
+                        break;
+                    }
+                    popular.push_back(itr->account);
+                }
+
+                if (!too_many) {
+                    for (const auto &author: popular) {
+                        auto itr = follow_idx.find(boost::make_tuple(account_, author));
+                        if (itr != follow_idx.end() && (itr->what & (1 << blog))) {
+                            pulled_authors_.push_back(author);
+                        }
+                    }
+                    return;
+                }
+
+                for (auto itr = follow_idx.lower_bound(account_);
+                     itr != follow_idx.end() && itr->follower == account_; ++itr) {
+                    if ((itr->what & (1 << blog)) && is_feed_pulled(db_, itr->following, fanout_limit)) {
+                        pulled_authors_.push_back(itr->following);
+                    }
+                }
+            }
+
+            bool feed_reader::feed_valid() const {
+                return feed_itr_ != feed_end_ && feed_itr_->account == account_;
+            }
+
+            bool feed_reader::advance_blog(blog_cursor &cursor) const {
+                const auto &blog_idx = db_.get_index<blog_index>().indices().get<by_blog>();
+                for (; cursor.itr != blog_idx.end() && cursor.itr->account == cursor.account; ++cursor.itr) {
+                    cursor.key.time = entry_time(*cursor.itr);
+                    cursor.key.content = cursor.itr->content;
+                    if (is_after_start(cursor.key)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            time_point_sec feed_reader::start_time(const content_object &content) const {
+                bool found = false;
+                time_point_sec result;
+
+                const auto &feed_idx = db_.get_index<feed_index>().indices().get<by_content>();
+                auto feed_itr = feed_idx.find(boost::make_tuple(content.id, account_));
+                if (feed_itr != feed_idx.end()) {
+                    result = entry_time(*feed_itr);
+                    found = true;
+                }
+
+                const auto &blog_idx = db_.get_index<blog_index>().indices().get<by_content>();
+                for (const auto &author: pulled_authors_) {
+                    auto blog_itr = blog_idx.find(boost::make_tuple(content.id, author));
+                    if (blog_itr != blog_idx.end()) {
+                        auto time = entry_time(*blog_itr);
+                        if (!found || result < time) {
+                            result = time;
+                            found = true;
+                        }
+                    }
+                }
+
+                return found ? result : content.created;
+            }
+
+            time_point_sec feed_reader::entry_time(const feed_object &feed) const {
+                if (feed.first_reblogged_by != account_name_type()) {
+                    return feed.first_reblogged_on;
+                }
+                return db_.get(feed.content).created;
+            }
+
+            time_point_sec feed_reader::entry_time(const blog_object &item) const {
+                if (item.reblogged_on != time_point_sec()) {
+                    return item.reblogged_on;
+                }
+                return db_.get(item.content).created;
+            }
+
+            void feed_reader::next() {
+                const auto blog_less = [](const blog_cursor &a, const blog_cursor &b) {
+                    return a.key < b.key;
+                };
+
+                valid_ = false;
+                while (feed_valid() || !blogs_.empty()) {
+                    merged_feed_entry entry;
+
+                    const bool has_feed = feed_valid();
+                    entry_key feed_key;
+                    if (has_feed) {
+                        feed_key.time = entry_time(*feed_itr_);
+                        feed_key.content = feed_itr_->content;
+                    }
+
+                    if (has_feed && (blogs_.empty() || !(feed_key < blogs_.front().key))) {
+                        const auto &feed = *feed_itr_;
+                        ++feed_itr_;
+
+                        entry.content = feed.content;
+                        entry.time = feed_key.time;
+                        entry.entry_id = feed.account_feed_id;
+                        entry.feed = &feed;
+                    } else {
+                        std::pop_heap(blogs_.begin(), blogs_.end(), blog_less);
+                        auto &cursor = blogs_.back();
+                        const auto &item = *cursor.itr;
+
+                        entry.content = item.content;
+                        entry.time = cursor.key.time;
+                        entry.entry_id = has_feed ? feed_itr_->account_feed_id : 0;
+                        entry.blog = &item;
+
+                        ++cursor.itr;
+                        if (advance_blog(cursor)) {
+                            std::push_heap(blogs_.begin(), blogs_.end(), blog_less);
+                        } else {
+                            blogs_.pop_back();
+                        }
+                    }
+
+                    // The same content can be in the stored feed and in blogs of a few authors
+                    if (seen_.insert(entry.content).second) {
+                        current_ = entry;
+                        valid_ = true;
+                        return;
+                    }
+                }
+            }
+
+        }
+    }
+} // graphene::plugins::follow
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <graphene/plugins/follow/follow_objects.hpp>
+#include <graphene/chain/database.hpp>
+
+#include <set>
+#include <vector>
+
+namespace graphene {
+    namespace plugins {
+        namespace follow {
+            using graphene::chain::database;
+
+            /**
+             * Posts and reblogs of authors with more than fanout_limit followers aren't copied into feeds of followers,
+             * they are merged from blogs of authors on reading of feed. fanout_limit == 0 disables the limit.
+             */
+            bool is_feed_pulled(const database &db, const account_name_type &author, uint32_t fanout_limit);
+
+            /**
+             * Adds the content to the stored feed of follower and removes entries which are out of max_feed_size
+             *
+             * @return the created or updated entry
+             */
+            const feed_object &add_feed_entry(
+                    database &db, const account_name_type &follower, content_object::id_type content,
+                    const account_name_type &reblogged_by, uint32_t max_feed_size);
+
+            struct merged_feed_entry final {
+                content_object::id_type content;
+                time_point_sec time;
+
+                /// For entries from blogs it's the id of the next older entry of the stored feed,
+                /// the next page starts from it and from the content of the last entry
+                uint32_t entry_id = 0;
+
+                const feed_object *feed = nullptr; ///< entry of the stored feed
+                const blog_object *blog = nullptr; ///< entry of blog of author, which isn't fanned out
+            };
+
+            /**
+             * Reads the feed of account from newer entries to older ones: the k-way merge of the stored feed
+             * and blogs of followed authors, which aren't fanned out. Entries are ordered by (time, content id).
+             *
+             * A page starts from the entry of start_content, or from the stored entry start_entry_id
+             * if start_content is null. The stored feed is read from start_entry_id, blogs are read
+             * from the start entry. If only start_content is given, newer stored entries are skipped.
+             * Should be used under the read lock of database.
+             */
+            class feed_reader final {
+            public:
+                feed_reader(
+                        const database &db, const account_name_type &account,
+                        uint32_t start_entry_id, uint32_t fanout_limit,
+                        const content_object *start_content = nullptr);
+
+                bool valid() const {
+                    return valid_;
+                }
+
+                const merged_feed_entry &current() const {
+                    return current_;
+                }
+
+                void next();
+
+                /// Authors, whose blogs are merged into the feed
+                const std::vector<account_name_type> &pulled_authors() const {
+                    return pulled_authors_;
+                }
+
+            private:
+                using feed_iterator = feed_index::index<by_feed>::type::const_iterator;
+                using blog_iterator = blog_index::index<by_blog>::type::const_iterator;
+
+                /// Position in the merged feed
+                struct entry_key final {
+                    time_point_sec time;
+                    content_object::id_type content;
+
+                    bool operator<(const entry_key &other) const {
+                        return time < other.time || (time == other.time && content < other.content);
+                    }
+                };
+
+                struct blog_cursor final {
+                    blog_iterator itr;
+                    account_name_type account;
+                    entry_key key;
+                };
+
+                void collect_pulled_authors(uint32_t fanout_limit);
+
+                bool feed_valid() const;
+
+                bool advance_blog(blog_cursor &cursor) const;
+
+                /// The newest position of the content in the feed, it can be in the stored feed and in a few blogs
+                time_point_sec start_time(const content_object &content) const;
+
+                bool is_after_start(const entry_key &key) const {
+                    return !has_start_ || !(start_ < key);
+                }
+
+                time_point_sec entry_time(const feed_object &feed) const;
+
+                time_point_sec entry_time(const blog_object &blog) const;
+
+                const database &db_;
+                account_name_type account_;
+
+                feed_iterator feed_itr_;
+                feed_iterator feed_end_;
+
+                // Heap of blogs by the key of the current entry
+                std::vector<blog_cursor> blogs_;
+                entry_key start_;
+                bool has_start_ = false;
+
+                std::vector<account_name_type> pulled_authors_;
+                std::set<content_object::id_type> seen_;
+
+                merged_feed_entry current_;
+                bool valid_ = false;
+            };
+
+        }
+    }
+} // graphene::plugins::follow
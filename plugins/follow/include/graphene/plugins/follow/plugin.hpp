@@ -39,6 +39,8 @@ namespace graphene { namespace plugins { namespace follow {
                 (get_followers)
                 (get_following)
                 (get_follow_count)
+                        /// Args: account, start_entry_id, limit[, start_author, start_permlink].
+                        /// Entries from blogs of popular authors are paged by author and permlink of the last entry
                 (get_feed_entries)
                 (get_feed)
                 (get_blog_entries)
@@ -58,6 +60,9 @@ namespace graphene { namespace plugins { namespace follow {
 
         uint32_t max_feed_size();
 
+        /// Authors with more followers aren't copied into feeds, see is_feed_pulled()
+        uint32_t feed_fanout_limit();
+
         void plugin_startup() override;
 
         void plugin_shutdown() override {}
@@ -1,6 +1,7 @@
 #include <graphene/plugins/follow/follow_objects.hpp>
 #include <graphene/plugins/follow/follow_operations.hpp>
 #include <graphene/plugins/follow/follow_evaluators.hpp>
+#include <graphene/plugins/follow/follow_feed.hpp>
 #include <graphene/protocol/config.hpp>
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/generic_custom_operation_interpreter.hpp>
@@ -14,6 +15,12 @@
 #define CHECK_ARG_SIZE(s) \
    FC_ASSERT( args.args->size() == s, "Expected #s argument(s), was ${n}", ("n", args.args->size()) );
 
+#define CHECK_ARG_MIN_SIZE(_S, _M) \
+   FC_ASSERT( args.args->size() >= _S && args.args->size() <= _M, "Expected #_S (maximum #_M) argument(s), was ${n}", ("n", args.args->size()) );
+
+#define GET_OPTIONAL_ARG(_I, _T, _D) \
+   (args.args->size() > _I) ? (args.args->at(_I).as<_T>()) : static_cast<_T>(_D)
+
 namespace graphene {
     namespace plugins {
         namespace follow {
@@ -119,40 +126,19 @@ namespace graphene {
                             return;
                         }
 
-                        const auto &idx = db.get_index<follow_index>().indices().get<by_following_follower>();
-                        const auto &content_idx = db.get_index<feed_index>().indices().get<by_content>();
-                        auto itr = idx.find(op.author);
-
-                        const auto &feed_idx = db.get_index<feed_index>().indices().get<by_feed>();
+                        // Posts of authors with many followers aren't copied into feeds,
+                        // they are merged from the blog on reading of feed
+                        if (!is_feed_pulled(db, op.author, _plugin.feed_fanout_limit())) {
+                            const auto &idx = db.get_index<follow_index>().indices().get<by_following_follower>();
+                            auto itr = idx.find(op.author);
 
-                        while (itr != idx.end() && itr->following == op.author) {
-                            if (itr->what & (1 << blog)) {
-                                uint32_t next_id = 0;
-                                auto last_feed = feed_idx.lower_bound(itr->follower);
-
-                                if (last_feed != feed_idx.end() && last_feed->account == itr->follower) {
-                                    next_id = last_feed->account_feed_id + 1;
+                            while (itr != idx.end() && itr->following == op.author) {
+                                if (itr->what & (1 << blog)) {
+                                    add_feed_entry(db, itr->follower, c.id, account_name_type(), _plugin.max_feed_size());
                                 }
 
-                                if (content_idx.find(boost::make_tuple(c.id, itr->follower)) == content_idx.end()) {
-                                    db.create<feed_object>([&](feed_object &f) {
-                                        f.account = itr->follower;
-                                        f.content = c.id;
-                                        f.account_feed_id = next_id;
-                                    });
-
-                                    const auto &old_feed_idx = db.get_index<feed_index>().indices().get<by_old_feed>();
-                                    auto old_feed = old_feed_idx.lower_bound(itr->follower);
-
-                                    while (old_feed->account == itr->follower &&
-                                           next_id - old_feed->account_feed_id > _plugin.max_feed_size()) {
-                                        db.remove(*old_feed);
-                                        old_feed = old_feed_idx.lower_bound(itr->follower);
-                                    }
-                                }
+                                ++itr;
                             }
-
-                            ++itr;
                         }
 
                         const auto &blog_idx = db.get_index<blog_index>().indices().get<by_blog>();
@@ -174,10 +160,11 @@ namespace graphene {
                             const auto &old_blog_idx = db.get_index<blog_index>().indices().get<by_old_blog>();
                             auto old_blog = old_blog_idx.lower_bound(op.author);
 
-                            while (old_blog->account == op.author &&
+                            while (old_blog != old_blog_idx.end() && old_blog->account == op.author &&
                                    next_id - old_blog->blog_feed_id > _plugin.max_feed_size()) {
-                                db.remove(*old_blog);
-                                old_blog = old_blog_idx.lower_bound(op.author);
+                                const auto &removed = *old_blog;
+                                ++old_blog;
+                                db.remove(removed);
                             }
                         }
                     } FC_LOG_AND_RETHROW()
@@ -193,6 +180,20 @@ namespace graphene {
                 }
             }
 
+            template<typename FeedEntry>
+            void set_reblog(FeedEntry &entry, const merged_feed_entry &item) {
+                if (item.feed != nullptr && item.feed->first_reblogged_by != account_name_type()) {
+                    entry.reblog_by.reserve(item.feed->reblogged_by.size());
+                    for (const auto &a : item.feed->reblogged_by) {
+                        entry.reblog_by.push_back(a);
+                    }
+                    entry.reblog_on = item.feed->first_reblogged_on;
+                } else if (item.blog != nullptr && item.blog->reblogged_on != time_point_sec()) {
+                    entry.reblog_by.push_back(item.blog->account);
+                    entry.reblog_on = item.blog->reblogged_on;
+                }
+            }
+
             struct plugin::impl final {
             public:
                 impl() : database_(appbase::app().get_plugin<chain::plugin>().db()) {
@@ -254,7 +255,9 @@ namespace graphene {
                 std::vector<feed_entry> get_feed_entries(
                         account_name_type account,
                         uint32_t start_entry_id = 0,
-                        uint32_t limit = 500);
+                        uint32_t limit = 500,
+                        const std::string &start_author = std::string(),
+                        const std::string &start_permlink = std::string());
 
                 std::vector<blog_entry> get_blog_entries(
                         account_name_type account,
@@ -264,7 +267,9 @@ namespace graphene {
                 std::vector<content_feed_entry> get_feed(
                         account_name_type account,
                         uint32_t start_entry_id = 0,
-                        uint32_t limit = 500);
+                        uint32_t limit = 500,
+                        const std::string &start_author = std::string(),
+                        const std::string &start_permlink = std::string());
 
                 std::vector<content_blog_entry> get_blog(
                         account_name_type account,
@@ -283,6 +288,8 @@ namespace graphene {
 
                 uint32_t max_feed_size_ = 500;
 
+                uint32_t feed_fanout_limit_ = 10000;
+
                 std::shared_ptr<generic_custom_operation_interpreter<
                         follow::follow_plugin_operation>> _custom_operation_interpreter;
             };
@@ -295,7 +302,10 @@ namespace graphene {
                                                     boost::program_options::options_description &cfg) {
                 cli.add_options()
                     ("follow-max-feed-size", boost::program_options::value<uint32_t>()->default_value(500),
-                        "Set the maximum size of cached feed for an account");
+                        "Set the maximum size of cached feed for an account")
+                    ("follow-feed-fanout-limit", boost::program_options::value<uint32_t>()->default_value(10000),
+                        "Posts of authors with more followers aren't copied into feeds, they are merged on reading "
+                        "of feed from the blog of author (0 - copy posts of all authors)");
                 cfg.add(cli);
             }
 
@@ -323,6 +333,10 @@ namespace graphene {
                         pimpl->max_feed_size_ = feed_size;
                     }
 
+                    if (options.count("follow-feed-fanout-limit")) {
+                        pimpl->feed_fanout_limit_ = options["follow-feed-fanout-limit"].as<uint32_t>();
+                    }
+
                     JSON_RPC_REGISTER_API ( name() ) ;
                 } FC_CAPTURE_AND_RETHROW()
             }
@@ -334,6 +348,10 @@ namespace graphene {
                 return pimpl->max_feed_size_;
             }
 
+            uint32_t plugin::feed_fanout_limit() {
+                return pimpl->feed_fanout_limit_;
+            }
+
             plugin::~plugin() {
 
             }
@@ -406,7 +424,9 @@ namespace graphene {
             std::vector<feed_entry> plugin::impl::get_feed_entries(
                     account_name_type account,
                     uint32_t entry_id,
-                    uint32_t limit) {
+                    uint32_t limit,
+                    const std::string &start_author,
+                    const std::string &start_permlink) {
                 FC_ASSERT(limit <= 500, "Cannot retrieve more than 500 feed entries at a time.");
 
                 if (entry_id == 0) {
@@ -417,26 +437,21 @@ namespace graphene {
                 result.reserve(limit);
 
                 const auto &db = database();
-                const auto &feed_idx = db.get_index<feed_index>().indices().get<by_feed>();
-                auto itr = feed_idx.lower_bound(boost::make_tuple(account, entry_id));
+                const content_object *start_content = nullptr;
+                if (!start_author.empty()) {
+                    start_content = &db.get_content(start_author, start_permlink);
+                }
+                feed_reader reader(db, account, entry_id, feed_fanout_limit_, start_content);
 
-                while (itr != feed_idx.end() && itr->account == account && result.size() < limit) {
-                    const auto &content = db.get(itr->content);
+                for (; reader.valid() && result.size() < limit; reader.next()) {
+                    const auto &item = reader.current();
+                    const auto &content = db.get(item.content);
                     feed_entry entry;
                     entry.author = content.author;
                     entry.permlink = to_string(content.permlink);
-                    entry.entry_id = itr->account_feed_id;
-                    if (itr->first_reblogged_by != account_name_type()) {
-                        entry.reblog_by.reserve(itr->reblogged_by.size());
-                        for (const auto &a : itr->reblogged_by) {
-                            entry.reblog_by.push_back(a);
-                        }
-                        //entry.reblog_by = itr->first_reblogged_by;
-                        entry.reblog_on = itr->first_reblogged_on;
-                    }
+                    entry.entry_id = item.entry_id;
+                    set_reblog(entry, item);
                     result.push_back(entry);
-
-                    ++itr;
                 }
 
                 return result;
@@ -445,7 +460,9 @@ namespace graphene {
             std::vector<content_feed_entry> plugin::impl::get_feed(
                     account_name_type account,
                     uint32_t entry_id,
-                    uint32_t limit) {
+                    uint32_t limit,
+                    const std::string &start_author,
+                    const std::string &start_permlink) {
                 FC_ASSERT(limit <= 500, "Cannot retrieve more than 500 feed entries at a time.");
 
                 if (entry_id == 0) {
@@ -456,25 +473,20 @@ namespace graphene {
                 result.reserve(limit);
 
                 const auto &db = database();
-                const auto &feed_idx = db.get_index<feed_index>().indices().get<by_feed>();
-                auto itr = feed_idx.lower_bound(boost::make_tuple(account, entry_id));
+                const content_object *start_content = nullptr;
+                if (!start_author.empty()) {
+                    start_content = &db.get_content(start_author, start_permlink);
+                }
+                feed_reader reader(db, account, entry_id, feed_fanout_limit_, start_content);
 
-                while (itr != feed_idx.end() && itr->account == account && result.size() < limit) {
-                    const auto &content = db.get(itr->content);
+                for (; reader.valid() && result.size() < limit; reader.next()) {
+                    const auto &item = reader.current();
+                    const auto &content = db.get(item.content);
                     content_feed_entry entry;
                     entry.content = content_api_object(content, db);
-                    entry.entry_id = itr->account_feed_id;
-                    if (itr->first_reblogged_by != account_name_type()) {
-                        //entry.reblog_by = itr->first_reblogged_by;
-                        entry.reblog_by.reserve(itr->reblogged_by.size());
-                        for (const auto &a : itr->reblogged_by) {
-                            entry.reblog_by.push_back(a);
-                        }
-                        entry.reblog_on = itr->first_reblogged_on;
-                    }
+                    entry.entry_id = item.entry_id;
+                    set_reblog(entry, item);
                     result.push_back(entry);
-
-                    ++itr;
                 }
 
                 return result;
@@ -604,23 +616,27 @@ namespace graphene {
                 });
             }
 
-            DEFINE_API(plugin, get_feed_entries){
-                CHECK_ARG_SIZE(3)
+            DEFINE_API(plugin, get_feed_entries) {
+                CHECK_ARG_MIN_SIZE(3, 5)
                 auto account = args.args->at(0).as<account_name_type>();
                 auto entry_id = args.args->at(1).as<uint32_t>();
                 auto limit = args.args->at(2).as<uint32_t>();
+                auto start_author = GET_OPTIONAL_ARG(3, std::string, "");
+                auto start_permlink = GET_OPTIONAL_ARG(4, std::string, "");
                 return pimpl->database().with_weak_read_lock([&]() {
-                    return pimpl->get_feed_entries(account, entry_id, limit);
+                    return pimpl->get_feed_entries(account, entry_id, limit, start_author, start_permlink);
                 });
             }
 
             DEFINE_API(plugin, get_feed) {
-                CHECK_ARG_SIZE(3)
+                CHECK_ARG_MIN_SIZE(3, 5)
                 auto account = args.args->at(0).as<account_name_type>();
                 auto entry_id = args.args->at(1).as<uint32_t>();
                 auto limit = args.args->at(2).as<uint32_t>();
+                auto start_author = GET_OPTIONAL_ARG(3, std::string, "");
+                auto start_permlink = GET_OPTIONAL_ARG(4, std::string, "");
                 return pimpl->database().with_weak_read_lock([&]() {
-                    return pimpl->get_feed(account, entry_id, limit);
+                    return pimpl->get_feed(account, entry_id, limit, start_author, start_permlink);
                 });
             }
 
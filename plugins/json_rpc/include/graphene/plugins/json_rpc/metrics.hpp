@@ -0,0 +1,102 @@
+#pragma once
+
+#include <fc/time.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            struct latency_histogram_api_object {
+                uint64_t count = 0;
+                int64_t sum_us = 0;
+                std::vector<uint64_t> buckets;
+            };
+
+            struct method_metrics_api_object {
+                std::string method;
+                uint64_t calls = 0;
+                uint64_t errors = 0;
+                uint64_t coalesced = 0;
+                uint64_t bytes_out = 0;
+                latency_histogram_api_object queue_wait;
+                latency_histogram_api_object lock_wait;
+                latency_histogram_api_object execution;
+                latency_histogram_api_object serialization;
+            };
+
+            struct get_metrics_return {
+                std::vector<int64_t> bucket_bounds_us;
+                std::vector<method_metrics_api_object> methods;
+            };
+
+            /**
+             * Lock-free histogram of latencies with fixed bounds of buckets,
+             * the last bucket counts all values which are greater than the last bound.
+             */
+            class latency_histogram final {
+            public:
+                static constexpr std::size_t bounds_count = 14;
+
+                static const std::array<int64_t, bounds_count> &bounds_us();
+
+                void add(const fc::microseconds &value);
+
+                latency_histogram_api_object get() const;
+
+                // Appends histogram in the Prometheus text format
+                void to_prometheus(std::string &out, const std::string &name, const std::string &labels) const;
+
+            private:
+                std::array<std::atomic<uint64_t>, bounds_count + 1> buckets_ = {};
+                std::atomic<uint64_t> count_ = {0};
+                std::atomic<int64_t> sum_us_ = {0};
+            };
+
+            class method_metrics final {
+            public:
+                method_metrics(std::string method);
+
+                const std::string &method() const {
+                    return method_;
+                }
+
+                std::atomic<uint64_t> calls = {0};
+                std::atomic<uint64_t> errors = {0};
+                std::atomic<uint64_t> coalesced = {0}; ///< calls which received result of the same in-flight call
+                std::atomic<uint64_t> bytes_out = {0};
+
+                latency_histogram queue_wait;
+                latency_histogram lock_wait;
+                latency_histogram execution;
+                latency_histogram serialization;
+
+                method_metrics_api_object get() const;
+
+            private:
+                std::string method_;
+            };
+
+            /**
+             * Accumulates time of waiting for database locks in the current thread,
+             * the database notifies about it via the read lock wait observer.
+             */
+            void record_lock_wait(const fc::microseconds &wait);
+
+            // Returns accumulated time of waiting for locks in the current thread and resets it
+            fc::microseconds take_lock_wait();
+
+        }
+    }
+} // graphene::plugins::json_rpc
+
+FC_REFLECT((graphene::plugins::json_rpc::latency_histogram_api_object), (count)(sum_us)(buckets))
+FC_REFLECT(
+    (graphene::plugins::json_rpc::method_metrics_api_object),
+    (method)(calls)(errors)(coalesced)(bytes_out)(queue_wait)(lock_wait)(execution)(serialization))
+FC_REFLECT((graphene::plugins::json_rpc::get_metrics_return), (bucket_bounds_us)(methods))
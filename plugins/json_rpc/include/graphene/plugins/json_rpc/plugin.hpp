@@ -52,6 +52,7 @@
 #define JSON_RPC_NO_PARAMS          (-32001)
 #define JSON_RPC_PARSE_PARAMS_ERROR (-32002)
 #define JSON_RPC_ERROR_DURING_CALL  (-32003)
+#define JSON_RPC_SERVER_BUSY        (-32004)
 
 namespace graphene {
     namespace plugins {
@@ -92,8 +93,7 @@ namespace graphene {
                 APPBASE_PLUGIN_REQUIRES();
 
                 void set_program_options(boost::program_options::options_description &,
-                                         boost::program_options::options_description &) override {
-                }
+                                         boost::program_options::options_description &) override;
 
                 static const std::string &name() {
                     static std::string name = JSON_RPC_PLUGIN_NAME;
@@ -111,6 +111,9 @@ namespace graphene {
 
                 void call(const string &body, response_handler_type);
 
+                // Statistics of API methods in the Prometheus text format
+                std::string get_prometheus_metrics() const;
+
             private:
                 class impl;
 
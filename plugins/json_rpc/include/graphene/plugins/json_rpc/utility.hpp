@@ -7,6 +7,8 @@
 #include <boost/preprocessor/cat.hpp>
 #include <fc/optional.hpp>
 #include <fc/variant.hpp>
+#include <fc/time.hpp>
+#include <fc/exception/exception.hpp>
 
 #define DEFINE_API_ARGS(api_name, arg_type, return_type)  \
 typedef arg_type api_name ## _args;                         \
@@ -43,12 +45,68 @@ api_name ## _return class :: api_name ( api_name ## _args& args )
 namespace graphene {
     namespace plugins {
         namespace json_rpc {
+            class method_metrics;
+
+            /**
+             * Arguments of the call. Params of the request are kept as is and are converted to the vector
+             * on the first access, so methods which don't read arguments don't pay for the conversion.
+             */
+            class msg_pack_args final {
+            public:
+                msg_pack_args() = default;
+
+                msg_pack_args &operator=(fc::variant params) {
+                    params_ = std::move(params);
+                    args_.reset();
+                    initialized_ = true;
+                    return *this;
+                }
+
+                bool valid() const {
+                    return initialized_;
+                }
+
+                // Params as they were received, should be used only before the first access to arguments
+                const fc::variant &params() const {
+                    return params_;
+                }
+
+                std::vector<fc::variant> *operator->() {
+                    return &get();
+                }
+
+                std::vector<fc::variant> &operator*() {
+                    return get();
+                }
+
+            private:
+                std::vector<fc::variant> &get() {
+                    if (!args_.valid()) {
+                        FC_ASSERT(initialized_, "Arguments of the call aren't set");
+                        if (params_.is_array()) {
+                            args_ = std::move(params_.get_array());
+                        } else if (params_.is_null()) {
+                            args_ = std::vector<fc::variant>();
+                        } else {
+                            args_ = params_.as<std::vector<fc::variant>>();
+                        }
+                    }
+                    return *args_;
+                }
+
+                fc::variant params_;
+                fc::optional<std::vector<fc::variant>> args_;
+                bool initialized_ = false;
+            };
+
             class msg_pack final {
             public:
+                struct impl;
+
                 fc::variant id;
                 std::string plugin;
                 std::string method;
-                fc::optional<std::vector<fc::variant>> args;
+                msg_pack_args args;
 
                 msg_pack();
 
@@ -75,6 +133,9 @@ namespace graphene {
 
                 void unsafe_result(fc::optional<fc::variant> result);
 
+                // Pass already serialized result to remote connection, the same buffer can be shared by many requests
+                void unsafe_raw_result(const std::string &serialized_result);
+
                 fc::optional<fc::variant> result() const;
 
                 // Pass error to remote connection
@@ -88,8 +149,15 @@ namespace graphene {
 
                 fc::optional<std::string> error() const;
 
+                // Statistics of the called method, they are updated on passing result/error to remote connection
+                void metrics(method_metrics *);
+
+                method_metrics *metrics() const;
+
+                // Time of receiving the request
+                fc::time_point received() const;
+
             private:
-                struct impl;
                 std::unique_ptr<impl> pimpl;
             };
 
@@ -0,0 +1,103 @@
+#include <graphene/plugins/json_rpc/metrics.hpp>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            namespace {
+                thread_local int64_t thread_lock_wait_us = 0;
+            }
+
+            const std::array<int64_t, latency_histogram::bounds_count> &latency_histogram::bounds_us() {
+                static const std::array<int64_t, bounds_count> bounds = {{
+                    100, 250, 500,
+                    1000, 2500, 5000,
+                    10000, 25000, 50000,
+                    100000, 250000, 500000,
+                    1000000, 5000000
+                }};
+                return bounds;
+            }
+
+            void latency_histogram::add(const fc::microseconds &value) {
+                const auto &bounds = bounds_us();
+                const auto us = value.count();
+
+                std::size_t i = 0;
+                while (i < bounds_count && us > bounds[i]) {
+                    ++i;
+                }
+
+                buckets_[i].fetch_add(1, std::memory_order_relaxed);
+                count_.fetch_add(1, std::memory_order_relaxed);
+                sum_us_.fetch_add(us, std::memory_order_relaxed);
+            }
+
+            latency_histogram_api_object latency_histogram::get() const {
+                latency_histogram_api_object result;
+                result.count = count_.load(std::memory_order_relaxed);
+                result.sum_us = sum_us_.load(std::memory_order_relaxed);
+                result.buckets.reserve(buckets_.size());
+                for (const auto &bucket: buckets_) {
+                    result.buckets.push_back(bucket.load(std::memory_order_relaxed));
+                }
+                return result;
+            }
+
+            void latency_histogram::to_prometheus(std::string &out, const std::string &name, const std::string &labels) const {
+                const auto &bounds = bounds_us();
+                uint64_t cumulative = 0;
+
+                for (std::size_t i = 0; i <= bounds_count; ++i) {
+                    cumulative += buckets_[i].load(std::memory_order_relaxed);
+
+                    out += name;
+                    out += "_bucket{";
+                    out += labels;
+                    out += ",le=\"";
+                    out += (i < bounds_count) ? std::to_string(double(bounds[i]) / 1000000.0) : std::string("+Inf");
+                    out += "\"} ";
+                    out += std::to_string(cumulative);
+                    out += '\n';
+                }
+
+                out += name + "_sum{" + labels + "} ";
+                out += std::to_string(double(sum_us_.load(std::memory_order_relaxed)) / 1000000.0);
+                out += '\n';
+
+                out += name + "_count{" + labels + "} ";
+                out += std::to_string(count_.load(std::memory_order_relaxed));
+                out += '\n';
+            }
+
+            method_metrics::method_metrics(std::string method)
+                    : method_(std::move(method)) {
+            }
+
+            method_metrics_api_object method_metrics::get() const {
+                method_metrics_api_object result;
+                result.method = method_;
+                result.calls = calls.load(std::memory_order_relaxed);
+                result.errors = errors.load(std::memory_order_relaxed);
+                result.coalesced = coalesced.load(std::memory_order_relaxed);
+                result.bytes_out = bytes_out.load(std::memory_order_relaxed);
+                result.queue_wait = queue_wait.get();
+                result.lock_wait = lock_wait.get();
+                result.execution = execution.get();
+                result.serialization = serialization.get();
+                return result;
+            }
+
+            void record_lock_wait(const fc::microseconds &wait) {
+                thread_lock_wait_us += wait.count();
+            }
+
+            fc::microseconds take_lock_wait() {
+                fc::microseconds result(thread_lock_wait_us);
+                thread_lock_wait_us = 0;
+                return result;
+            }
+
+        }
+    }
+} // graphene::plugins::json_rpc
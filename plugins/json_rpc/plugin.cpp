@@ -1,7 +1,20 @@
 #include <graphene/plugins/json_rpc/plugin.hpp>
 #include <graphene/plugins/json_rpc/utility.hpp>
+#include <graphene/plugins/json_rpc/metrics.hpp>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_view.hpp>
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+
+#include <deque>
+#include <unordered_set>
+
+#define DEFAULT_COALESCED_METHODS \
+    "database_api.get_block database_api.get_block_header database_api.get_dynamic_global_properties " \
+    "database_api.get_chain_properties operation_history.get_ops_in_block"
 
 #include <fc/log/logger_config.hpp>
 #include <fc/exception/exception.hpp>
@@ -32,10 +45,42 @@ namespace graphene {
             };
 
             struct msg_pack::impl final {
-                using handler_type = std::function<void (json_rpc_response &)>;
+                using handler_type = std::function<void (impl &)>;
 
                 json_rpc_response response;
                 handler_type handler;
+
+                fc::time_point received = fc::time_point::now();
+                method_metrics *metrics = nullptr;
+
+                // Serialized result which is shared with other requests, it is valid only during handler call
+                const std::string *raw_result = nullptr;
+
+                // Serializes response and passes it to the remote connection
+                void send(const plugin::response_handler_type &response_handler) {
+                    response_handler(serialize());
+                }
+
+                // Serializes response, its size and time of serialization are counted in metrics of method
+                std::string serialize() const {
+                    auto start = fc::time_point::now();
+                    std::string data;
+                    if (raw_result != nullptr) {
+                        data.reserve(raw_result->size() + 64);
+                        data += "{\"jsonrpc\":\"2.0\",\"result\":";
+                        data += *raw_result;
+                        data += ",\"id\":";
+                        data += fc::json::to_string(response.id);
+                        data += '}';
+                    } else {
+                        data = fc::json::to_string(response);
+                    }
+                    if (metrics != nullptr) {
+                        metrics->serialization.add(fc::time_point::now() - start);
+                        metrics->bytes_out.fetch_add(data.size(), std::memory_order_relaxed);
+                    }
+                    return data;
+                }
             };
 
             msg_pack::msg_pack() {
@@ -90,7 +135,20 @@ namespace graphene {
                 // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
                 FC_ASSERT(valid(), "The msg_pack delegated its handlers");
                 pimpl->response.result = std::move(result);
-                pimpl->handler(pimpl->response);
+                pimpl->handler(*pimpl);
+            }
+
+            void msg_pack::unsafe_raw_result(const std::string &serialized_result) {
+                // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
+                FC_ASSERT(valid(), "The msg_pack delegated its handlers");
+                pimpl->raw_result = &serialized_result;
+                try {
+                    pimpl->handler(*pimpl);
+                } catch (...) {
+                    pimpl->raw_result = nullptr;
+                    throw;
+                }
+                pimpl->raw_result = nullptr;
             }
 
             void msg_pack::result(fc::optional<fc::variant> result) {
@@ -115,8 +173,11 @@ namespace graphene {
                 // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
                 FC_ASSERT(valid(), "The msg_pack delegated its handlers");
                 pimpl->response.error = json_rpc_error(code, std::move(message), std::move(data));
+                if (pimpl->metrics != nullptr) {
+                    pimpl->metrics->errors.fetch_add(1, std::memory_order_relaxed);
+                }
                 try {
-                    pimpl->handler(pimpl->response);
+                    pimpl->handler(*pimpl);
                 } catch (const websocketpp::exception &) {
                     // Can't send data via socket - see
                     //    don't pass exception to upper level, because it doesn't have handler for exception
@@ -135,6 +196,25 @@ namespace graphene {
                 error(code, e.to_string(), fc::variant(*(e.dynamic_copy_exception())));
             }
 
+            void msg_pack::metrics(method_metrics *value) {
+                FC_ASSERT(valid(), "The msg_pack delegated its handlers");
+                pimpl->metrics = value;
+            }
+
+            method_metrics *msg_pack::metrics() const {
+                if (valid()) {
+                    return pimpl->metrics;
+                }
+                return nullptr;
+            }
+
+            fc::time_point msg_pack::received() const {
+                if (valid()) {
+                    return pimpl->received;
+                }
+                return fc::time_point();
+            }
+
             fc::optional<std::string> msg_pack::error() const {
                 // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
                 if (valid() || pimpl->response.error.valid()) {
@@ -143,6 +223,122 @@ namespace graphene {
                 return fc::optional<std::string>();
             }
 
+            /**
+             * Priority class of API methods. Each class has its own worker threads, a limit of concurrently
+             * executed calls and a bounded queue of waiting calls, so heavy methods can't starve cheap ones.
+             */
+            class priority_class final {
+            public:
+                using task_type = std::function<void()>;
+
+                priority_class(std::string name, uint32_t threads, uint32_t max_concurrency, uint32_t max_queue)
+                        : name_(std::move(name)),
+                          threads_(threads),
+                          max_concurrency_(std::min(max_concurrency, threads)),
+                          max_queue_(max_queue) {
+                }
+
+                ~priority_class() {
+                    stop();
+                }
+
+                const std::string &name() const {
+                    return name_;
+                }
+
+                void start() {
+                    work_ = std::make_unique<boost::asio::io_service::work>(ios_);
+                    for (uint32_t i = 0; i < threads_; ++i) {
+                        thread_pool_.create_thread([this]() { ios_.run(); });
+                    }
+                }
+
+                void stop() {
+                    work_.reset();
+                    ios_.stop();
+                    thread_pool_.join_all();
+                }
+
+                // Returns false if the queue of the class is full, in this case task isn't executed
+                bool enqueue(task_type task) {
+                    boost::lock_guard<boost::mutex> guard(mutex_);
+                    if (running_ >= max_concurrency_ && pending_.size() >= max_queue_) {
+                        return false;
+                    }
+                    pending_.push_back(std::move(task));
+                    schedule();
+                    return true;
+                }
+
+            private:
+                // Should be called under lock of mutex_
+                void schedule() {
+                    while (running_ < max_concurrency_ && !pending_.empty()) {
+                        auto task = std::make_shared<task_type>(std::move(pending_.front()));
+                        pending_.pop_front();
+                        ++running_;
+
+                        ios_.post([this, task]() {
+                            try {
+                                (*task)();
+                            } catch (...) {
+                                elog("Unhandled exception in json_rpc ${class} worker", ("class", name_));
+                            }
+
+                            boost::lock_guard<boost::mutex> guard(mutex_);
+                            --running_;
+                            schedule();
+                        });
+                    }
+                }
+
+                std::string name_;
+                uint32_t threads_;
+                uint32_t max_concurrency_;
+                uint32_t max_queue_;
+
+                boost::asio::io_service ios_;
+                std::unique_ptr<boost::asio::io_service::work> work_;
+                boost::thread_group thread_pool_;
+
+                boost::mutex mutex_;
+                std::deque<task_type> pending_;
+                uint32_t running_ = 0;
+            };
+
+            /**
+             * In-flight call of a method, identical requests wait for its result instead of executing the method again
+             */
+            struct coalesced_call final {
+                std::string key;
+                std::vector<std::shared_ptr<msg_pack>> followers;
+            };
+
+            /**
+             * Everything which is needed to dispatch a call of method, it is resolved once on registering of method
+             */
+            struct dispatch_entry final {
+                std::string api;
+                std::string method;
+                std::string name; // api.method
+                api_method *call = nullptr;
+                method_metrics *metrics = nullptr;
+                priority_class *cls = nullptr;
+                bool coalesced = false;
+            };
+
+            struct string_view_hash final {
+                std::size_t operator()(const boost::string_view &value) const {
+                    return boost::hash_range(value.begin(), value.end());
+                }
+
+                std::size_t operator()(const std::pair<boost::string_view, boost::string_view> &value) const {
+                    auto seed = boost::hash_range(value.first.begin(), value.first.end());
+                    boost::hash_combine(seed, boost::hash_range(value.second.begin(), value.second.end()));
+                    return seed;
+                }
+            };
+
             using get_methods_args     = void_type;
             using get_methods_return   = vector<string>;
             using get_signature_args   = string;
@@ -164,6 +360,54 @@ namespace graphene {
                     std::stringstream canonical_name;
                     canonical_name << api_name << '.' << method_name;
                     _methods.push_back(canonical_name.str());
+                    _method_metrics[canonical_name.str()] = std::make_unique<method_metrics>(canonical_name.str());
+                    add_dispatch_entry(api_name, method_name);
+                }
+
+                // Priority classes and coalesced methods should be configured before registering of APIs
+                void add_dispatch_entry(const string &api_name, const string &method_name) {
+                    auto name = api_name + '.' + method_name;
+
+                    auto itr = _dispatch_by_name.find(boost::string_view(name));
+                    dispatch_entry *entry = nullptr;
+                    if (itr != _dispatch_by_name.end()) {
+                        entry = itr->second;
+                    } else {
+                        _dispatch_entries.emplace_back();
+                        entry = &_dispatch_entries.back();
+                        entry->api = api_name;
+                        entry->method = method_name;
+                        entry->name = std::move(name);
+                        _dispatch_by_name.emplace(boost::string_view(entry->name), entry);
+                        _dispatch_by_api.emplace(
+                            std::make_pair(boost::string_view(entry->api), boost::string_view(entry->method)), entry);
+                    }
+
+                    entry->call = &_registered_apis[api_name][method_name];
+                    entry->metrics = find_method_metrics(api_name, method_name);
+                    entry->cls = find_priority_class(api_name, method_name);
+                    entry->coalesced = _coalesced_methods.count(entry->name) != 0;
+                }
+
+                const dispatch_entry *find_dispatch_entry(const fc::variant &api, const fc::variant &method) const {
+                    if (!api.is_string() || !method.is_string()) {
+                        return nullptr;
+                    }
+
+                    auto itr = _dispatch_by_api.find(std::make_pair(
+                        boost::string_view(api.get_string()), boost::string_view(method.get_string())));
+                    if (itr == _dispatch_by_api.end()) {
+                        return nullptr;
+                    }
+                    return itr->second;
+                }
+
+                const dispatch_entry *find_dispatch_entry(const std::string &name) const {
+                    auto itr = _dispatch_by_name.find(boost::string_view(name));
+                    if (itr == _dispatch_by_name.end()) {
+                        return nullptr;
+                    }
+                    return itr->second;
                 }
 
                 api_method *find_api_method(std::string api, std::string method) {
@@ -177,38 +421,46 @@ namespace graphene {
                     return &(method_itr->second);
                 }
 
-                api_method *process_params(string method, const fc::variant_object &request, msg_pack &func_args) {
-                    api_method *ret = nullptr;
+                const dispatch_entry *process_params(const string &method, const fc::variant_object &request, msg_pack &func_args) {
+                    const dispatch_entry *ret = nullptr;
 
                     if (method == "call") {
                         FC_ASSERT(request.contains("params"));
 
-                        std::vector<fc::variant> v;
+                        const auto &params = request["params"];
+                        const auto size = params.is_array() ? params.get_array().size() : 0;
 
-                        if (request["params"].is_array()) {
-                            v = request["params"].as<std::vector<fc::variant> >();
-                        }
+                        FC_ASSERT(size == 2 || size == 3, "params should be {\"api\", \"method\", \"args\"");
 
-                        FC_ASSERT(v.size() == 2 || v.size() == 3, "params should be {\"api\", \"method\", \"args\"");
+                        const auto &v = params.get_array();
+                        ret = find_dispatch_entry(v[0], v[1]);
+                        if (ret == nullptr) {
+                            // Unknown method, slow path is used only for reporting of error
+                            find_api_method(v[0].as_string(), v[1].as_string());
+                            FC_ASSERT(false, "Could not find method ${method}", ("method", v[1].as_string()));
+                        }
 
-                        ret = find_api_method(v[0].as_string(), v[1].as_string());
-                        func_args.plugin = v[0].as_string();
-                        func_args.method = v[1].as_string();
-                        fc::variant tmp = (v.size() == 3) ? v[2] : fc::json::from_string("{}");
-                        func_args.args = tmp.as<std::vector<fc::variant>>();
+                        // Params are converted by the method on the first access
+                        func_args.args = (size == 3) ? v[2] : fc::variant();
                     } else {
-                        vector<std::string> v;
-                        boost::split(v, method, boost::is_any_of("."));
+                        ret = find_dispatch_entry(method);
+                        if (ret == nullptr) {
+                            // Unknown method, slow path is used only for reporting of error
+                            vector<std::string> v;
+                            boost::split(v, method, boost::is_any_of("."));
 
-                        FC_ASSERT(v.size() == 2, "method specification invalid. Should be api.method");
+                            FC_ASSERT(v.size() == 2, "method specification invalid. Should be api.method");
 
-                        ret = find_api_method(v[0], v[1]);
-                        func_args.plugin = v[0];
-                        func_args.method = v[1];
-                        fc::variant tmp = (v.size() == 3) ? v[2] : fc::json::from_string("{}");
-                        func_args.args = tmp.as<std::vector<fc::variant>>();
+                            find_api_method(v[0], v[1]);
+                            FC_ASSERT(false, "Could not find method ${method}", ("method", v[1]));
+                        }
+
+                        func_args.args = fc::variant();
                     }
 
+                    func_args.plugin = ret->api;
+                    func_args.method = ret->method;
+
                     return ret;
                 }
 
@@ -234,27 +486,324 @@ namespace graphene {
 
                     // This is to maintain backwards compatibility with existing call structure.
                     if ((method == "call" && request.contains("params")) || method != "call") {
-                        api_method *call = nullptr;
+                        const dispatch_entry *entry = nullptr;
 
                         try {
-                            call = process_params(method, request, msg);
+                            entry = process_params(method, request, msg);
                         } catch (const fc::assert_exception &e) {
                             return msg.error(JSON_RPC_PARSE_PARAMS_ERROR, e);
                         }
 
-                        try {
-                            auto result = (*call)(msg);
-                            if (msg.valid()) {
-                                msg.result(std::move(result));
+                        auto *call = entry->call;
+                        msg.metrics(entry->metrics);
+
+                        std::shared_ptr<coalesced_call> coalesced;
+                        if (entry->coalesced) {
+                            coalesced = join_coalesced_call(*entry, msg);
+                            if (!coalesced) {
+                                // The same request is already executing, msg will receive its result
+                                return;
                             }
-                        } catch (const fc::assert_exception &e) {
-                            return msg.error(JSON_RPC_ERROR_DURING_CALL, e);
+                        }
+
+                        auto *cls = entry->cls;
+                        if (cls == nullptr) {
+                            return execute(*call, msg, coalesced);
+                        }
+
+                        // Moving of msg_pack passes only its handlers, the request is passed separately
+                        auto shared_msg = std::make_shared<msg_pack>(std::move(msg));
+                        shared_msg->plugin = std::move(msg.plugin);
+                        shared_msg->method = std::move(msg.method);
+                        shared_msg->args = std::move(msg.args);
+                        auto queued = cls->enqueue([this, call, shared_msg, coalesced]() {
+                            auto &msg = *shared_msg;
+                            try {
+                                execute(*call, msg, coalesced);
+                            } catch (const fc::exception &e) {
+                                msg.error(e);
+                            } catch (const std::exception &e) {
+                                msg.error(e.what());
+                            } catch (...) {
+                                msg.error("Unknown error - calling api method failed");
+                            }
+                        });
+
+                        if (!queued) {
+                            auto message = "Server is busy, queue of " + cls->name() + " methods is full";
+                            if (coalesced) {
+                                for (auto &follower: take_coalesced_followers(coalesced)) {
+                                    follower->error(JSON_RPC_SERVER_BUSY, message);
+                                }
+                            }
+                            return shared_msg->error(JSON_RPC_SERVER_BUSY, message);
                         }
                     } else {
                         return msg.error(JSON_RPC_NO_PARAMS, "A member \"params\" does not exist");
                     }
                 }
 
+                void execute(api_method &call, msg_pack &msg, const std::shared_ptr<coalesced_call> &coalesced = nullptr) {
+                    auto *metrics = msg.metrics();
+                    fc::optional<fc::variant> result;
+
+                    if (metrics != nullptr) {
+                        metrics->calls.fetch_add(1, std::memory_order_relaxed);
+                    }
+
+                    auto start = fc::time_point::now();
+                    auto queue_wait = start - msg.received();
+                    take_lock_wait();
+
+                    // msg can be moved by the method (see msg_pack_transfer), so it isn't used here
+                    auto update_metrics = [&]() {
+                        if (metrics != nullptr) {
+                            auto lock_wait = take_lock_wait();
+                            metrics->queue_wait.add(queue_wait);
+                            metrics->lock_wait.add(lock_wait);
+                            metrics->execution.add(fc::time_point::now() - start - lock_wait);
+                        }
+                    };
+
+                    try {
+                        result = call(msg);
+                        update_metrics();
+                    } catch (const fc::assert_exception &e) {
+                        update_metrics();
+                        forward_error_to_followers(coalesced, std::current_exception());
+                        return msg.error(JSON_RPC_ERROR_DURING_CALL, e);
+                    } catch (const fc::bad_cast_exception &e) {
+                        // Params are converted lazily by the method, so their types are checked here
+                        update_metrics();
+                        forward_error_to_followers(coalesced, std::current_exception());
+                        return msg.error(JSON_RPC_INVALID_PARAMS, e);
+                    } catch (...) {
+                        update_metrics();
+                        forward_error_to_followers(coalesced, std::current_exception());
+                        throw;
+                    }
+
+                    if (coalesced) {
+                        return send_coalesced_result(coalesced, msg, *result);
+                    }
+
+                    if (msg.valid()) {
+                        msg.result(std::move(result));
+                    }
+                }
+
+                std::shared_ptr<coalesced_call> join_coalesced_call(const dispatch_entry &entry, msg_pack &msg) {
+                    auto key = entry.name;
+                    if (msg.args.valid()) {
+                        key += fc::json::to_string(msg.args.params());
+                    }
+
+                    boost::lock_guard<boost::mutex> guard(_coalesced_mutex);
+                    auto itr = _coalesced_calls.find(key);
+                    if (itr != _coalesced_calls.end()) {
+                        if (msg.metrics() != nullptr) {
+                            msg.metrics()->coalesced.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        itr->second->followers.push_back(std::make_shared<msg_pack>(std::move(msg)));
+                        return nullptr;
+                    }
+
+                    auto coalesced = std::make_shared<coalesced_call>();
+                    coalesced->key = std::move(key);
+                    _coalesced_calls.emplace(coalesced->key, coalesced);
+                    return coalesced;
+                }
+
+                // Finishes the in-flight call, so next identical requests will be executed again
+                std::vector<std::shared_ptr<msg_pack>> take_coalesced_followers(const std::shared_ptr<coalesced_call> &coalesced) {
+                    boost::lock_guard<boost::mutex> guard(_coalesced_mutex);
+                    _coalesced_calls.erase(coalesced->key);
+                    return std::move(coalesced->followers);
+                }
+
+                void send_coalesced_result(const std::shared_ptr<coalesced_call> &coalesced, msg_pack &msg, const fc::variant &result) {
+                    auto followers = take_coalesced_followers(coalesced);
+
+                    if (!msg.valid()) {
+                        // Method delegated its msg_pack to other thread, so there is nothing to share
+                        for (auto &follower: followers) {
+                            follower->error(JSON_RPC_INTERNAL_ERROR, "Result of request can't be shared");
+                        }
+                        return;
+                    }
+
+                    auto start = fc::time_point::now();
+                    auto serialized_result = fc::json::to_string(result);
+                    if (msg.metrics() != nullptr) {
+                        msg.metrics()->serialization.add(fc::time_point::now() - start);
+                    }
+
+                    followers.push_back(std::make_shared<msg_pack>(std::move(msg)));
+                    for (auto &follower: followers) {
+                        try {
+                            follower->unsafe_raw_result(serialized_result);
+                        } catch (const websocketpp::exception &) {
+                            // Can't send data via socket - the same as in msg_pack::result()
+                        }
+                    }
+                }
+
+                void forward_error_to_followers(const std::shared_ptr<coalesced_call> &coalesced, std::exception_ptr error) {
+                    if (!coalesced) {
+                        return;
+                    }
+
+                    for (auto &follower: take_coalesced_followers(coalesced)) {
+                        try {
+                            std::rethrow_exception(error);
+                        } catch (const fc::assert_exception &e) {
+                            follower->error(JSON_RPC_ERROR_DURING_CALL, e);
+                        } catch (const fc::bad_cast_exception &e) {
+                            follower->error(JSON_RPC_INVALID_PARAMS, e);
+                        } catch (const fc::exception &e) {
+                            follower->error(e);
+                        } catch (const std::exception &e) {
+                            follower->error(e.what());
+                        } catch (...) {
+                            follower->error("Unknown error - calling api method failed");
+                        }
+                    }
+                }
+
+                void add_coalesced_methods(const std::string &spec) {
+                    std::vector<std::string> items;
+                    boost::split(items, spec, boost::is_any_of(" \t,"));
+
+                    for (const auto &item: items) {
+                        if (!item.empty()) {
+                            _coalesced_methods.insert(item);
+                        }
+                    }
+                }
+
+                method_metrics *find_method_metrics(const std::string &api, const std::string &method) {
+                    auto itr = _method_metrics.find(api + '.' + method);
+                    if (itr == _method_metrics.end()) {
+                        return nullptr;
+                    }
+                    return itr->second.get();
+                }
+
+                get_metrics_return get_metrics() const {
+                    get_metrics_return result;
+                    const auto &bounds = latency_histogram::bounds_us();
+                    result.bucket_bounds_us.assign(bounds.begin(), bounds.end());
+                    result.methods.reserve(_method_metrics.size());
+                    for (const auto &itr: _method_metrics) {
+                        result.methods.push_back(itr.second->get());
+                    }
+                    return result;
+                }
+
+                std::string get_prometheus_metrics() const {
+                    std::string out;
+
+                    auto add_counter = [&](const char *name, const char *help, std::atomic<uint64_t> method_metrics::*field) {
+                        out += std::string("# HELP ") + name + ' ' + help + "\n";
+                        out += std::string("# TYPE ") + name + " counter\n";
+                        for (const auto &itr: _method_metrics) {
+                            const auto &metrics = *itr.second;
+                            if (metrics.calls.load(std::memory_order_relaxed) == 0) {
+                                continue;
+                            }
+                            out += std::string(name) + "{method=\"" + metrics.method() + "\"} ";
+                            out += std::to_string((metrics.*field).load(std::memory_order_relaxed)) + '\n';
+                        }
+                    };
+
+                    auto add_histogram = [&](const char *name, const char *help, latency_histogram method_metrics::*field) {
+                        out += std::string("# HELP ") + name + ' ' + help + "\n";
+                        out += std::string("# TYPE ") + name + " histogram\n";
+                        for (const auto &itr: _method_metrics) {
+                            const auto &metrics = *itr.second;
+                            if (metrics.calls.load(std::memory_order_relaxed) == 0) {
+                                continue;
+                            }
+                            (metrics.*field).to_prometheus(out, name, "method=\"" + metrics.method() + "\"");
+                        }
+                    };
+
+                    add_counter("vizd_rpc_calls_total", "Number of API method calls.", &method_metrics::calls);
+                    add_counter("vizd_rpc_errors_total", "Number of API method calls finished with error.", &method_metrics::errors);
+                    add_counter("vizd_rpc_coalesced_total", "Number of requests which received result of the same in-flight call.", &method_metrics::coalesced);
+                    add_counter("vizd_rpc_sent_bytes_total", "Size of serialized API responses.", &method_metrics::bytes_out);
+                    add_histogram("vizd_rpc_queue_wait_seconds", "Time from receiving of request to start of execution.", &method_metrics::queue_wait);
+                    add_histogram("vizd_rpc_lock_wait_seconds", "Time of waiting for database read lock.", &method_metrics::lock_wait);
+                    add_histogram("vizd_rpc_execution_seconds", "Time of method execution without lock waiting.", &method_metrics::execution);
+                    add_histogram("vizd_rpc_serialization_seconds", "Time of response serialization.", &method_metrics::serialization);
+
+                    return out;
+                }
+
+                priority_class *find_priority_class(const std::string &api, const std::string &method) {
+                    if (_method_classes.empty()) {
+                        return nullptr;
+                    }
+
+                    auto itr = _method_classes.find(api + '.' + method);
+                    if (itr == _method_classes.end()) {
+                        itr = _method_classes.find(api + ".*");
+                        if (itr == _method_classes.end()) {
+                            return nullptr;
+                        }
+                    }
+                    return itr->second;
+                }
+
+                void add_priority_class(const std::string &spec) {
+                    std::vector<std::string> parts;
+                    boost::split(parts, spec, boost::is_any_of(":"));
+                    FC_ASSERT(parts.size() == 4,
+                        "rpc-priority-class should be NAME:THREADS:MAX_CONCURRENCY:MAX_QUEUE, was ${s}", ("s", spec));
+
+                    auto threads = boost::lexical_cast<uint32_t>(parts[1]);
+                    auto max_concurrency = boost::lexical_cast<uint32_t>(parts[2]);
+                    auto max_queue = boost::lexical_cast<uint32_t>(parts[3]);
+                    FC_ASSERT(threads > 0 && max_concurrency > 0, "Priority class ${n} should have workers", ("n", parts[0]));
+                    FC_ASSERT(_priority_classes.count(parts[0]) == 0, "Duplicate priority class ${n}", ("n", parts[0]));
+
+                    _priority_classes.emplace(parts[0],
+                        std::make_unique<priority_class>(parts[0], threads, max_concurrency, max_queue));
+                    ilog("json_rpc: priority class ${n} with ${t} threads, ${c} concurrent calls, ${q} queued calls",
+                         ("n", parts[0])("t", threads)("c", max_concurrency)("q", max_queue));
+                }
+
+                void add_method_class(const std::string &spec) {
+                    std::vector<std::string> items;
+                    boost::split(items, spec, boost::is_any_of(" \t,"));
+
+                    for (const auto &item: items) {
+                        if (item.empty()) {
+                            continue;
+                        }
+
+                        auto pos = item.find(':');
+                        FC_ASSERT(pos != std::string::npos, "rpc-method-class should be CLASS:api.method, was ${s}", ("s", item));
+
+                        auto cls = _priority_classes.find(item.substr(0, pos));
+                        FC_ASSERT(cls != _priority_classes.end(), "Unknown priority class in ${s}", ("s", item));
+
+                        _method_classes[item.substr(pos + 1)] = cls->second.get();
+                    }
+                }
+
+                void start_priority_classes() {
+                    for (auto &cls: _priority_classes) {
+                        cls.second->start();
+                    }
+                }
+
+                void stop_priority_classes() {
+                    for (auto &cls: _priority_classes) {
+                        cls.second->stop();
+                    }
+                }
+
                 struct dump_rpc_time {
                     dump_rpc_time(const fc::variant& data)
                         : data_(data) {
@@ -311,20 +860,36 @@ namespace graphene {
                 }
 
                 void rpc(vector<fc::variant> messages, response_handler_type response_handler) {
-                    auto responses = std::make_shared<vector<json_rpc_response>>();
+                    // Responses are serialized one by one, so they are counted in metrics of their methods
+                    auto responses = std::make_shared<vector<std::string>>();
 
                     responses->reserve(messages.size());
 
                     std::function<void()> next_handler = [response_handler, responses]{
-                        response_handler(fc::json::to_string(*responses.get()));
+                        std::size_t size = 2;
+                        for (const auto &response: *responses) {
+                            size += response.size() + 1;
+                        }
+
+                        std::string data;
+                        data.reserve(size);
+                        data += '[';
+                        for (const auto &response: *responses) {
+                            if (data.size() > 1) {
+                                data += ',';
+                            }
+                            data += response;
+                        }
+                        data += ']';
+                        response_handler(data);
                     };
 
                     for (auto it = messages.rbegin(); messages.rend() != it; ++it) {
                         auto v = *it;
 
                         next_handler = [next_handler, responses, v, this]{
-                            msg_pack msg([next_handler, responses](json_rpc_response &response){
-                                responses->push_back(response);
+                            msg_pack msg([next_handler, responses](msg_pack::impl &ctx){
+                                responses->push_back(ctx.serialize());
                                 next_handler();
                             });
 
@@ -359,6 +924,24 @@ namespace graphene {
                 map<string, api_description> _registered_apis;
                 vector<string> _methods;
                 map<string, map<string, api_method_signature> > _method_sigs;
+
+                // Methods which aren't assigned to any priority class are executed in the caller thread
+                map<string, std::unique_ptr<priority_class>> _priority_classes;
+                std::unordered_map<string, priority_class *> _method_classes;
+
+                // Statistics of methods, the map is filled on registering of APIs and isn't changed later
+                map<string, std::unique_ptr<method_metrics>> _method_metrics;
+
+                // Read-only methods, which identical concurrent requests share one execution
+                std::unordered_set<string> _coalesced_methods;
+                boost::mutex _coalesced_mutex;
+                std::unordered_map<string, std::shared_ptr<coalesced_call>> _coalesced_calls;
+
+                // Flat lookup tables of methods by api.method and by pair (api, method) for the legacy `call`,
+                //   they are built on registering of APIs, so dispatching doesn't allocate memory
+                std::deque<dispatch_entry> _dispatch_entries;
+                std::unordered_map<boost::string_view, dispatch_entry *, string_view_hash> _dispatch_by_name;
+                std::unordered_map<std::pair<boost::string_view, boost::string_view>, dispatch_entry *, string_view_hash> _dispatch_by_api;
             private:
                 // This is a reindex which allows to get parent plugin by method
                 // unordered_map[method] -> plugin
@@ -375,22 +958,60 @@ namespace graphene {
             plugin::~plugin() {
             }
 
+            void plugin::set_program_options(boost::program_options::options_description &,
+                                             boost::program_options::options_description &cfg) {
+                cfg.add_options()
+                    ("rpc-priority-class", boost::program_options::value<std::vector<std::string>>()->composing(),
+                        "Priority class of API methods as NAME:THREADS:MAX_CONCURRENCY:MAX_QUEUE. "
+                        "Calls over MAX_QUEUE are rejected with a 'server is busy' error. Can be specified multiple times")
+                    ("rpc-method-class", boost::program_options::value<std::vector<std::string>>()->composing(),
+                        "List of CLASS:api.method (or CLASS:api.*) which assigns API methods to a priority class. "
+                        "Other methods are executed by the webserver thread pool. Can be specified multiple times")
+                    ("rpc-coalesce-methods", boost::program_options::value<std::vector<std::string>>()->composing()
+                        ->default_value(std::vector<std::string>({DEFAULT_COALESCED_METHODS}), DEFAULT_COALESCED_METHODS),
+                        "List of read-only API methods (api.method), which identical concurrent requests are executed once "
+                        "and share the result. Can be specified multiple times");
+            }
+
             void plugin::plugin_initialize(const boost::program_options::variables_map &options) {
                 ilog("json_rpc plugin: plugin_initialize() begin");
                 pimpl = std::make_unique<impl>();
                 pimpl->initialize();
+
+                if (options.count("rpc-priority-class")) {
+                    for (const auto &spec: options.at("rpc-priority-class").as<std::vector<std::string>>()) {
+                        pimpl->add_priority_class(spec);
+                    }
+                }
+
+                if (options.count("rpc-method-class")) {
+                    for (const auto &spec: options.at("rpc-method-class").as<std::vector<std::string>>()) {
+                        pimpl->add_method_class(spec);
+                    }
+                }
+
+                if (options.count("rpc-coalesce-methods")) {
+                    for (const auto &spec: options.at("rpc-coalesce-methods").as<std::vector<std::string>>()) {
+                        pimpl->add_coalesced_methods(spec);
+                    }
+                }
+
+                add_api_method("jsonrpc", "get_metrics", [this](msg_pack &) -> fc::variant {
+                    return fc::variant(pimpl->get_metrics());
+                });
                 ilog("json_rpc plugin: plugin_initialize() end");
             }
 
             void plugin::plugin_startup() {
                 ilog("json_rpc plugin: plugin_startup() begin");
                 std::sort(pimpl->_methods.begin(), pimpl->_methods.end());
+                pimpl->start_priority_classes();
                 ilog("json_rpc plugin: plugin_startup() end");
             }
 
             void plugin::plugin_shutdown() {
                 ilog("json_rpc plugin: plugin_shutdown() begin");
-
+                pimpl->stop_priority_classes();
                 ilog("json_rpc plugin: plugin_shutdown() end");
             }
 
@@ -399,6 +1020,10 @@ namespace graphene {
                 pimpl->add_api_method(api_name, method_name, api/*, sig*/ );
             }
 
+            std::string plugin::get_prometheus_metrics() const {
+                return pimpl->get_prometheus_metrics();
+            }
+
             void plugin::call(const string &message, response_handler_type response_handler) {
                 try {
                     fc::variant v = fc::json::from_string(message);
@@ -409,8 +1034,8 @@ namespace graphene {
                         FC_ASSERT(messages.size(), "Array is invalid");
                         pimpl->rpc(messages, response_handler);
                     } else {
-                        msg_pack msg([response_handler](json_rpc_response &response){
-                            response_handler(fc::json::to_string(response));
+                        msg_pack msg([response_handler](msg_pack::impl &ctx){
+                            ctx.send(response_handler);
                         });
 
                         pimpl->rpc(v, msg);
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <bsoncxx/document/value.hpp>
+
+#include <mongocxx/model/write.hpp>
+#include <mongocxx/pool.hpp>
+#include <mongocxx/uri.hpp>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/thread.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace graphene {
+namespace plugins {
+namespace mongo_db {
+
+    struct mongo_db_batch_options final {
+        std::size_t queue_size = 16;
+        std::size_t batch_size = 10000;
+        uint32_t flush_interval_ms = 1000;
+        std::size_t catchup_batch_size = 100000;
+        uint32_t catchup_threads = 4;
+        uint32_t format_threads = 4;
+    };
+
+    // Builds the write model from the state copied on the write thread of database
+    using mongo_db_formatter = std::function<mongocxx::model::write()>;
+
+    /**
+     * Formatted documents of a series of irreversible blocks
+     */
+    struct mongo_db_batch final {
+        uint32_t last_block = 0;
+        std::size_t size = 0;
+
+        // Collection name, formatter of document
+        std::vector<std::pair<std::string, mongo_db_formatter>> documents;
+
+        // Collection name, index
+        std::vector<std::pair<std::string, bsoncxx::document::value>> indexes;
+
+        void add(const std::string& collection, mongo_db_formatter formatter) {
+            documents.emplace_back(collection, std::move(formatter));
+            ++size;
+        }
+
+        bool empty() const {
+            return size == 0 && indexes.empty();
+        }
+    };
+
+    /**
+     * Writes batches of documents to MongoDB on the own thread, so a slow MongoDB doesn't stall applying of blocks
+     * until the bounded queue of batches is full.
+     *
+     * BSON documents of batch are built by the worker pool and merged per collection in the original order.
+     *
+     * In the catch-up mode (reindex or sync) collections of batch are written in parallel.
+     */
+    class mongo_db_batch_writer final {
+    public:
+        mongo_db_batch_writer();
+
+        ~mongo_db_batch_writer();
+
+        void start(const mongocxx::uri& uri, const std::string& db_name, const mongo_db_batch_options& opts);
+
+        // Writes the rest of queue and stops the thread
+        void stop();
+
+        // Is called from the write thread of database, waits if the queue is full
+        void push(mongo_db_batch batch, bool catchup);
+
+        void log_stats();
+
+    private:
+        struct queued_batch final {
+            mongo_db_batch batch;
+            bool catchup = false;
+        };
+
+        void run();
+
+        using collections_type = std::map<std::string, std::vector<mongocxx::model::write>>;
+
+        collections_type format(mongo_db_batch& batch);
+
+        void write(queued_batch& item);
+
+        void write_collection(const std::string& name, std::vector<mongocxx::model::write>& models);
+
+        std::unique_ptr<mongocxx::pool> pool_;
+        std::string db_name_;
+        std::size_t max_queue_size_ = 1;
+        uint32_t catchup_threads_ = 1;
+
+        std::mutex mutex_;
+        std::condition_variable not_empty_;
+        std::condition_variable not_full_;
+        std::deque<queued_batch> queue_;
+        bool stopping_ = false;
+        std::thread thread_;
+
+        boost::asio::io_service format_ios_;
+        std::unique_ptr<boost::asio::io_service::work> format_work_;
+        boost::thread_group format_pool_;
+        uint32_t format_threads_ = 1;
+
+        std::atomic<uint64_t> batches_ = {0};
+        std::atomic<uint64_t> documents_ = {0};
+        std::atomic<uint64_t> errors_ = {0};
+        std::atomic<uint64_t> format_us_ = {0};
+        std::atomic<uint64_t> write_us_ = {0};
+        std::atomic<uint64_t> producer_waits_ = {0};
+        std::atomic<uint64_t> producer_wait_us_ = {0};
+        std::atomic<uint64_t> max_queue_size_seen_ = {0};
+        std::atomic<uint32_t> last_written_block_ = {0};
+    };
+
+}}} // graphene::plugins::mongo_db
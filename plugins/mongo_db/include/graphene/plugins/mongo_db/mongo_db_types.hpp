@@ -27,6 +27,8 @@
 
 #include <fc/crypto/sha1.hpp>
 
+#include <functional>
+
 namespace graphene {
 namespace plugins {
 namespace mongo_db {
@@ -39,7 +41,8 @@ namespace mongo_db {
 
     struct named_document {
         std::string collection_name;
-        document doc;
+        // Builds the document from the copied state, is called on the worker pool of mongo_db_batch_writer
+        std::function<void(document&)> format;
         bool is_removal;
         //bool is_virtual;
         std::vector<document> indexes_to_create;
@@ -6,6 +6,7 @@
 
 #include <graphene/plugins/mongo_db/mongo_db_types.hpp>
 #include <graphene/plugins/mongo_db/mongo_db_state.hpp>
+#include <graphene/plugins/mongo_db/mongo_db_batch_writer.hpp>
 
 #include <libraries/chain/include/graphene/chain/operation_notification.hpp>
 
@@ -37,14 +38,17 @@ namespace mongo_db {
     using graphene::chain::operation_notification;
     using namespace graphene::protocol;
 
-    using bulk_ptr = std::unique_ptr<mongocxx::bulk_write>;
-
     class mongo_db_writer final {
     public:
         mongo_db_writer();
         ~mongo_db_writer();
 
-        bool initialize(const std::string& uri_str, const bool write_raw, const std::vector<std::string>& op);
+        bool initialize(
+            const std::string& uri_str, const bool write_raw, const std::vector<std::string>& op,
+            const mongo_db_batch_options& batch_opts);
+
+        // Writes the rest of documents and stops the writer thread
+        void shutdown();
 
         void on_block(const signed_block& block);
         void on_operation(const graphene::chain::operation_notification& note);
@@ -58,10 +62,12 @@ namespace mongo_db {
         void write_document(named_document const& named_doc);
         void remove_document(named_document const& named_doc);
 
-        void format_block_info(const signed_block& block, document& doc);
-        void format_transaction_info(const signed_transaction& tran, document& doc);
+        // Are called on the worker pool of batch writer
+        static document format_raw_block(const signed_block& block, const operations&);
+        static void format_block_info(const signed_block& block, document& doc);
+        static void format_transaction_info(const signed_transaction& tran, document& doc);
 
-        void write_data();
+        void flush(bool catchup);
 
         uint64_t processed_blocks = 0;
 
@@ -71,18 +77,18 @@ namespace mongo_db {
         uint32_t last_irreversible_block_num;
         std::map<uint32_t, signed_block> blocks;
         std::map<uint32_t, operations> virtual_ops;
-        // Table name, bulk write
-        std::map<std::string, bulk_ptr> formatted_blocks;
+        // Documents which aren't passed to the writer thread yet
+        mongo_db_batch batch;
+        fc::time_point last_flush;
 
         bool write_raw_blocks;
         flat_set<std::string> write_operations;
 
         // Mongo connection members
         mongocxx::instance mongo_inst;
-        mongocxx::database mongo_database;
         mongocxx::uri uri;
-        mongocxx::client mongo_conn;
-        mongocxx::options::bulk_write bulk_opts;
+        mongo_db_batch_options batch_opts;
+        mongo_db_batch_writer batch_writer;
 
         std::unordered_map<std::string, std::string> indexes; // Prevent repeative create_index() calls. Only in current session 
 
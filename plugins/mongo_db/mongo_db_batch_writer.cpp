@@ -0,0 +1,232 @@
+#include <graphene/plugins/mongo_db/mongo_db_batch_writer.hpp>
+
+#include <fc/log/logger.hpp>
+#include <fc/time.hpp>
+
+#include <mongocxx/bulk_write.hpp>
+#include <mongocxx/client.hpp>
+#include <mongocxx/exception/exception.hpp>
+#include <mongocxx/options/bulk_write.hpp>
+
+#include <algorithm>
+#include <future>
+
+namespace graphene {
+namespace plugins {
+namespace mongo_db {
+
+    mongo_db_batch_writer::mongo_db_batch_writer() = default;
+
+    mongo_db_batch_writer::~mongo_db_batch_writer() {
+        stop();
+    }
+
+    void mongo_db_batch_writer::start(
+        const mongocxx::uri& uri, const std::string& db_name, const mongo_db_batch_options& opts
+    ) {
+        pool_ = std::make_unique<mongocxx::pool>(uri);
+        db_name_ = db_name;
+        max_queue_size_ = std::max(opts.queue_size, std::size_t(1));
+        catchup_threads_ = std::max(opts.catchup_threads, uint32_t(1));
+        format_threads_ = std::max(opts.format_threads, uint32_t(1));
+        stopping_ = false;
+
+        format_work_ = std::make_unique<boost::asio::io_service::work>(format_ios_);
+        for (uint32_t i = 0; i < format_threads_; ++i) {
+            format_pool_.create_thread([this]() { format_ios_.run(); });
+        }
+
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    void mongo_db_batch_writer::stop() {
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            stopping_ = true;
+        }
+        not_empty_.notify_all();
+
+        if (thread_.joinable()) {
+            thread_.join();
+            log_stats();
+        }
+
+        if (format_work_) {
+            format_work_.reset();
+            format_pool_.join_all();
+        }
+    }
+
+    void mongo_db_batch_writer::push(mongo_db_batch batch, bool catchup) {
+        if (batch.empty()) {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (queue_.size() >= max_queue_size_) {
+            const auto start = fc::time_point::now();
+            ++producer_waits_;
+            not_full_.wait(lock, [&]() { return queue_.size() < max_queue_size_; });
+            producer_wait_us_ += (fc::time_point::now() - start).count();
+        }
+
+        queue_.push_back(queued_batch{std::move(batch), catchup});
+        if (queue_.size() > max_queue_size_seen_) {
+            max_queue_size_seen_ = queue_.size();
+        }
+        lock.unlock();
+        not_empty_.notify_one();
+    }
+
+    void mongo_db_batch_writer::log_stats() {
+        std::size_t queue_size = 0;
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            queue_size = queue_.size();
+        }
+
+        ilog("MongoDB writer: last written block ${b}, batches ${n}, documents ${d}, errors ${e}, "
+             "format time ${f} ms, write time ${w} ms, queue ${q} (max ${m}), waits for queue ${pw} (${pt} ms)",
+            ("b", last_written_block_.load())("n", batches_.load())("d", documents_.load())("e", errors_.load())
+            ("f", format_us_.load() / 1000)("w", write_us_.load() / 1000)("q", queue_size)("m", max_queue_size_seen_.load())
+            ("pw", producer_waits_.load())("pt", producer_wait_us_.load() / 1000));
+    }
+
+    void mongo_db_batch_writer::run() {
+        while (true) {
+            queued_batch item;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                not_empty_.wait(lock, [&]() { return !queue_.empty() || stopping_; });
+                if (queue_.empty()) {
+                    return;
+                }
+                item = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            not_full_.notify_one();
+
+            write(item);
+
+            ++batches_;
+            documents_ += item.batch.size;
+            last_written_block_ = item.batch.last_block;
+        }
+    }
+
+    mongo_db_batch_writer::collections_type mongo_db_batch_writer::format(mongo_db_batch& batch) {
+        using formatted_chunk = std::vector<std::pair<std::size_t, mongocxx::model::write>>;
+
+        auto& documents = batch.documents;
+        const std::size_t chunk_size = std::max(documents.size() / (format_threads_ * 4) + 1, std::size_t(256));
+        const std::size_t chunk_count = (documents.size() + chunk_size - 1) / chunk_size;
+
+        std::vector<formatted_chunk> chunks(chunk_count);
+        std::vector<std::future<void>> tasks;
+        tasks.reserve(chunk_count);
+
+        for (std::size_t c = 0; c < chunk_count; ++c) {
+            auto task = std::make_shared<std::packaged_task<void()>>([this, c, chunk_size, &documents, &chunks]() {
+                auto& chunk = chunks[c];
+                const auto end = std::min(documents.size(), (c + 1) * chunk_size);
+                chunk.reserve(end - c * chunk_size);
+                for (auto i = c * chunk_size; i < end; ++i) {
+                    try {
+                        chunk.emplace_back(i, documents[i].second());
+                    } catch (const std::exception& e) {
+                        ++errors_;
+                        wlog("Exception while formatting document of ${c}: ${e}", ("c", documents[i].first)("e", e.what()));
+                    }
+                }
+            });
+            tasks.push_back(task->get_future());
+            format_ios_.post([task]() { (*task)(); });
+        }
+
+        for (auto& task: tasks) {
+            task.wait();
+        }
+
+        // Chunks are merged in order, so updates of the same document aren't reordered
+        collections_type collections;
+        for (auto& chunk: chunks) {
+            for (auto& formatted: chunk) {
+                collections[documents[formatted.first].first].push_back(std::move(formatted.second));
+            }
+        }
+        return collections;
+    }
+
+    void mongo_db_batch_writer::write(queued_batch& item) {
+        auto& batch = item.batch;
+
+        const auto format_start = fc::time_point::now();
+        auto collections = format(batch);
+        format_us_ += (fc::time_point::now() - format_start).count();
+
+        if (!batch.indexes.empty()) {
+            try {
+                auto client = pool_->acquire();
+                auto database = (*client)[db_name_];
+                for (auto& index: batch.indexes) {
+                    database[index.first].create_index(index.second.view());
+                }
+            } catch (const std::exception& e) {
+                ++errors_;
+                wlog("Exception while creating indexes in MongoDB: ${e}", ("e", e.what()));
+            }
+        }
+
+        const auto write_start = fc::time_point::now();
+        if (!item.catchup || catchup_threads_ == 1 || collections.size() == 1) {
+            for (auto& collection: collections) {
+                write_collection(collection.first, collection.second);
+            }
+        } else {
+            // Documents of one collection are written in order by one thread, so updates of the same document aren't reordered
+            auto itr = collections.begin();
+            while (itr != collections.end()) {
+                std::vector<std::future<void>> tasks;
+                for (uint32_t i = 0; i < catchup_threads_ && itr != collections.end(); ++i, ++itr) {
+                    auto& collection = *itr;
+                    tasks.push_back(std::async(std::launch::async, [this, &collection]() {
+                        write_collection(collection.first, collection.second);
+                    }));
+                }
+                for (auto& task: tasks) {
+                    task.wait();
+                }
+            }
+        }
+        write_us_ += (fc::time_point::now() - write_start).count();
+    }
+
+    void mongo_db_batch_writer::write_collection(const std::string& name, std::vector<mongocxx::model::write>& models) {
+        if (models.empty()) {
+            return;
+        }
+
+        try {
+            // A batch covers several blocks, so it can have a few updates of the same document:
+            // an unordered bulk write can apply them in any order and leave an older state
+            mongocxx::options::bulk_write bulk_opts;
+            bulk_opts.ordered(true);
+
+            mongocxx::bulk_write bulk{bulk_opts};
+            for (auto& model: models) {
+                bulk.append(model);
+            }
+
+            auto client = pool_->acquire();
+            auto collection = (*client)[db_name_][name];
+            if (!collection.bulk_write(bulk)) {
+                ++errors_;
+                wlog("Failed to write blocks to Mongo DB");
+            }
+        } catch (const std::exception& e) {
+            ++errors_;
+            wlog("Unknown exception while writing blocks to mongo: ${e}", ("e", e.what()));
+        }
+    }
+
+}}} // graphene::plugins::mongo_db
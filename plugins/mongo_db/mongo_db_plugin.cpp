@@ -18,8 +18,15 @@ namespace mongo_db {
               db_(appbase::app().get_plugin<graphene::plugins::chain::plugin>().db()) {
         }
 
-        bool initialize(const std::string& uri, const bool write_raw, const std::vector<std::string>& op) {
-            return writer.initialize(uri, write_raw, op);
+        bool initialize(
+            const std::string& uri, const bool write_raw, const std::vector<std::string>& op,
+            const mongo_db_batch_options& batch_opts
+        ) {
+            return writer.initialize(uri, write_raw, op, batch_opts);
+        }
+
+        void shutdown() {
+            writer.shutdown();
         }
 
         ~mongo_db_plugin_impl() = default;
@@ -64,7 +71,25 @@ namespace mongo_db {
              "Write raw blocks into mongo or not")
             ("mongodb-write-operations",
              boost::program_options::value<std::vector<std::string>>()->multitoken()->zero_tokens()->composing(),
-             "List of operations to write into mongo");
+             "List of operations to write into mongo")
+            ("mongodb-queue-size",
+             boost::program_options::value<uint32_t>()->default_value(16),
+             "Max number of batches waiting for the writer thread, applying of blocks waits if the queue is full")
+            ("mongodb-batch-size",
+             boost::program_options::value<uint32_t>()->default_value(10000),
+             "Number of documents after which the batch is passed to the writer thread")
+            ("mongodb-flush-interval",
+             boost::program_options::value<uint32_t>()->default_value(1000),
+             "Max time in milliseconds for which documents are kept in the batch")
+            ("mongodb-catchup-batch-size",
+             boost::program_options::value<uint32_t>()->default_value(100000),
+             "Number of documents in the batch on reindex or sync")
+            ("mongodb-catchup-threads",
+             boost::program_options::value<uint32_t>()->default_value(4),
+             "Number of collections which are written in parallel on reindex or sync")
+            ("mongodb-format-threads",
+             boost::program_options::value<uint32_t>()->default_value(4),
+             "Number of threads which build BSON documents");
         cfg.add(cli);
     }
 
@@ -81,6 +106,26 @@ namespace mongo_db {
                 write_operations = options.at("mongodb-write-operations").as<std::vector<std::string>>();
             }
 
+            mongo_db_batch_options batch_opts;
+            if (options.count("mongodb-queue-size")) {
+                batch_opts.queue_size = options.at("mongodb-queue-size").as<uint32_t>();
+            }
+            if (options.count("mongodb-batch-size")) {
+                batch_opts.batch_size = options.at("mongodb-batch-size").as<uint32_t>();
+            }
+            if (options.count("mongodb-flush-interval")) {
+                batch_opts.flush_interval_ms = options.at("mongodb-flush-interval").as<uint32_t>();
+            }
+            if (options.count("mongodb-catchup-batch-size")) {
+                batch_opts.catchup_batch_size = options.at("mongodb-catchup-batch-size").as<uint32_t>();
+            }
+            if (options.count("mongodb-catchup-threads")) {
+                batch_opts.catchup_threads = options.at("mongodb-catchup-threads").as<uint32_t>();
+            }
+            if (options.count("mongodb-format-threads")) {
+                batch_opts.format_threads = options.at("mongodb-format-threads").as<uint32_t>();
+            }
+
             // First init mongo db
             if (options.count("mongodb-uri")) {
                 std::string uri_str = options.at("mongodb-uri").as<std::string>();
@@ -88,7 +133,7 @@ namespace mongo_db {
 
                 pimpl_ = std::make_unique<mongo_db_plugin_impl>(*this);
 
-                if (!pimpl_->initialize(uri_str, raw_blocks, write_operations)) {
+                if (!pimpl_->initialize(uri_str, raw_blocks, write_operations, batch_opts)) {
                     ilog("Cannot initialize MongoDB plugin. Plugin disabled.");
                     pimpl_.reset();
                     return;
@@ -121,6 +166,10 @@ namespace mongo_db {
     void mongo_db_plugin::plugin_shutdown() {
         ilog("mongo_db plugin: plugin_shutdown() begin");
 
+        if (pimpl_) {
+            pimpl_->shutdown();
+        }
+
         ilog("mongo_db plugin: plugin_shutdown() end");
     }
 
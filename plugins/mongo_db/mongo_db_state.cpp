@@ -48,74 +48,131 @@ namespace mongo_db {
         return doc;
     }
 
+    // Fields of content_object, which are copied on the write thread of database
+    struct content_snapshot final {
+        std::string oid;
+        std::string root_oid;
+        account_name_type author;
+        std::string permlink;
+        account_name_type parent_author;
+        std::string parent_permlink;
+        share_type abs_rshares;
+        time_point_sec active;
+        share_type author_rewards;
+        asset beneficiary_payout_value;
+        time_point_sec cashout_time;
+        uint32_t children = 0;
+        fc::uint128_t children_rshares;
+        time_point_sec created;
+        asset curator_payout_value;
+        uint16_t depth = 0;
+        time_point_sec last_payout;
+        time_point_sec last_update;
+        share_type net_rshares;
+        int32_t net_votes = 0;
+        asset payout_value;
+        uint64_t total_vote_weight = 0;
+        share_type vote_rshares;
+        std::vector<beneficiary_route_type> beneficiaries;
+        std::string title;
+        std::string body;
+        std::string json_metadata;
+    };
+
     bool state_writer::format_content(const std::string& auth, const std::string& perm) {
         try {
             auto& content = db_.get_content(auth, perm);
-            auto oid = std::string(auth).append("/").append(perm);
-            auto oid_hash = hash_oid(oid);
-
-            auto doc = create_document("content_object", "_id", oid_hash);
-            auto& body = doc.doc;
-
-            body << "$set" << open_document;
-
-            format_oid(body, oid);
-
-            format_value(body, "removed", false);
-
-            format_value(body, "author", auth);
-            format_value(body, "permlink", perm);
-            format_value(body, "abs_rshares", content.abs_rshares);
-            format_value(body, "active", content.active);
-
-            format_value(body, "author_rewards", content.author_rewards);
-            format_value(body, "beneficiary_payout", content.beneficiary_payout_value);
-            format_value(body, "cashout_time", content.cashout_time);
-            format_value(body, "children", content.children);
-            format_value(body, "children_rshares", content.children_rshares);
-            format_value(body, "created", content.created);
-            format_value(body, "curator_payout", content.curator_payout_value);
-            format_value(body, "depth", content.depth);
-            format_value(body, "last_payout", content.last_payout);
-            format_value(body, "last_update", content.last_update);
-            format_value(body, "net_rshares", content.net_rshares);
-            format_value(body, "net_votes", content.net_votes);
-            format_value(body, "parent_author", content.parent_author);
-            format_value(body, "parent_permlink", content.parent_permlink);
-            format_value(body, "total_payout", content.payout_value);
-            format_value(body, "total_vote_weight", content.total_vote_weight);
-            format_value(body, "vote_rshares", content.vote_rshares);
-
-            if (!content.beneficiaries.empty()) {
-                array ben_array;
-                for (auto& b: content.beneficiaries) {
-                    document tmp;
-                    format_value(tmp, "account", b.account);
-                    format_value(tmp, "weight", b.weight);
-                    ben_array << tmp;
-                }
-                body << "beneficiaries" << ben_array;
-            }
-
-            auto& content = db_.get_content_type(content_id_type(content.id));
+            auto& content_type = db_.get_content_type(content_id_type(content.id));
+
+            content_snapshot snapshot;
+            snapshot.oid = std::string(auth).append("/").append(perm);
+            snapshot.author = content.author;
+            snapshot.permlink = perm;
+            snapshot.parent_author = content.parent_author;
+            snapshot.parent_permlink = to_string(content.parent_permlink);
+            snapshot.abs_rshares = content.abs_rshares;
+            snapshot.active = content.active;
+            snapshot.author_rewards = content.author_rewards;
+            snapshot.beneficiary_payout_value = content.beneficiary_payout_value;
+            snapshot.cashout_time = content.cashout_time;
+            snapshot.children = content.children;
+            snapshot.children_rshares = content.children_rshares;
+            snapshot.created = content.created;
+            snapshot.curator_payout_value = content.curator_payout_value;
+            snapshot.depth = content.depth;
+            snapshot.last_payout = content.last_payout;
+            snapshot.last_update = content.last_update;
+            snapshot.net_rshares = content.net_rshares;
+            snapshot.net_votes = content.net_votes;
+            snapshot.payout_value = content.payout_value;
+            snapshot.total_vote_weight = content.total_vote_weight;
+            snapshot.vote_rshares = content.vote_rshares;
+            snapshot.beneficiaries.assign(content.beneficiaries.begin(), content.beneficiaries.end());
+            snapshot.title = to_string(content_type.title);
+            snapshot.body = to_string(content_type.body);
+            snapshot.json_metadata = to_string(content_type.json_metadata);
 
-            format_value(body, "title", content.title);
-            format_value(body, "body", content.body);
-            format_value(body, "json_metadata", content.json_metadata);
-
-            std::string root_oid;
             if (content.parent_author == CHAIN_ROOT_POST_PARENT) {
-                root_oid = oid;
+                snapshot.root_oid = snapshot.oid;
             } else {
                 auto& root_content = db_.get<content_object, by_id>(content.root_content);
-                root_oid = std::string(root_content.author).append("/").append(root_content.permlink.c_str());
+                snapshot.root_oid = std::string(root_content.author).append("/").append(root_content.permlink.c_str());
             }
-            format_oid(body, "root_content", root_oid);
+
+            auto doc = create_document("content_object", "_id", hash_oid(snapshot.oid));
             document root_content_index;
             root_content_index << "root_content" << 1;
             doc.indexes_to_create.push_back(std::move(root_content_index));
 
-            body << close_document;
+            doc.format = [snapshot = std::move(snapshot)](document& body) {
+                body << "$set" << open_document;
+
+                format_oid(body, snapshot.oid);
+
+                format_value(body, "removed", false);
+
+                format_value(body, "author", snapshot.author);
+                format_value(body, "permlink", snapshot.permlink);
+                format_value(body, "abs_rshares", snapshot.abs_rshares);
+                format_value(body, "active", snapshot.active);
+
+                format_value(body, "author_rewards", snapshot.author_rewards);
+                format_value(body, "beneficiary_payout", snapshot.beneficiary_payout_value);
+                format_value(body, "cashout_time", snapshot.cashout_time);
+                format_value(body, "children", snapshot.children);
+                format_value(body, "children_rshares", snapshot.children_rshares);
+                format_value(body, "created", snapshot.created);
+                format_value(body, "curator_payout", snapshot.curator_payout_value);
+                format_value(body, "depth", snapshot.depth);
+                format_value(body, "last_payout", snapshot.last_payout);
+                format_value(body, "last_update", snapshot.last_update);
+                format_value(body, "net_rshares", snapshot.net_rshares);
+                format_value(body, "net_votes", snapshot.net_votes);
+                format_value(body, "parent_author", snapshot.parent_author);
+                format_value(body, "parent_permlink", snapshot.parent_permlink);
+                format_value(body, "total_payout", snapshot.payout_value);
+                format_value(body, "total_vote_weight", snapshot.total_vote_weight);
+                format_value(body, "vote_rshares", snapshot.vote_rshares);
+
+                if (!snapshot.beneficiaries.empty()) {
+                    array ben_array;
+                    for (auto& b: snapshot.beneficiaries) {
+                        document tmp;
+                        format_value(tmp, "account", b.account);
+                        format_value(tmp, "weight", b.weight);
+                        ben_array << tmp;
+                    }
+                    body << "beneficiaries" << ben_array;
+                }
+
+                format_value(body, "title", snapshot.title);
+                format_value(body, "body", snapshot.body);
+                format_value(body, "json_metadata", snapshot.json_metadata);
+
+                format_oid(body, "root_content", snapshot.root_oid);
+
+                body << close_document;
+            };
 
             bmi_insert_or_replace(all_docs, std::move(doc));
 
@@ -132,62 +189,62 @@ namespace mongo_db {
 
     void state_writer::format_account(const std::string& name) {
         try {
-            auto& account = db_.get_account(name);
-            auto oid = name;
-            auto oid_hash = hash_oid(oid);
+            // account_object has no fields in shared memory, so it's copied as is
+            auto account = db_.get_account(name);
 
-            auto doc = create_document("account_object", "_id", oid_hash);
-            auto& body = doc.doc;
+            auto doc = create_document("account_object", "_id", hash_oid(name));
 
-            body << "$set" << open_document;
+            doc.format = [account = std::move(account)](document& body) {
+                body << "$set" << open_document;
 
-            format_oid(body, oid);
+                format_oid(body, account.name);
 
-            format_value(body, "name", account.name);
-            format_value(body, "memo_key", std::string(account.memo_key));
-            format_value(body, "proxy", account.proxy);
+                format_value(body, "name", account.name);
+                format_value(body, "memo_key", std::string(account.memo_key));
+                format_value(body, "proxy", account.proxy);
 
-            format_value(body, "last_account_update", account.last_account_update);
+                format_value(body, "last_account_update", account.last_account_update);
 
-            format_value(body, "created", account.created);
-            format_value(body, "recovery_account", account.recovery_account);
-            format_value(body, "last_account_recovery", account.last_account_recovery);
-            format_value(body, "subcontent_count", account.subcontent_count);
-            format_value(body, "vote_count", account.vote_count);
-            format_value(body, "content_count", account.content_count);
+                format_value(body, "created", account.created);
+                format_value(body, "recovery_account", account.recovery_account);
+                format_value(body, "last_account_recovery", account.last_account_recovery);
+                format_value(body, "subcontent_count", account.subcontent_count);
+                format_value(body, "vote_count", account.vote_count);
+                format_value(body, "content_count", account.content_count);
 
-            format_value(body, "energy", account.energy);
-            format_value(body, "last_vote_time", account.last_vote_time);
+                format_value(body, "energy", account.energy);
+                format_value(body, "last_vote_time", account.last_vote_time);
 
-            format_value(body, "balance", account.balance);
+                format_value(body, "balance", account.balance);
 
-            format_value(body, "curation_rewards", account.curation_rewards);
-            format_value(body, "posting_rewards", account.posting_rewards);
+                format_value(body, "curation_rewards", account.curation_rewards);
+                format_value(body, "posting_rewards", account.posting_rewards);
 
-            format_value(body, "vesting_shares", account.vesting_shares);
-            format_value(body, "delegated_vesting_shares", account.delegated_vesting_shares);
-            format_value(body, "received_vesting_shares", account.received_vesting_shares);
+                format_value(body, "vesting_shares", account.vesting_shares);
+                format_value(body, "delegated_vesting_shares", account.delegated_vesting_shares);
+                format_value(body, "received_vesting_shares", account.received_vesting_shares);
 
-            format_value(body, "vesting_withdraw_rate", account.vesting_withdraw_rate);
-            format_value(body, "next_vesting_withdrawal", account.next_vesting_withdrawal);
-            format_value(body, "withdrawn", account.withdrawn);
-            format_value(body, "to_withdraw", account.to_withdraw);
-            format_value(body, "withdraw_routes", account.withdraw_routes);
+                format_value(body, "vesting_withdraw_rate", account.vesting_withdraw_rate);
+                format_value(body, "next_vesting_withdrawal", account.next_vesting_withdrawal);
+                format_value(body, "withdrawn", account.withdrawn);
+                format_value(body, "to_withdraw", account.to_withdraw);
+                format_value(body, "withdraw_routes", account.withdraw_routes);
 
-            if (account.proxied_vsf_votes.size() != 0) {
-                array ben_array;
-                for (auto& b: account.proxied_vsf_votes) {
-                    ben_array << b;
+                if (account.proxied_vsf_votes.size() != 0) {
+                    array ben_array;
+                    for (auto& b: account.proxied_vsf_votes) {
+                        ben_array << b;
+                    }
+                    body << "proxied_vsf_votes" << ben_array;
                 }
-                body << "proxied_vsf_votes" << ben_array;
-            }
 
-            format_value(body, "witnesses_voted_for", account.witnesses_voted_for);
+                format_value(body, "witnesses_voted_for", account.witnesses_voted_for);
 
-            format_value(body, "last_root_post", account.last_root_post);
-            format_value(body, "last_post", account.last_post);
+                format_value(body, "last_root_post", account.last_root_post);
+                format_value(body, "last_post", account.last_post);
 
-            body << close_document;
+                body << close_document;
+            };
 
             bmi_insert_or_replace(all_docs, std::move(doc));
 
@@ -217,24 +274,25 @@ namespace mongo_db {
                 document content_index;
                 content_index << "content" << 1;
                 doc.indexes_to_create.push_back(std::move(content_index));
-                auto &body = doc.doc;
 
-                body << "$set" << open_document;
+                doc.format = [op, vote = *itr, content_oid, oid](document& body) {
+                    body << "$set" << open_document;
 
-                format_oid(body, oid);
-                format_oid(body, "content", content_oid);
+                    format_oid(body, oid);
+                    format_oid(body, "content", content_oid);
 
-                format_value(body, "author", op.author);
-                format_value(body, "permlink", op.permlink);
-                format_value(body, "voter", op.voter);
+                    format_value(body, "author", op.author);
+                    format_value(body, "permlink", op.permlink);
+                    format_value(body, "voter", op.voter);
 
-                format_value(body, "weight", itr->weight);
-                format_value(body, "rshares", itr->rshares);
-                format_value(body, "vote_percent", itr->vote_percent);
-                format_value(body, "last_update", itr->last_update);
-                format_value(body, "num_changes", itr->num_changes);
+                    format_value(body, "weight", vote.weight);
+                    format_value(body, "rshares", vote.rshares);
+                    format_value(body, "vote_percent", vote.vote_percent);
+                    format_value(body, "last_update", vote.last_update);
+                    format_value(body, "num_changes", vote.num_changes);
 
-                body << close_document;
+                    body << close_document;
+                };
 
                 bmi_insert_or_replace(all_docs, std::move(doc));
             }
@@ -261,18 +319,18 @@ namespace mongo_db {
         // Will be updated with the following fields. If no one - created with these fields.
 	auto content = create_document("content_object", "_id", content_oid_hash);
 
-        auto& body = content.doc;
-
-        body << "$set" << open_document;
+        content.format = [op, content_oid](document& body) {
+            body << "$set" << open_document;
 
-        format_oid(body, content_oid);
+            format_oid(body, content_oid);
 
-        format_value(body, "removed", true);
+            format_value(body, "removed", true);
 
-        format_value(body, "author", op.author);
-        format_value(body, "permlink", op.permlink);
+            format_value(body, "author", op.author);
+            format_value(body, "permlink", op.permlink);
 
-        body << close_document;
+            body << close_document;
+        };
 
         bmi_insert_or_replace(all_docs, std::move(content));
 
@@ -284,12 +342,8 @@ namespace mongo_db {
 
     auto state_writer::operator()(const transfer_operation& op) -> result_type {
         auto doc = create_document("transfer", "", "");
-        auto& body = doc.doc;
 
-        format_value(body, "from", op.from);
-        format_value(body, "to", op.to);
-        format_value(body, "amount", op.amount);
-        format_value(body, "memo", op.memo);
+        std::string content_oid;
 
         std::vector<std::string> part;
         auto path = op.memo;
@@ -299,13 +353,23 @@ namespace mongo_db {
             auto perm = part[1];
 
             if (format_content(acnt, perm)) {
-                auto content_oid = acnt.append("/").append(perm);
-                format_oid(body, "content", content_oid);
+                content_oid = acnt.append("/").append(perm);
             } else {
                 ilog("unable to find body");
             }
         }
 
+        doc.format = [op, content_oid](document& body) {
+            format_value(body, "from", op.from);
+            format_value(body, "to", op.to);
+            format_value(body, "amount", op.amount);
+            format_value(body, "memo", op.memo);
+
+            if (!content_oid.empty()) {
+                format_oid(body, "content", content_oid);
+            }
+        };
+
         format_account(op.from);
         format_account(op.to);
 
@@ -418,20 +482,20 @@ namespace mongo_db {
             auto content_oid_hash = hash_oid(content_oid);
 
             auto doc = create_document("author_reward", "_id", content_oid_hash);
-            auto &body = doc.doc;
-
-            body << "$set" << open_document;
+            doc.format = [op, content_oid, timestamp = state_block.timestamp](document& body) {
+                body << "$set" << open_document;
 
-            format_value(body, "removed", false);
-            format_oid(body, content_oid);
-            format_oid(body, "content", content_oid);
-            format_value(body, "author", op.author);
-            format_value(body, "permlink", op.permlink);
-            format_value(body, "timestamp", state_block.timestamp);
-            format_value(body, "token_payout", op.token_payout);
-            format_value(body, "vesting_payout", op.vesting_payout);
+                format_value(body, "removed", false);
+                format_oid(body, content_oid);
+                format_oid(body, "content", content_oid);
+                format_value(body, "author", op.author);
+                format_value(body, "permlink", op.permlink);
+                format_value(body, "timestamp", timestamp);
+                format_value(body, "token_payout", op.token_payout);
+                format_value(body, "vesting_payout", op.vesting_payout);
 
-            body << close_document;
+                body << close_document;
+            };
 
             bmi_insert_or_replace(all_docs, std::move(doc));
 
@@ -450,21 +514,21 @@ namespace mongo_db {
             document content_index;
             content_index << "content" << 1;
             doc.indexes_to_create.push_back(std::move(content_index));
-            auto &body = doc.doc;
-
-            body << "$set" << open_document;
+            doc.format = [op, content_oid, vote_oid, timestamp = state_block.timestamp](document& body) {
+                body << "$set" << open_document;
 
-            format_value(body, "removed", false);
-            format_oid(body, vote_oid);
-            format_oid(body, "content", content_oid);
-            format_oid(body, "vote", vote_oid);
-            format_value(body, "author", op.content_author);
-            format_value(body, "permlink", op.content_permlink);
-            format_value(body, "timestamp", state_block.timestamp);
-            format_value(body, "reward", op.reward);
-            format_value(body, "curator", op.curator);
+                format_value(body, "removed", false);
+                format_oid(body, vote_oid);
+                format_oid(body, "content", content_oid);
+                format_oid(body, "vote", vote_oid);
+                format_value(body, "author", op.content_author);
+                format_value(body, "permlink", op.content_permlink);
+                format_value(body, "timestamp", timestamp);
+                format_value(body, "reward", op.reward);
+                format_value(body, "curator", op.curator);
 
-            body << close_document;
+                body << close_document;
+            };
 
             bmi_insert_or_replace(all_docs, std::move(doc));
         } catch (...) {
@@ -478,19 +542,19 @@ namespace mongo_db {
             auto content_oid_hash = hash_oid(content_oid);
 
             auto doc = create_document("content_reward", "_id", content_oid_hash);
-            auto &body = doc.doc;
-
-            body << "$set" << open_document;
+            doc.format = [op, content_oid, timestamp = state_block.timestamp](document& body) {
+                body << "$set" << open_document;
 
-            format_value(body, "removed", false);
-            format_oid(body, content_oid);
-            format_oid(body, "content", content_oid);
-            format_value(body, "author", op.author);
-            format_value(body, "permlink", op.permlink);
-            format_value(body, "timestamp", state_block.timestamp);
-            format_value(body, "payout", op.payout);
+                format_value(body, "removed", false);
+                format_oid(body, content_oid);
+                format_oid(body, "content", content_oid);
+                format_value(body, "author", op.author);
+                format_value(body, "permlink", op.permlink);
+                format_value(body, "timestamp", timestamp);
+                format_value(body, "payout", op.payout);
 
-            body << close_document;
+                body << close_document;
+            };
 
             bmi_insert_or_replace(all_docs, std::move(doc));
         } catch (...) {
@@ -508,20 +572,20 @@ namespace mongo_db {
             document content_index;
             content_index << "content" << 1;
             doc.indexes_to_create.push_back(std::move(content_index));
-            auto &body = doc.doc;
-
-            body << "$set" << open_document;
+            doc.format = [op, content_oid, benefactor_oid, timestamp = state_block.timestamp](document& body) {
+                body << "$set" << open_document;
 
-            format_value(body, "removed", false);
-            format_oid(body, benefactor_oid);
-            format_oid(body, "content", content_oid);
-            format_value(body, "author", op.author);
-            format_value(body, "permlink", op.permlink);
-            format_value(body, "timestamp", state_block.timestamp);
-            format_value(body, "reward", op.reward);
-            format_value(body, "benefactor", op.benefactor);
+                format_value(body, "removed", false);
+                format_oid(body, benefactor_oid);
+                format_oid(body, "content", content_oid);
+                format_value(body, "author", op.author);
+                format_value(body, "permlink", op.permlink);
+                format_value(body, "timestamp", timestamp);
+                format_value(body, "reward", op.reward);
+                format_value(body, "benefactor", op.benefactor);
 
-            body << close_document;
+                body << close_document;
+            };
 
             bmi_insert_or_replace(all_docs, std::move(doc));
         } catch (...) {
@@ -36,14 +36,15 @@ namespace mongo_db {
     mongo_db_writer::~mongo_db_writer() {
     }
 
-    bool mongo_db_writer::initialize(const std::string& uri_str, const bool write_raw, const std::vector<std::string>& ops) {
+    bool mongo_db_writer::initialize(
+        const std::string& uri_str, const bool write_raw, const std::vector<std::string>& ops,
+        const mongo_db_batch_options& opts
+    ) {
         try {
             uri = mongocxx::uri {uri_str};
-            mongo_conn = mongocxx::client {uri};
             db_name = uri.database().empty() ? "viz" : uri.database();
-            mongo_database = mongo_conn[db_name];
-            bulk_opts.ordered(false);
             write_raw_blocks = write_raw;
+            batch_opts = opts;
 
             for (auto& op : ops) {
                 if (!op.empty()) {
@@ -51,6 +52,9 @@ namespace mongo_db {
                 }
             }
 
+            batch_writer.start(uri, db_name, batch_opts);
+            last_flush = fc::time_point::now();
+
             ilog("MongoDB writer initialized.");
 
             return true;
@@ -65,6 +69,11 @@ namespace mongo_db {
         }
     }
 
+    void mongo_db_writer::shutdown() {
+        flush(false);
+        batch_writer.stop();
+    }
+
     void mongo_db_writer::on_block(const signed_block& block) {
 
         try {
@@ -104,6 +113,7 @@ namespace mongo_db {
                         virtual_ops.erase(head_iter->first);
                         throw;
                     }
+                    batch.last_block = head_iter->first;
                     blocks.erase(head_iter);
                     virtual_ops.erase(head_iter->first);
                 }
@@ -120,12 +130,21 @@ namespace mongo_db {
                     }
                 }
 
-                // Writing bulk to mongo
+                // Passing batch to the writer thread. On reindex or sync blocks are far behind the current time,
+                // so documents of more blocks are written at once
 
-                write_data();
+                const auto now = fc::time_point::now();
+                const bool catchup = now - block.timestamp > fc::minutes(1);
+                const auto batch_size = catchup ? batch_opts.catchup_batch_size : batch_opts.batch_size;
+                if (batch.size >= batch_size || now - last_flush >= fc::milliseconds(batch_opts.flush_interval_ms)) {
+                    flush(catchup);
+                }
             }
 
             ++processed_blocks;
+            if (processed_blocks % 100000 == 0) {
+                batch_writer.log_stats();
+            }
         }
         catch (const std::exception& e) {
             wlog("Unknown exception in MongoDB ${e}", ("e", e.what()));
@@ -141,6 +160,13 @@ namespace mongo_db {
     }
 
     void mongo_db_writer::write_raw_block(const signed_block& block, const operations& ops) {
+        static const std::string blocks = "blocks";
+        batch.add(blocks, [block, ops]() -> mongocxx::model::write {
+            return mongocxx::model::insert_one{format_raw_block(block, ops).extract()};
+        });
+    }
+
+    document mongo_db_writer::format_raw_block(const signed_block& block, const operations& ops) {
 
         operation_writer op_writer;
         document block_doc;
@@ -194,57 +220,50 @@ namespace mongo_db {
         static const std::string transactions = "transactions";
         block_doc << transactions << transactions_array;
 
-        static const std::string blocks = "blocks";
-        if (formatted_blocks.find(blocks) == formatted_blocks.end()) {
-            formatted_blocks[blocks] = std::make_unique<mongocxx::bulk_write>(bulk_opts);
-        }
-
-        mongocxx::model::insert_one insert_msg{block_doc.view()};
-        formatted_blocks[blocks]->append(insert_msg);
+        return block_doc;
     }
 
     void mongo_db_writer::write_document(named_document const& named_doc) {
-        if (formatted_blocks.find(named_doc.collection_name) == formatted_blocks.end()) {
-            formatted_blocks[named_doc.collection_name] = std::make_unique<mongocxx::bulk_write>(bulk_opts);
-        }
+        // Documents are built on the worker pool from the state copied by state_writer
+        auto format = named_doc.format;
+        auto keyval = named_doc.keyval;
+        batch.add(named_doc.collection_name, [format, keyval]() -> mongocxx::model::write {
+            document body;
+            format(body);
+
+            auto view = body.view();
+            auto itr = view.find("$set");
+            if (view.end() == itr) {
+                return mongocxx::model::insert_one{body.extract()};
+            }
 
-        auto view = named_doc.doc.view();
-        auto itr = view.find("$set");
-        if (view.end() == itr) {
-            mongocxx::model::insert_one msg{std::move(view)};
-            formatted_blocks[named_doc.collection_name]->append(msg);
-        } else {
             document filter;
 
-            filter << "_id" << bsoncxx::oid(named_doc.keyval);
+            filter << "_id" << bsoncxx::oid(keyval);
 
-            mongocxx::model::update_one msg{filter.view(),
-                view};
+            mongocxx::model::update_one msg{filter.extract(), body.extract()};
             msg.upsert(true);
-            formatted_blocks[named_doc.collection_name]->append(msg);
-        }
+            return msg;
+        });
 
         if (indexes.find(named_doc.collection_name) == indexes.end()) {
             for (auto& index_to_create : named_doc.indexes_to_create) {
-                mongo_database[named_doc.collection_name].create_index(index_to_create.view());
+                batch.indexes.emplace_back(named_doc.collection_name, bsoncxx::document::value(index_to_create.view()));
                 indexes[named_doc.collection_name] = "created";
             }
         }
     }
 
     void mongo_db_writer::remove_document(named_document const& named_doc) {
-        if (formatted_blocks.find(named_doc.collection_name) == formatted_blocks.end()) {
-            formatted_blocks[named_doc.collection_name] = std::make_unique<mongocxx::bulk_write>(bulk_opts);
-        }
-
-        document filter;
-        filter << named_doc.key << bsoncxx::oid(named_doc.keyval);
-        auto v1 = filter.view();
-        document newval;
-        newval << "$set" << open_document << "removed" << true << close_document;
-        auto v2 = newval.view();
-        mongocxx::model::update_many msg{v1, v2};
-        formatted_blocks[named_doc.collection_name]->append(msg);
+        auto key = named_doc.key;
+        auto keyval = named_doc.keyval;
+        batch.add(named_doc.collection_name, [key, keyval]() -> mongocxx::model::write {
+            document filter;
+            filter << key << bsoncxx::oid(keyval);
+            document newval;
+            newval << "$set" << open_document << "removed" << true << close_document;
+            return mongocxx::model::update_many{filter.extract(), newval.extract()};
+        });
     }
 
     void mongo_db_writer::write_block_operations(state_writer& st_writer, const signed_block& block, const operations& ops) {
@@ -269,27 +288,13 @@ namespace mongo_db {
             << "transaction_expiration"     << tran.expiration;
     }
 
-    void mongo_db_writer::write_data() {
-        auto iter = formatted_blocks.begin();
-        for (; iter != formatted_blocks.end(); ++iter) {
-
-            auto& oper = *iter;
-            try {
-                const std::string& collection_name = oper.first;
-                mongocxx::collection _collection = mongo_database[collection_name];
-
-                auto& bulkp = oper.second;
-                if (!_collection.bulk_write(*bulkp)) {
-                    wlog("Failed to write blocks to Mongo DB");
-                }
-            }
-            catch (const std::exception& e) {
-                wlog("Unknown exception while writing blocks to mongo: ${e}", ("e", e.what()));
-                // If we got some errors writing block into mongo just skip this block and move on
-                formatted_blocks.erase(iter);
-                throw;
-            }
+    void mongo_db_writer::flush(bool catchup) {
+        last_flush = fc::time_point::now();
+        if (batch.empty()) {
+            return;
         }
-        formatted_blocks.clear();
+
+        batch_writer.push(std::move(batch), catchup);
+        batch = mongo_db_batch();
     }
 }}}
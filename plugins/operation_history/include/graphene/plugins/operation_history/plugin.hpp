@@ -69,6 +69,12 @@ namespace graphene { namespace plugins { namespace operation_history {
         void plugin_startup() override;
         void plugin_shutdown() override;
 
+        /**
+         * Returns operation by id, which is passed to other plugins in operation_notification::db_id.
+         * Should be called under the read lock of database.
+         */
+        applied_operation get_operation(operation_id_type id) const;
+
         DECLARE_API(
             /**
              *  @brief Get sequence of operations included/generated within a particular block
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <graphene/chain/operation_notification.hpp>
+#include <graphene/plugins/operation_history/applied_operation.hpp>
+
+#include <boost/filesystem/path.hpp>
+
+#include <fc/optional.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace graphene { namespace plugins { namespace operation_history {
+
+    struct transaction_location final {
+        uint32_t block = 0;
+        uint32_t trx_in_block = 0;
+    };
+
+    /**
+     * Stores history of operations out of the shared memory.
+     *
+     * Operations of irreversible blocks are serialized into append-only segment files,
+     * which are mapped into memory:
+     *
+     * +--------+------------------------+------------------------+-----+
+     * | Header | Size of Op 1 | Op 1    | Size of Op 2 | Op 2    | ... |
+     * +--------+------------------------+------------------------+-----+
+     *
+     * There are three fixed-size indexes:
+     *  - ops.index - position of operation by its id (segment number in the high 24 bits and offset in the low 40 bits)
+     *  - blocks.index - the id of the next operation after the block by the block number
+     *  - transactions.index - id of transaction, number of block and position of transaction in the block
+     *
+     * and transactions.hash - the hash table of records of transactions.index by transaction id,
+     * so the lookup of transaction doesn't need anything in memory and nothing is rebuilt on opening.
+     *
+     * The header of file keeps the size of its data, files are grown by large chunks, so appending doesn't remap them.
+     * The blocks.index is written the last, so it defines what is stored in other files,
+     * they are truncated on opening if the previous writing was interrupted.
+     *
+     * Operations of reversible blocks are kept in memory, and are written to disk when block becomes irreversible.
+     *
+     * The store isn't synchronized, because writing happens under the write lock of database,
+     * and reading happens under the read lock of database.
+     */
+    class segment_store final {
+    public:
+        segment_store();
+
+        ~segment_store();
+
+        void open(const boost::filesystem::path &dir, uint64_t segment_size);
+
+        void close();
+
+        // Is called from the write thread of database
+        void start_block(uint32_t block_num);
+
+        // Is called from the write thread of database, returns id of operation
+        int64_t add_operation(const graphene::chain::operation_notification &note, const fc::time_point_sec &timestamp);
+
+        // Is called from the write thread of database
+        void apply_block(uint32_t block_num, uint32_t last_irreversible_block_num);
+
+        std::vector<applied_operation> get_ops_in_block(uint32_t block_num, bool only_virtual) const;
+
+        fc::optional<transaction_location> find_transaction(const graphene::protocol::transaction_id_type &id) const;
+
+        applied_operation get_operation(int64_t id) const;
+
+    private:
+        struct impl;
+
+        std::unique_ptr<impl> my;
+    };
+
+} } } // graphene::plugins::operation_history
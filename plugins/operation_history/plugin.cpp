@@ -1,5 +1,6 @@
 #include <graphene/plugins/operation_history/plugin.hpp>
 #include <graphene/plugins/operation_history/history_object.hpp>
+#include <graphene/plugins/operation_history/segment_store.hpp>
 
 #include <graphene/chain/operation_notification.hpp>
 
@@ -12,28 +13,50 @@
 
 namespace graphene { namespace plugins { namespace operation_history {
 
-    struct operation_visitor_filter;
-
     using namespace graphene::protocol;
     using namespace graphene::chain;
 
-    struct operation_visitor {
-        operation_visitor(
-            graphene::chain::database& db,
-            graphene::chain::operation_notification& op_note)
-            : database(db),
-              note(op_note) {
+    struct operation_filter_visitor final {
+        operation_filter_visitor(const fc::flat_set<std::string>& ops_list, bool is_blacklist)
+            : filter(ops_list),
+              blacklist(is_blacklist) {
         }
 
-        using result_type = void;
+        using result_type = bool;
 
-        graphene::chain::database& database;
-        graphene::chain::operation_notification& note;
+        const fc::flat_set<std::string>& filter;
+        bool blacklist;
+
+        template <typename T>
+        bool operator()(const T&) const {
+            const bool listed = filter.find(fc::get_typename<T>::name()) != filter.end();
+            return listed != blacklist;
+        }
+    };
+
+    struct plugin::plugin_impl final {
+    public:
+        plugin_impl(): database(appbase::app().get_plugin<chain::plugin>().db()) {
+        }
+
+        ~plugin_impl() = default;
+
+        void on_operation(graphene::chain::operation_notification& note) {
+            if (filter_content) {
+                if (database.head_block_num() < start_block ||
+                    !note.op.visit(operation_filter_visitor(ops_list, blacklist))
+                ) {
+                    return;
+                }
+            }
 
-        template<typename Op>
-        void operator()(Op&&) const {
             note.stored_in_db = true;
 
+            if (store) {
+                note.db_id = store->add_operation(note, database.head_block_time());
+                return;
+            }
+
             database.create<operation_object>([&](operation_object& obj) {
                 note.db_id = obj.id._id;
 
@@ -50,62 +73,15 @@ namespace graphene { namespace plugins { namespace operation_history {
                 fc::raw::pack(ds, note.op);
             });
         }
-    };
-
-    struct operation_visitor_filter final : operation_visitor {
-
-        operation_visitor_filter(
-            graphene::chain::database& db,
-            graphene::chain::operation_notification& note,
-            const fc::flat_set<std::string>& ops_list,
-            bool is_blacklist,
-            uint32_t block)
-            : operation_visitor(db, note),
-              filter(ops_list),
-              blacklist(is_blacklist),
-              start_block(block) {
-        }
-
-        const fc::flat_set<std::string>& filter;
-        bool blacklist;
-        uint32_t start_block;
-
-        template <typename T>
-        void operator()(const T& op) const {
-            if (database.head_block_num() < start_block) {
-                return;
-            }
-            if (filter.find(fc::get_typename<T>::name()) != filter.end()) {
-                if (!blacklist) {
-                    operation_visitor::operator()(op);
-                }
-            } else {
-                if (blacklist) {
-                   operation_visitor::operator()(op);
-                }
-            }
-        }
-    };
-
-    struct plugin::plugin_impl final {
-    public:
-        plugin_impl(): database(appbase::app().get_plugin<chain::plugin>().db()) {
-        }
-
-        ~plugin_impl() = default;
-
-        void on_operation(graphene::chain::operation_notification& note) {
-            if (filter_content) {
-                note.op.visit(operation_visitor_filter(database, note, ops_list, blacklist, start_block));
-            } else {
-                note.op.visit(operation_visitor(database, note));
-            }
-        }
 
         std::vector<applied_operation> get_ops_in_block(
             uint32_t block_num,
             bool only_virtual
         ) {
+            if (store) {
+                return store->get_ops_in_block(block_num, only_virtual);
+            }
+
             const auto& idx = database.get_index<operation_index>().indices().get<by_location>();
             auto itr = idx.lower_bound(block_num);
             std::vector<applied_operation> result;
@@ -118,25 +94,59 @@ namespace graphene { namespace plugins { namespace operation_history {
             return result;
         }
 
-        annotated_signed_transaction get_transaction(transaction_id_type id) {
+        fc::optional<transaction_location> find_transaction(const transaction_id_type& id) const {
+            if (store) {
+                return store->find_transaction(id);
+            }
+
             const auto &idx = database.get_index<operation_index>().indices().get<by_transaction_id>();
             auto itr = idx.lower_bound(id);
             if (itr != idx.end() && itr->trx_id == id) {
-                auto blk = database.fetch_block_by_number(itr->block);
-                FC_ASSERT(blk.valid());
-                FC_ASSERT(blk->transactions.size() > itr->trx_in_block);
-                annotated_signed_transaction result = blk->transactions[itr->trx_in_block];
-                result.block_num = itr->block;
-                result.transaction_num = itr->trx_in_block;
-                return result;
+                return transaction_location{itr->block, itr->trx_in_block};
+            }
+            return {};
+        }
+
+        annotated_signed_transaction get_transaction(transaction_id_type id) {
+            auto location = find_transaction(id);
+            FC_ASSERT(location.valid(), "Unknown Transaction ${t}", ("t", id));
+
+            auto blk = database.fetch_block_by_number(location->block);
+            FC_ASSERT(blk.valid());
+            FC_ASSERT(blk->transactions.size() > location->trx_in_block);
+            annotated_signed_transaction result = blk->transactions[location->trx_in_block];
+            result.block_num = location->block;
+            result.transaction_num = location->trx_in_block;
+            return result;
+        }
+
+        applied_operation get_operation(operation_id_type id) const {
+            if (store) {
+                return store->get_operation(id._id);
             }
-            FC_ASSERT(false, "Unknown Transaction ${t}", ("t", id));
+            return applied_operation(database.get(id));
+        }
+
+        void open_store(const boost::filesystem::path& dir, uint64_t segment_size) {
+            store = std::make_unique<segment_store>();
+            store->open(dir, segment_size);
+
+            database.pre_apply_block.connect([&](const signed_block& block) {
+                store->start_block(block.block_num());
+            });
+
+            database.applied_block.connect([&](const signed_block& block) {
+                store->apply_block(
+                    block.block_num(),
+                    database.get_dynamic_global_properties().last_irreversible_block_num);
+            });
         }
 
         bool filter_content = false;
         uint32_t start_block = 0;
         bool blacklist = false;
         fc::flat_set<std::string> ops_list;
+        std::unique_ptr<segment_store> store; ///< if it isn't set, operations are stored in the shared memory
         graphene::chain::database& database;
     };
 
@@ -173,6 +183,21 @@ namespace graphene { namespace plugins { namespace operation_history {
             "history-start-block",
             boost::program_options::value<uint32_t>()->composing(),
             "Defines starting block from which recording stats."
+        ) (
+            "history-store",
+            boost::program_options::value<std::string>()->default_value("shared-memory"),
+            "Where to store operations: "
+            "shared-memory - in the shared memory file, "
+            "segments - in the memory-mapped segment files out of the shared memory, "
+            "only operations of irreversible blocks are written to files."
+        ) (
+            "history-store-dir",
+            boost::program_options::value<boost::filesystem::path>()->default_value("operation_history"),
+            "The location of segment files of operation history (absolute path or relative to application data dir)."
+        ) (
+            "history-segment-size",
+            boost::program_options::value<uint64_t>()->default_value(256),
+            "Maximum size of one segment file of operation history in MB."
         );
 
         cfg.add(cli);
@@ -225,6 +250,22 @@ namespace graphene { namespace plugins { namespace operation_history {
             pimpl->start_block = 0;
         }
         ilog("operation_history: start_block ${s}", ("s", pimpl->start_block));
+
+        const auto& store_type = options.at("history-store").as<std::string>();
+        if (store_type == "segments") {
+            auto dir = options.at("history-store-dir").as<boost::filesystem::path>();
+            if (dir.is_relative()) {
+                dir = appbase::app().data_dir() / dir;
+            }
+            const auto segment_size = options.at("history-segment-size").as<uint64_t>();
+            FC_ASSERT(segment_size > 0, "history-segment-size should be greater than zero");
+
+            pimpl->open_store(dir, segment_size * 1024 * 1024);
+            ilog("operation_history: operations are stored in ${d}", ("d", dir.string()));
+        } else {
+            FC_ASSERT(store_type == "shared-memory", "Unknown history-store ${s}", ("s", store_type));
+        }
+
         JSON_RPC_REGISTER_API(name());
         ilog("operation_history plugin: plugin_initialize() end");
     }
@@ -244,6 +285,13 @@ namespace graphene { namespace plugins { namespace operation_history {
     }
 
     void plugin::plugin_shutdown() {
+        if (pimpl->store) {
+            pimpl->store->close();
+        }
+    }
+
+    applied_operation plugin::get_operation(operation_id_type id) const {
+        return pimpl->get_operation(id);
     }
 
 } } } // graphene::plugins::operation_history
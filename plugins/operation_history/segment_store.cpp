@@ -0,0 +1,615 @@
+#include <graphene/plugins/operation_history/segment_store.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <limits>
+
+namespace graphene { namespace plugins { namespace operation_history {
+
+    namespace {
+        using mapped_file = boost::iostreams::mapped_file;
+        using graphene::protocol::transaction_id_type;
+
+        constexpr uint64_t store_magic = 0x32305453485a4956; // "VIZHST02"
+
+        // Each file starts with the magic and the size of data after the header,
+        // for transactions.hash it's the number of indexed transactions instead
+        constexpr std::size_t header_size = 2 * sizeof(uint64_t);
+
+        // Files are grown by chunks, so the mapping isn't recreated on each append,
+        // the rest of the last chunk is cut off on closing
+        constexpr uint64_t growth_chunk = 16 * 1024 * 1024;
+
+        constexpr uint64_t initial_transaction_buckets = 1 << 16;
+
+        constexpr uint32_t segment_shift = 40;
+        constexpr uint64_t offset_mask = (uint64_t(1) << segment_shift) - 1;
+
+        struct transaction_record final {
+            transaction_id_type id;
+            uint32_t block;
+            uint32_t trx_in_block;
+        };
+
+        static_assert(sizeof(transaction_record) == 28, "Unexpected layout of transaction record");
+
+        uint64_t transaction_key(const transaction_id_type &id) {
+            uint64_t key;
+            std::memcpy(&key, id.data(), sizeof(key));
+            return key;
+        }
+
+        uint64_t get_uint64(const mapped_file &file, std::size_t pos) {
+            uint64_t value;
+            FC_ASSERT(file.size() >= pos + sizeof(value));
+            std::memcpy(&value, file.const_data() + pos, sizeof(value));
+            return value;
+        }
+
+        void set_uint64(mapped_file &file, std::size_t pos, uint64_t value) {
+            std::memcpy(file.data() + pos, &value, sizeof(value));
+        }
+
+        void open_mapped_file(mapped_file &file, const boost::filesystem::path &path, uint64_t initial_size) {
+            if (!boost::filesystem::is_regular_file(path) || boost::filesystem::file_size(path) < header_size) {
+                const uint64_t header[] = {store_magic, 0};
+                std::ofstream stream(path.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+                stream.write(reinterpret_cast<const char *>(header), sizeof(header));
+                stream.close();
+                boost::filesystem::resize_file(path, std::max<uint64_t>(initial_size, header_size));
+            }
+
+            file.open(path.string(), mapped_file::readwrite);
+            FC_ASSERT(get_uint64(file, 0) == store_magic, "Unknown format of history file ${f}", ("f", path.string()));
+        }
+
+        // Append-only file, its size is kept in the header
+        struct append_file final {
+            boost::filesystem::path path;
+            mapped_file file;
+            uint64_t size = 0;
+
+            void open(const boost::filesystem::path &file_path) {
+                path = file_path;
+                open_mapped_file(file, path, header_size);
+                size = header_size + get_uint64(file, sizeof(store_magic));
+                FC_ASSERT(size <= file.size(), "History file ${f} is damaged", ("f", path.string()));
+            }
+
+            void close() {
+                if (file.is_open()) {
+                    file.close();
+                    boost::filesystem::resize_file(path, size);
+                }
+            }
+
+            const char *data() const {
+                return file.const_data();
+            }
+
+            void resize(uint64_t new_size) {
+                if (new_size > file.size()) {
+                    file.resize(std::max(new_size, file.size() + growth_chunk));
+                }
+                size = new_size;
+                set_uint64(file, sizeof(store_magic), size - header_size);
+            }
+
+            void append(const void *data, std::size_t data_size) {
+                if (data_size == 0) {
+                    return;
+                }
+                const auto pos = size;
+                if (pos + data_size > file.size()) {
+                    file.resize(std::max(pos + data_size, file.size() + growth_chunk));
+                }
+                std::memcpy(file.data() + pos, data, data_size);
+                size = pos + data_size;
+                set_uint64(file, sizeof(store_magic), size - header_size);
+            }
+
+            std::size_t count_records(std::size_t record_size) const {
+                return (size - header_size) / record_size;
+            }
+
+            void resize_records(std::size_t record_size, std::size_t count) {
+                resize(header_size + record_size * count);
+            }
+        };
+    }
+
+    struct segment_store::impl final {
+        struct block_operations final {
+            uint32_t block_num = 0;
+            int64_t first_id = 0;
+            std::vector<applied_operation> ops;
+
+            const applied_operation *find(int64_t id) const {
+                if (id >= first_id && id < first_id + int64_t(ops.size())) {
+                    return &ops[id - first_id];
+                }
+                return nullptr;
+            }
+        };
+
+        boost::filesystem::path dir;
+        uint64_t segment_size = 0;
+
+        append_file blocks_file;
+        append_file ops_file;
+        append_file transactions_file;
+        std::vector<std::unique_ptr<append_file>> segments;
+
+        // Open addressing hash table by prefix of transaction id with linear probing,
+        // a bucket contains number of record in transactions.index plus one, or zero if it's free
+        mapped_file transactions_hash_file;
+
+        std::deque<block_operations> reversible;
+        block_operations current;
+        bool applying = false;
+
+        // Operations of pending transactions, they are discarded on start of the next block
+        block_operations pending;
+
+        uint32_t stored_blocks() const {
+            return blocks_file.count_records(sizeof(uint64_t));
+        }
+
+        int64_t stored_ops() const {
+            return ops_file.count_records(sizeof(uint64_t));
+        }
+
+        uint32_t stored_transactions() const {
+            return transactions_file.count_records(sizeof(transaction_record));
+        }
+
+        uint64_t read_record(const append_file &file, std::size_t n) const {
+            uint64_t value;
+            FC_ASSERT(file.size >= header_size + sizeof(value) * (n + 1));
+            std::memcpy(&value, file.data() + header_size + sizeof(value) * n, sizeof(value));
+            return value;
+        }
+
+        // Id of the next operation after the block
+        int64_t block_end(uint32_t block_num) const {
+            if (block_num == 0) {
+                return 0;
+            }
+            return read_record(blocks_file, block_num - 1);
+        }
+
+        uint64_t op_position(int64_t id) const {
+            return read_record(ops_file, id);
+        }
+
+        const transaction_record &transaction_at(uint32_t n) const {
+            return reinterpret_cast<const transaction_record *>(transactions_file.data() + header_size)[n];
+        }
+
+        uint64_t transaction_buckets() const {
+            return (transactions_hash_file.size() - header_size) / sizeof(uint32_t);
+        }
+
+        uint32_t *transaction_bucket_data() {
+            return reinterpret_cast<uint32_t *>(transactions_hash_file.data() + header_size);
+        }
+
+        const uint32_t *transaction_bucket_data() const {
+            return reinterpret_cast<const uint32_t *>(transactions_hash_file.const_data() + header_size);
+        }
+
+        uint32_t indexed_transactions() const {
+            return get_uint64(transactions_hash_file, sizeof(store_magic));
+        }
+
+        void set_indexed_transactions(uint32_t count) {
+            set_uint64(transactions_hash_file, sizeof(store_magic), count);
+        }
+
+        void index_transaction(uint32_t n) {
+            const auto mask = transaction_buckets() - 1;
+            auto *buckets = transaction_bucket_data();
+            auto i = transaction_key(transaction_at(n).id) & mask;
+            while (buckets[i] != 0) {
+                i = (i + 1) & mask;
+            }
+            buckets[i] = n + 1;
+        }
+
+        // The record should still be in transactions.index
+        void unindex_transaction(uint32_t n) {
+            const auto mask = transaction_buckets() - 1;
+            auto *buckets = transaction_bucket_data();
+            auto i = transaction_key(transaction_at(n).id) & mask;
+            while (buckets[i] != n + 1) {
+                FC_ASSERT(buckets[i] != 0, "Transaction ${n} isn't indexed", ("n", n));
+                i = (i + 1) & mask;
+            }
+
+            // Shifts back the following records of the cluster, so the probing doesn't stop on the freed bucket
+            buckets[i] = 0;
+            for (auto j = (i + 1) & mask; buckets[j] != 0; j = (j + 1) & mask) {
+                const auto home = transaction_key(transaction_at(buckets[j] - 1).id) & mask;
+                const bool in_place = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+                if (!in_place) {
+                    buckets[i] = buckets[j];
+                    buckets[j] = 0;
+                    i = j;
+                }
+            }
+        }
+
+        // The load factor of hash table is kept not greater than 1/2
+        void rebuild_transactions() {
+            const auto count = stored_transactions();
+            auto buckets = transaction_buckets();
+            while (uint64_t(count) * 2 > buckets) {
+                buckets *= 2;
+            }
+
+            set_indexed_transactions(0);
+            if (transaction_buckets() != buckets) {
+                transactions_hash_file.resize(header_size + buckets * sizeof(uint32_t));
+            }
+            std::memset(transaction_bucket_data(), 0, buckets * sizeof(uint32_t));
+
+            for (uint32_t n = 0; n < count; ++n) {
+                index_transaction(n);
+            }
+            set_indexed_transactions(count);
+        }
+
+        void index_new_transactions() {
+            const auto count = stored_transactions();
+            if (uint64_t(count) * 2 > transaction_buckets()) {
+                rebuild_transactions();
+                return;
+            }
+
+            for (auto n = indexed_transactions(); n < count; ++n) {
+                index_transaction(n);
+            }
+            set_indexed_transactions(count);
+        }
+
+        boost::filesystem::path segment_path(std::size_t n) const {
+            char name[32];
+            std::snprintf(name, sizeof(name), "ops.%06u", unsigned(n));
+            return dir / name;
+        }
+
+        void open_segment(std::size_t n) {
+            auto segment = std::make_unique<append_file>();
+            segment->open(segment_path(n));
+            segments.push_back(std::move(segment));
+        }
+
+        const char *op_record(int64_t id, uint32_t &size) const {
+            const auto pos = op_position(id);
+            const auto n = pos >> segment_shift;
+            const auto offset = pos & offset_mask;
+
+            FC_ASSERT(n < segments.size(), "Operation ${id} refers to unknown segment ${n}", ("id", id)("n", n));
+            const auto &segment = *segments[n];
+
+            FC_ASSERT(offset + sizeof(size) <= segment.size, "Operation ${id} is out of segment", ("id", id));
+            std::memcpy(&size, segment.data() + offset, sizeof(size));
+            FC_ASSERT(offset + sizeof(size) + size <= segment.size, "Operation ${id} is out of segment", ("id", id));
+
+            return segment.data() + offset + sizeof(size);
+        }
+
+        applied_operation read_operation(int64_t id) const {
+            uint32_t size = 0;
+            const auto *data = op_record(id, size);
+
+            applied_operation result;
+            fc::datastream<const char *> ds(data, size);
+            fc::raw::unpack(ds, result);
+            return result;
+        }
+
+        int64_t next_id(uint32_t block_num) const {
+            for (auto itr = reversible.rbegin(); itr != reversible.rend(); ++itr) {
+                if (itr->block_num < block_num) {
+                    return itr->first_id + itr->ops.size();
+                }
+            }
+            return stored_ops();
+        }
+
+        // Removes all blocks after last_block, and data which isn't referenced from blocks.index
+        void truncate(uint32_t last_block) {
+            last_block = std::min(last_block, stored_blocks());
+
+            const auto ops_end = block_end(last_block);
+            FC_ASSERT(ops_end <= stored_ops(), "Index of operations is damaged, remove ${d}", ("d", dir.string()));
+
+            std::size_t segment = 0;
+            uint64_t segment_end = header_size;
+            if (ops_end > 0) {
+                uint32_t size = 0;
+                const auto pos = op_position(ops_end - 1);
+                op_record(ops_end - 1, size);
+                segment = pos >> segment_shift;
+                segment_end = (pos & offset_mask) + sizeof(size) + size;
+            }
+
+            while (segments.size() > segment + 1) {
+                segments.back()->close();
+                boost::filesystem::remove(segment_path(segments.size() - 1));
+                segments.pop_back();
+            }
+            if (segments.back()->size != segment_end) {
+                segments.back()->resize(segment_end);
+            }
+
+            ops_file.resize_records(sizeof(uint64_t), ops_end);
+            blocks_file.resize_records(sizeof(uint64_t), last_block);
+
+            auto trx_count = stored_transactions();
+            while (trx_count > 0 && transaction_at(trx_count - 1).block > last_block) {
+                --trx_count;
+            }
+            for (auto n = indexed_transactions(); n > trx_count; --n) {
+                unindex_transaction(n - 1);
+                set_indexed_transactions(n - 1);
+            }
+            transactions_file.resize_records(sizeof(transaction_record), trx_count);
+
+            reversible.clear();
+            pending.ops.clear();
+        }
+
+        void write_block(const block_operations &block) {
+            const auto blocks = stored_blocks();
+            FC_ASSERT(block.block_num > blocks, "Block ${b} is already stored", ("b", block.block_num));
+            FC_ASSERT(
+                block.first_id == stored_ops(),
+                "Operations of block ${b} have unexpected ids", ("b", block.block_num)("id", block.first_id));
+
+            std::vector<uint64_t> positions;
+            std::vector<transaction_record> trxs;
+            std::vector<char> buffer;
+            positions.reserve(block.ops.size());
+
+            auto segment = segments.size() - 1;
+            uint64_t segment_pos = segments.back()->size;
+
+            auto flush_buffer = [&]() {
+                segments[segment]->append(buffer.data(), buffer.size());
+                buffer.clear();
+            };
+
+            for (const auto &op: block.ops) {
+                const auto data = fc::raw::pack(op);
+                const uint32_t size = data.size();
+                const uint64_t record_size = sizeof(size) + size;
+
+                if (segment_pos > header_size && segment_pos + record_size > segment_size) {
+                    flush_buffer();
+                    open_segment(segments.size());
+                    segment = segments.size() - 1;
+                    segment_pos = header_size;
+                }
+
+                positions.push_back((uint64_t(segment) << segment_shift) | segment_pos);
+                buffer.insert(buffer.end(), reinterpret_cast<const char *>(&size), reinterpret_cast<const char *>(&size) + sizeof(size));
+                buffer.insert(buffer.end(), data.begin(), data.end());
+                segment_pos += record_size;
+
+                if (op.virtual_op == 0 && op.op_in_trx == 0) {
+                    trxs.push_back({op.trx_id, op.block, op.trx_in_block});
+                }
+            }
+            flush_buffer();
+
+            ops_file.append(positions.data(), positions.size() * sizeof(uint64_t));
+
+            transactions_file.append(trxs.data(), trxs.size() * sizeof(transaction_record));
+            index_new_transactions();
+
+            // Blocks without operations in the store, e.g. if history was enabled on the existing node
+            std::vector<uint64_t> ends(block.block_num - blocks, uint64_t(block.first_id));
+            ends.back() = block.first_id + block.ops.size();
+            blocks_file.append(ends.data(), ends.size() * sizeof(uint64_t));
+        }
+    };
+
+    segment_store::segment_store()
+        : my(std::make_unique<impl>()) {
+    }
+
+    segment_store::~segment_store() {
+        close();
+    }
+
+    void segment_store::open(const boost::filesystem::path &dir, uint64_t segment_size) { try {
+        close();
+
+        my->dir = dir;
+        my->segment_size = segment_size;
+
+        boost::filesystem::create_directories(dir);
+        my->blocks_file.open(dir / "blocks.index");
+        my->ops_file.open(dir / "ops.index");
+        my->transactions_file.open(dir / "transactions.index");
+        open_mapped_file(my->transactions_hash_file, dir / "transactions.hash",
+            header_size + initial_transaction_buckets * sizeof(uint32_t));
+
+        const auto buckets = my->transaction_buckets();
+        FC_ASSERT(buckets > 0 && (buckets & (buckets - 1)) == 0,
+            "History file ${f} is damaged", ("f", (dir / "transactions.hash").string()));
+
+        for (std::size_t n = 0; n == 0 || boost::filesystem::exists(my->segment_path(n)); ++n) {
+            my->open_segment(n);
+        }
+
+        // Drop data of the interrupted writing
+        if (my->indexed_transactions() > my->stored_transactions()) {
+            my->rebuild_transactions();
+        }
+        my->truncate(my->stored_blocks());
+        if (my->indexed_transactions() != my->stored_transactions()) {
+            wlog("operation_history: rebuilding index of transactions");
+            my->rebuild_transactions();
+        }
+
+        ilog("operation_history: opened ${d} with ${b} blocks, ${o} operations and ${t} transactions",
+            ("d", dir.string())("b", my->stored_blocks())("o", my->stored_ops())("t", my->stored_transactions()));
+    } FC_LOG_AND_RETHROW() }
+
+    void segment_store::close() {
+        for (auto &segment: my->segments) {
+            segment->close();
+        }
+        my->segments.clear();
+        my->blocks_file.close();
+        my->ops_file.close();
+        my->transactions_file.close();
+        my->transactions_hash_file.close();
+        my->reversible.clear();
+        my->pending.ops.clear();
+        my->applying = false;
+    }
+
+    void segment_store::start_block(uint32_t block_num) {
+        if (block_num <= my->stored_blocks()) {
+            // Replaying of the blockchain
+            wlog("operation_history: block ${b} is already stored, truncate history", ("b", block_num));
+            my->truncate(block_num - 1);
+        }
+
+        my->current.block_num = block_num;
+        my->current.first_id = my->next_id(block_num);
+        my->current.ops.clear();
+        my->applying = true;
+
+        my->pending.ops.clear();
+    }
+
+    int64_t segment_store::add_operation(
+        const graphene::chain::operation_notification &note, const fc::time_point_sec &timestamp
+    ) {
+        applied_operation op;
+        op.trx_id = note.trx_id;
+        op.block = note.block;
+        op.trx_in_block = note.trx_in_block;
+        op.op_in_trx = note.op_in_trx;
+        op.virtual_op = note.virtual_op;
+        op.timestamp = timestamp;
+        op.op = note.op;
+
+        auto &target = (my->applying && note.block == my->current.block_num) ? my->current : my->pending;
+        if (&target == &my->pending && my->pending.ops.empty()) {
+            my->pending.block_num = note.block;
+            my->pending.first_id = my->next_id(std::numeric_limits<uint32_t>::max());
+        }
+
+        target.ops.push_back(std::move(op));
+        return target.first_id + target.ops.size() - 1;
+    }
+
+    void segment_store::apply_block(uint32_t block_num, uint32_t last_irreversible_block_num) {
+        auto &reversible = my->reversible;
+
+        if (!my->applying || my->current.block_num != block_num) {
+            my->current.block_num = block_num;
+            my->current.first_id = my->next_id(block_num);
+            my->current.ops.clear();
+        }
+        my->applying = false;
+
+        while (!reversible.empty() && reversible.back().block_num >= block_num) {
+            reversible.pop_back();
+        }
+        reversible.push_back(std::move(my->current));
+        my->current = impl::block_operations();
+
+        while (!reversible.empty() && reversible.front().block_num <= last_irreversible_block_num) {
+            my->write_block(reversible.front());
+            reversible.pop_front();
+        }
+    }
+
+    std::vector<applied_operation> segment_store::get_ops_in_block(uint32_t block_num, bool only_virtual) const {
+        std::vector<applied_operation> result;
+
+        for (const auto &block: my->reversible) {
+            if (block.block_num == block_num) {
+                for (const auto &op: block.ops) {
+                    if (!only_virtual || op.virtual_op != 0) {
+                        result.push_back(op);
+                    }
+                }
+                return result;
+            }
+        }
+
+        if (block_num > 0 && block_num <= my->stored_blocks()) {
+            const auto end = my->block_end(block_num);
+            for (auto id = my->block_end(block_num - 1); id < end; ++id) {
+                auto op = my->read_operation(id);
+                if (!only_virtual || op.virtual_op != 0) {
+                    result.push_back(std::move(op));
+                }
+            }
+        }
+        return result;
+    }
+
+    fc::optional<transaction_location> segment_store::find_transaction(const transaction_id_type &id) const {
+        const auto mask = my->transaction_buckets() - 1;
+        const auto *buckets = my->transaction_bucket_data();
+        for (auto i = transaction_key(id) & mask; buckets[i] != 0; i = (i + 1) & mask) {
+            const auto &record = my->transaction_at(buckets[i] - 1);
+            if (record.id == id) {
+                return transaction_location{record.block, record.trx_in_block};
+            }
+        }
+
+        for (const auto &block: my->reversible) {
+            for (const auto &op: block.ops) {
+                if (op.trx_id == id) {
+                    return transaction_location{op.block, op.trx_in_block};
+                }
+            }
+        }
+        return {};
+    }
+
+    applied_operation segment_store::get_operation(int64_t id) const {
+        FC_ASSERT(id >= 0, "Unknown operation ${id}", ("id", id));
+
+        if (id < my->stored_ops()) {
+            return my->read_operation(id);
+        }
+
+        for (const auto &block: my->reversible) {
+            if (auto op = block.find(id)) {
+                return *op;
+            }
+        }
+
+        if (my->applying) {
+            if (auto op = my->current.find(id)) {
+                return *op;
+            }
+        }
+
+        if (auto op = my->pending.find(id)) {
+            return *op;
+        }
+
+        FC_ASSERT(false, "Unknown operation ${id}", ("id", id));
+    }
+
+} } } // graphene::plugins::operation_history
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <graphene/plugins/chain/plugin.hpp>
+#include <graphene/plugins/json_rpc/utility.hpp>
+#include <graphene/plugins/json_rpc/plugin.hpp>
 
 #include <appbase/application.hpp>
 
@@ -15,9 +17,14 @@ namespace graphene {
                 class p2p_plugin_impl;
             }
 
+            using json_rpc::msg_pack;
+
+            ///               API,                         args,     return
+            DEFINE_API_ARGS(get_block_propagation_stats, msg_pack, fc::variant_object)
+
             class p2p_plugin final : public appbase::plugin<p2p_plugin> {
             public:
-                APPBASE_PLUGIN_REQUIRES((chain::plugin))
+                APPBASE_PLUGIN_REQUIRES((json_rpc::plugin) (chain::plugin))
 
                 p2p_plugin();
 
@@ -43,6 +50,14 @@ namespace graphene {
 
                 void set_block_production(bool producing_blocks);
 
+                DECLARE_API(
+                        /**
+                         * Delays of stages of recent blocks inside the node and counters of peers,
+                         * which show who delivers blocks first
+                         */
+                        (get_block_propagation_stats)
+                )
+
             private:
                 std::unique_ptr<detail::p2p_plugin_impl> my;
             };
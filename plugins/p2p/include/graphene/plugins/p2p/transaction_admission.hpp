@@ -0,0 +1,84 @@
+#pragma once
+
+#include <graphene/plugins/chain/plugin.hpp>
+
+#include <fc/bloom_filter.hpp>
+#include <fc/thread/future.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <deque>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+namespace graphene {
+    namespace plugins {
+        namespace p2p {
+
+            /**
+             * Admission of transactions received from the p2p network, it lives in the p2p thread.
+             *
+             * 1. Duplicates are rejected by ids of recent transactions: a pair of rotated bloom filters,
+             *    a hit is confirmed by the database, so a false positive costs only a lookup.
+             * 2. Operations are validated, keys of signatures are recovered, the authority, TaPoS and expiration
+             *    are checked under the read lock in p2p IO threads, the fiber of connection yields in the meantime.
+             * 3. Prevalidated transactions are pushed to the pending state in batches in the order of arrival,
+             *    one acquisition of the write lock per batch, so spam bursts don't starve applying of blocks.
+             *    The authority is checked again by the recovered keys, a previous transaction can change it.
+             *    Batches are pushed in a dedicated thread, waiting for the lock doesn't hold p2p IO threads.
+             */
+            class transaction_admission final {
+            public:
+                explicit transaction_admission(chain::plugin &chain);
+
+                ~transaction_admission();
+
+                /// Waits until the transaction is pushed to the pending state, throws if it's rejected
+                void admit(const protocol::signed_transaction &trx);
+
+                /// Rejects transactions in the queue and stops the apply loop, should be called in the p2p thread
+                void stop();
+
+                void set_max_batch_size(uint32_t max_batch_size) {
+                    _max_batch_size = max_batch_size;
+                }
+
+            private:
+                struct pending_transaction {
+                    protocol::signed_transaction trx;
+                    protocol::transaction_id_type id;
+                    fc::flat_set<protocol::public_key_type> signature_keys;
+                    bool prevalidated = false;
+                    bool rejected = false;
+                    fc::promise<void>::ptr result;
+                };
+                using pending_transaction_ptr = std::shared_ptr<pending_transaction>;
+
+                bool is_recent_transaction(const protocol::transaction_id_type &id) const;
+
+                void remember_transaction(const protocol::transaction_id_type &id);
+
+                void apply_loop();
+
+                void trigger_apply_loop();
+
+                chain::plugin &_chain;
+                uint32_t _max_batch_size;
+
+                fc::bloom_parameters _filter_parameters;
+                fc::bloom_filter _recent_transactions;
+                fc::bloom_filter _previous_recent_transactions;
+                uint32_t _recent_transactions_count = 0;
+
+                std::deque<pending_transaction_ptr> _queue;
+                std::unordered_set<protocol::transaction_id_type> _queued_ids;
+
+                fc::thread _apply_thread;
+                fc::future<void> _apply_loop_done;
+                fc::promise<void>::ptr _retrigger_apply_loop_promise;
+                bool _stopped = false;
+            };
+
+        }
+    }
+} // graphene::plugins::p2p
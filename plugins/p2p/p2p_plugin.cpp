@@ -1,7 +1,9 @@
 #include <graphene/plugins/p2p/p2p_plugin.hpp>
+#include <graphene/plugins/p2p/transaction_admission.hpp>
 
 #include <graphene/network/node.hpp>
 #include <graphene/network/exceptions.hpp>
+#include <graphene/network/io_thread_pool.hpp>
 
 #include <graphene/chain/database_exceptions.hpp>
 
@@ -37,7 +39,7 @@ namespace graphene {
                 class p2p_plugin_impl : public graphene::network::node_delegate {
                 public:
 
-                    p2p_plugin_impl(chain::plugin &c) : chain(c) {
+                    p2p_plugin_impl(chain::plugin &c) : chain(c), admission(c) {
                     }
 
                     virtual ~p2p_plugin_impl() {
@@ -88,6 +90,8 @@ namespace graphene {
                     vector<fc::ip::endpoint> seeds;
                     string user_agent;
                     uint32_t max_connections = 0;
+                    uint32_t io_threads = 2;
+                    bool compression = true;
                     bool force_validate = false;
                     bool block_producer = false;
 
@@ -95,6 +99,8 @@ namespace graphene {
 
                     chain::plugin &chain;
 
+                    transaction_admission admission;
+
                     fc::thread p2p_thread;
                 };
 
@@ -133,9 +139,14 @@ namespace graphene {
                             // you can help the network code out by throwing a block_older_than_undo_history exception.
                             // when the network code sees that, it will stop trying to push blocks from that chain, but
                             // leave that peer connected so that they can get sync blocks from us
-                            bool result = chain.accept_block(blk_msg.block, sync_mode, (block_producer | force_validate)
-                                                                                       ? database::skip_nothing
-                                                                                       : database::skip_transaction_signatures);
+                            uint32_t skip = (block_producer | force_validate)
+                                            ? database::skip_nothing
+                                            : database::skip_transaction_signatures;
+                            // the merkle root is checked by the node in an IO thread
+                            if (blk_msg.merkle_root_checked) {
+                                skip |= database::skip_merkle_check;
+                            }
+                            bool result = chain.accept_block(blk_msg.block, sync_mode, skip, blk_msg.signee);
 
                             if (!sync_mode) {
                                 fc::microseconds latency = fc::time_point::now() - blk_msg.block.timestamp;
@@ -161,7 +172,7 @@ namespace graphene {
 
                 void p2p_plugin_impl::handle_transaction(const trx_message &trx_msg) {
                     try {
-                        chain.accept_transaction(trx_msg.trx);
+                        admission.admit(trx_msg.trx);
                     } FC_CAPTURE_AND_RETHROW((trx_msg))
                 }
 
@@ -443,7 +454,13 @@ namespace graphene {
                     ("seed-node", boost::program_options::value<vector<string>>()->composing(),
                         "The IP address and port of a remote peer to sync with. Deprecated in favor of p2p-seed-node.")
                     ("p2p-seed-node", boost::program_options::value<vector<string>>()->composing(),
-                        "The IP address and port of a remote peer to sync with.");
+                        "The IP address and port of a remote peer to sync with.")
+                    ("p2p-io-threads", boost::program_options::value<uint32_t>()->default_value(2),
+                        "Number of threads to decrypt and hash large P2P messages, 0 to process them in the P2P thread.")
+                    ("p2p-compression", boost::program_options::value<bool>()->default_value(true),
+                        "Compress large blocks for peers, which support it. Saves bandwidth of seed nodes during sync.")
+                    ("p2p-transaction-batch-size", boost::program_options::value<uint32_t>()->default_value(100),
+                        "Maximum number of transactions from peers, which are pushed under one write lock.");
                 cli.add_options()
                     ("force-validate", boost::program_options::bool_switch()->default_value(false),
                         "Force validation of all transactions. Deprecated in favor of p2p-force-validate")
@@ -453,6 +470,7 @@ namespace graphene {
 
             void p2p_plugin::plugin_initialize(const boost::program_options::variables_map &options) {
                 my.reset(new detail::p2p_plugin_impl(appbase::app().get_plugin<chain::plugin>()));
+                JSON_RPC_REGISTER_API(P2P_PLUGIN_NAME);
 
                 if (options.count("p2p-endpoint")) {
                     my->endpoint = fc::ip::endpoint::from_string(options.at("p2p-endpoint").as<string>());
@@ -490,6 +508,12 @@ namespace graphene {
                     }
                 }
 
+                my->io_threads = options.at("p2p-io-threads").as<uint32_t>();
+
+                my->compression = options.at("p2p-compression").as<bool>();
+
+                my->admission.set_max_batch_size(std::max<uint32_t>(options.at("p2p-transaction-batch-size").as<uint32_t>(), 1));
+
                 my->force_validate = options.at("p2p-force-validate").as<bool>();
 
                 if (!my->force_validate && options.at("force-validate").as<bool>()) {
@@ -499,10 +523,13 @@ namespace graphene {
             }
 
             void p2p_plugin::plugin_startup() {
+                graphene::network::io_thread_pool::instance().start(my->io_threads);
                 my->p2p_thread.async([this] {
                     my->node.reset(new graphene::network::node(my->user_agent));
                     my->node->load_configuration(app().data_dir() / "p2p");
                     my->node->set_node_delegate(&(*my));
+                    my->node->set_advanced_node_parameters(
+                        fc::variant_object("compression", fc::variant(my->compression)));
 
                     if (my->endpoint) {
                         ilog("Configuring P2P to listen at ${ep}", ("ep", my->endpoint));
@@ -537,9 +564,13 @@ namespace graphene {
 
             void p2p_plugin::plugin_shutdown() {
                 ilog("Shutting down P2P Plugin");
+                my->p2p_thread.async([this] {
+                    my->admission.stop();
+                }).wait();
                 my->node->close();
                 my->p2p_thread.quit();
                 my->node.reset();
+                graphene::network::io_thread_pool::instance().stop();
             }
 
             void p2p_plugin::broadcast_block(const protocol::signed_block &block) {
@@ -556,6 +587,11 @@ namespace graphene {
                 my->block_producer = producing_blocks;
             }
 
+            DEFINE_API(p2p_plugin, get_block_propagation_stats) {
+                FC_ASSERT(my->node, "P2P node isn't started");
+                return my->node->get_block_propagation_stats();
+            }
+
         }
     }
 } // namespace graphene::plugins::p2p
@@ -0,0 +1,194 @@
+#include <graphene/plugins/p2p/transaction_admission.hpp>
+
+#include <graphene/network/io_thread_pool.hpp>
+
+#include <fc/thread/thread.hpp>
+
+namespace graphene {
+    namespace plugins {
+        namespace p2p {
+
+            using graphene::chain::database;
+
+            // filters are rotated after this number of transactions, a transaction is remembered
+            // during from 1 to 2 periods, it's enough for the transactions relayed in the network
+            static const uint32_t recent_transactions_per_filter = 100000;
+
+            transaction_admission::transaction_admission(chain::plugin &chain)
+                    : _chain(chain),
+                      _max_batch_size(100),
+                      _apply_thread("p2p trx apply") {
+                _filter_parameters.projected_element_count = recent_transactions_per_filter;
+                _filter_parameters.false_positive_probability = 1.0 / 10000;
+                _filter_parameters.compute_optimal_parameters();
+                _recent_transactions = fc::bloom_filter(_filter_parameters);
+                _previous_recent_transactions = fc::bloom_filter(_filter_parameters);
+            }
+
+            transaction_admission::~transaction_admission() {
+            }
+
+            bool transaction_admission::is_recent_transaction(const protocol::transaction_id_type &id) const {
+                return _recent_transactions.contains(id.data(), id.data_size()) ||
+                       _previous_recent_transactions.contains(id.data(), id.data_size());
+            }
+
+            void transaction_admission::remember_transaction(const protocol::transaction_id_type &id) {
+                if (++_recent_transactions_count > recent_transactions_per_filter) {
+                    _previous_recent_transactions = std::move(_recent_transactions);
+                    _recent_transactions = fc::bloom_filter(_filter_parameters);
+                    _recent_transactions_count = 1;
+                }
+                _recent_transactions.insert(id.data(), id.data_size());
+            }
+
+            void transaction_admission::admit(const protocol::signed_transaction &trx) {
+                FC_ASSERT(!_stopped, "P2P plugin is shutting down");
+
+                auto pending = std::make_shared<pending_transaction>();
+                pending->trx = trx;
+                pending->id = trx.id();
+
+                if (is_recent_transaction(pending->id)) {
+                    bool is_known = _queued_ids.count(pending->id) ||
+                        _chain.db().with_weak_read_lock([&]() {
+                            return _chain.db().is_known_transaction(pending->id);
+                        });
+                    FC_ASSERT(!is_known, "Duplicate transaction", ("id", pending->id));
+                } else {
+                    remember_transaction(pending->id);
+                }
+
+                pending->result = fc::promise<void>::ptr(new fc::promise<void>("transaction_admission::result"));
+                _queue.push_back(pending);
+                _queued_ids.insert(pending->id);
+
+                // prevalidation doesn't need the write lock, it's done in parallel for transactions of all peers
+                try {
+                    auto &chain = _chain;
+                    graphene::network::io_thread_pool::instance().run([pending, &chain]() {
+                        pending->trx.validate();
+                        pending->signature_keys = pending->trx.get_signature_keys(CHAIN_ID);
+                        auto &db = chain.db();
+                        db.with_weak_read_lock([&]() {
+                            db.validate_transaction(pending->trx,
+                                database::skip_authority_check |
+                                database::skip_transaction_signatures |
+                                database::skip_validate_operations |
+                                database::skip_apply_transaction |
+                                database::skip_database_locking);
+                            db.verify_authority(pending->trx, pending->signature_keys);
+                        });
+                    });
+                } catch (const fc::canceled_exception &) {
+                    pending->rejected = true;
+                    pending->prevalidated = true;
+                    trigger_apply_loop();
+                    throw;
+                } catch (const fc::exception &e) {
+                    pending->rejected = true;
+                    pending->result->set_exception(e.dynamic_copy_exception());
+                }
+                pending->prevalidated = true;
+
+                if (!_apply_loop_done.valid() || _apply_loop_done.ready()) {
+                    _apply_loop_done = fc::async([this]() { apply_loop(); }, "transaction_admission::apply_loop");
+                } else {
+                    trigger_apply_loop();
+                }
+
+                pending->result->wait();
+            }
+
+            void transaction_admission::apply_loop() {
+                while (!_stopped && !_apply_loop_done.canceled()) {
+                    // transactions are applied in the order of arrival, a transaction can depend on a previous one
+                    std::vector<pending_transaction_ptr> batch;
+                    while (!_queue.empty() && _queue.front()->prevalidated && batch.size() < _max_batch_size) {
+                        auto pending = _queue.front();
+                        _queue.pop_front();
+                        _queued_ids.erase(pending->id);
+                        if (!pending->rejected) {
+                            batch.push_back(std::move(pending));
+                        }
+                    }
+
+                    if (batch.empty()) {
+                        if (_queue.empty()) {
+                            return;
+                        }
+                        // wait for prevalidation of the first transaction
+                        _retrigger_apply_loop_promise = fc::promise<void>::ptr(new fc::promise<void>("transaction_admission::retrigger_apply_loop"));
+                        _retrigger_apply_loop_promise->wait();
+                        _retrigger_apply_loop_promise.reset();
+                        continue;
+                    }
+
+                    // the batch is owned by the closure, it outlives the fiber, if the fiber is canceled
+                    auto trxs = std::make_shared<std::vector<protocol::signed_transaction>>();
+                    auto signature_keys = std::make_shared<std::vector<fc::flat_set<protocol::public_key_type>>>();
+                    auto errors = std::make_shared<std::vector<fc::oexception>>();
+                    trxs->reserve(batch.size());
+                    signature_keys->reserve(batch.size());
+                    for (const auto &pending : batch) {
+                        trxs->push_back(pending->trx);
+                        signature_keys->push_back(pending->signature_keys);
+                    }
+
+                    // the batch waits for the write lock, so it's pushed in own thread to not hold an IO thread
+                    try {
+                        auto &chain = _chain;
+                        _apply_thread.async([trxs, signature_keys, errors, &chain]() {
+                            *errors = chain.accept_transactions(*trxs, *signature_keys);
+                        }, "transaction_admission::accept_transactions").wait();
+                    } catch (const fc::canceled_exception &e) {
+                        for (const auto &pending : batch) {
+                            pending->result->set_exception(e.dynamic_copy_exception());
+                        }
+                        throw;
+                    } catch (const fc::exception &e) {
+                        errors->assign(batch.size(), e);
+                    }
+
+                    dlog("applied a batch of ${n} transactions from the p2p network", ("n", batch.size()));
+                    for (size_t i = 0; i < batch.size(); ++i) {
+                        if (i < errors->size() && (*errors)[i]) {
+                            batch[i]->result->set_exception((*errors)[i]->dynamic_copy_exception());
+                        } else {
+                            batch[i]->result->set_value();
+                        }
+                    }
+                }
+            }
+
+            void transaction_admission::trigger_apply_loop() {
+                if (_retrigger_apply_loop_promise) {
+                    _retrigger_apply_loop_promise->set_value();
+                }
+            }
+
+            void transaction_admission::stop() {
+                _stopped = true;
+                if (_apply_loop_done.valid() && !_apply_loop_done.ready()) {
+                    try {
+                        _apply_loop_done.cancel_and_wait("transaction_admission::stop");
+                    } catch (const fc::exception &e) {
+                        wlog("Exception thrown while stopping transaction admission, ignoring: ${e}", ("e", e));
+                    }
+                }
+
+                fc::exception stopped(FC_LOG_MESSAGE(warn, "P2P plugin is shutting down"));
+                for (const auto &pending : _queue) {
+                    if (!pending->rejected && !pending->result->ready()) {
+                        pending->result->set_exception(stopped.dynamic_copy_exception());
+                    }
+                }
+                _queue.clear();
+                _queued_ids.clear();
+
+                _apply_thread.quit();
+            }
+
+        }
+    }
+} // graphene::plugins::p2p
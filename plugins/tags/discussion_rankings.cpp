@@ -0,0 +1,357 @@
+#include <graphene/plugins/tags/discussion_rankings.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace plugins { namespace tags {
+
+    bool is_ranked_before(ranking_sort sort, const ranked_discussion& first, const ranked_discussion& second) {
+        switch (sort) {
+            case ranking_sort::trending:
+                return sort::by_trending()(first, second);
+            case ranking_sort::hot:
+                return sort::by_hot()(first, second);
+            case ranking_sort::payout:
+                return sort::by_net_rshares()(first, second);
+            case ranking_sort::votes:
+                return sort::by_net_votes()(first, second);
+            case ranking_sort::children:
+                return sort::by_children()(first, second);
+        }
+        return false;
+    }
+
+    static ranked_discussion make_ranked(const tag_object& tag) {
+        ranked_discussion item;
+        item.id = tag.content;
+        item.parent = tag.parent;
+        item.author = tag.author;
+        item.hot = tag.hot();
+        item.trending = tag.trending();
+        item.net_rshares = tag.net_rshares;
+        item.net_votes = tag.net_votes;
+        item.children = tag.children;
+        return item;
+    }
+
+    struct discussion_rankings::operation_visitor final {
+        using result_type = void;
+
+        discussion_rankings& rankings;
+
+        void mark(const account_name_type& author, const std::string& permlink) const {
+            const auto* content = rankings.db_.find_content(author, permlink);
+            if (content) {
+                rankings.mark_changed(*content);
+            }
+        }
+
+        void operator()(const content_operation& op) const {
+            mark(op.author, op.permlink);
+        }
+
+        void operator()(const vote_operation& op) const {
+            mark(op.author, op.permlink);
+        }
+
+        void operator()(const content_reward_operation& op) const {
+            mark(op.author, op.permlink);
+        }
+
+        void operator()(const content_payout_update_operation& op) const {
+            mark(op.author, op.permlink);
+        }
+
+        void operator()(const delete_content_operation& op) const {
+            const auto* author = rankings.db_.find_account(op.author);
+            if (author) {
+                rankings.deleted_authors_.insert(author->id);
+            }
+        }
+
+        template<typename Op>
+        void operator()(Op&&) const {
+        }
+    };
+
+    discussion_rankings::discussion_rankings(database& db)
+        : db_(db) {
+    }
+
+    void discussion_rankings::configure(uint32_t ranking_size, uint32_t max_tags, uint32_t max_discussions) {
+        std::lock_guard<std::mutex> guard(mutex_);
+        ranking_size_ = ranking_size;
+        max_tags_ = std::max(max_tags, uint32_t(1));
+        max_discussions_ = max_discussions;
+        clear();
+    }
+
+    void discussion_rankings::on_operation(const operation& op) {
+        if (!enabled()) {
+            return;
+        }
+        op.visit(operation_visitor{*this});
+    }
+
+    void discussion_rankings::mark_changed(const content_object& content) {
+        changed_.insert(content.id);
+
+        // Tags of parents are updated with their children
+        const auto* parent = &content;
+        while (parent->parent_author.size()) {
+            parent = db_.find_content(parent->parent_author, to_string(parent->parent_permlink));
+            if (!parent) {
+                break;
+            }
+            changed_.insert(parent->id);
+        }
+    }
+
+    void discussion_rankings::on_applied_block(const signed_block& block) {
+        if (!enabled()) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        const auto block_num = block.block_num();
+        if (last_block_num_ != 0 && block_num != last_block_num_ + 1) {
+            // Blocks were popped, state of contents in rankings can be reverted
+            clear();
+        }
+        last_block_num_ = block_num;
+
+        for (const auto& id: changed_) {
+            update(id);
+        }
+        changed_.clear();
+
+        if (!deleted_authors_.empty()) {
+            remove_deleted();
+            deleted_authors_.clear();
+        }
+    }
+
+    void discussion_rankings::clear() {
+        tags_.clear();
+        tags_lru_.clear();
+        memberships_.clear();
+        discussions_.clear();
+        discussions_lru_.clear();
+    }
+
+    discussion_ranking discussion_rankings::get_ranking(const std::string& tag, ranking_sort sort) {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        auto itr = tags_.find(tag);
+        if (itr != tags_.end() && is_depleted(itr->second)) {
+            // Discussions after the end of the incomplete top aren't known, so it's built again
+            tags_lru_.erase(itr->second.lru);
+            tags_.erase(itr);
+            itr = tags_.end();
+        }
+
+        if (itr == tags_.end()) {
+            return build(tag).rankings[static_cast<std::size_t>(sort)];
+        }
+
+        tags_lru_.splice(tags_lru_.begin(), tags_lru_, itr->second.lru);
+        return itr->second.rankings[static_cast<std::size_t>(sort)];
+    }
+
+    bool discussion_rankings::is_depleted(const tag_rankings& tag) const {
+        for (const auto& ranking: tag.rankings) {
+            if (!ranking.complete && ranking.entries.size() < ranking_size_ / 2) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    discussion_rankings::tag_rankings& discussion_rankings::build(const tag_key& tag) {
+        std::vector<ranked_discussion> items;
+
+        const auto& idx = db_.get_index<tag_index>().indices().get<by_tag>();
+        for (auto itr = idx.lower_bound(std::make_tuple(tag, tag_type::tag));
+             itr != idx.end() && itr->name == tag && itr->type == tag_type::tag; ++itr
+        ) {
+            items.push_back(make_ranked(*itr));
+        }
+
+        if (tags_.size() >= max_tags_) {
+            tags_.erase(tags_lru_.back());
+            tags_lru_.pop_back();
+        }
+
+        tags_lru_.push_front(tag);
+        auto& result = tags_[tag];
+        result.lru = tags_lru_.begin();
+
+        const std::size_t size = std::min<std::size_t>(items.size(), ranking_size_);
+        for (std::size_t s = 0; s < ranking_sort_count; ++s) {
+            const auto sort = static_cast<ranking_sort>(s);
+            auto& ranking = result.rankings[s];
+
+            std::partial_sort(items.begin(), items.begin() + size, items.end(),
+                [sort](const ranked_discussion& first, const ranked_discussion& second) {
+                    return is_ranked_before(sort, first, second);
+                });
+
+            ranking.entries.assign(items.begin(), items.begin() + size);
+            ranking.complete = (size == items.size());
+
+            for (const auto& item: ranking.entries) {
+                memberships_[item.id].insert(tag);
+            }
+        }
+
+        return result;
+    }
+
+    void discussion_rankings::insert(
+        discussion_ranking& ranking, ranking_sort sort, const ranked_discussion& item
+    ) const {
+        auto& entries = ranking.entries;
+        auto itr = std::lower_bound(entries.begin(), entries.end(), item,
+            [sort](const ranked_discussion& first, const ranked_discussion& second) {
+                return is_ranked_before(sort, first, second);
+            });
+
+        // The position of discussion after the last entry of the incomplete top isn't known
+        if (itr == entries.end() && !ranking.complete) {
+            return;
+        }
+
+        entries.insert(itr, item);
+        if (entries.size() > ranking_size_) {
+            entries.pop_back();
+            ranking.complete = false;
+        }
+    }
+
+    void discussion_rankings::remove(discussion_ranking& ranking, const content_object::id_type& id) const {
+        auto& entries = ranking.entries;
+        auto itr = std::find_if(entries.begin(), entries.end(), [&](const ranked_discussion& item) {
+            return item.id == id;
+        });
+
+        // The rest of the incomplete top is still the top of tag, only shorter
+        if (itr != entries.end()) {
+            entries.erase(itr);
+        }
+    }
+
+    void discussion_rankings::update(const content_object::id_type& id) {
+        auto ditr = discussions_.find(id);
+        if (ditr != discussions_.end()) {
+            discussions_lru_.erase(ditr->second.lru);
+            discussions_.erase(ditr);
+        }
+
+        auto mitr = memberships_.find(id);
+        if (mitr != memberships_.end()) {
+            for (const auto& tag: mitr->second) {
+                auto titr = tags_.find(tag);
+                if (titr != tags_.end()) {
+                    for (auto& ranking: titr->second.rankings) {
+                        remove(ranking, id);
+                    }
+                }
+            }
+            memberships_.erase(mitr);
+        }
+
+        const auto& idx = db_.get_index<tag_index>().indices().get<by_content>();
+        for (auto itr = idx.lower_bound(id); itr != idx.end() && itr->content == id; ++itr) {
+            if (itr->type != tag_type::tag) {
+                continue;
+            }
+
+            const tag_key tag(itr->name);
+            auto titr = tags_.find(tag);
+            if (titr == tags_.end()) {
+                continue;
+            }
+
+            const auto item = make_ranked(*itr);
+            for (std::size_t s = 0; s < ranking_sort_count; ++s) {
+                insert(titr->second.rankings[s], static_cast<ranking_sort>(s), item);
+            }
+            memberships_[id].insert(tag);
+        }
+    }
+
+    void discussion_rankings::remove_deleted() {
+        for (auto& tag: tags_) {
+            for (auto& ranking: tag.second.rankings) {
+                auto& entries = ranking.entries;
+                entries.erase(
+                    std::remove_if(entries.begin(), entries.end(), [&](const ranked_discussion& item) {
+                        return deleted_authors_.count(item.author) && !db_.find(item.id);
+                    }),
+                    entries.end());
+            }
+        }
+    }
+
+    void discussion_rankings::on_tag_removed(const tag_object& tag) {
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        auto itr = tags_.find(tag_key(tag.name));
+        if (itr != tags_.end()) {
+            for (auto& ranking: itr->second.rankings) {
+                remove(ranking, tag.content);
+            }
+        }
+    }
+
+    std::shared_ptr<const discussion> discussion_rankings::find_discussion(const content_object& content) {
+        if (max_discussions_ == 0) {
+            return nullptr;
+        }
+
+        // The url contains the title of root content
+        const auto& root = db_.get(content.root_content);
+
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        auto itr = discussions_.find(content.id);
+        if (itr == discussions_.end()) {
+            return nullptr;
+        }
+
+        if (itr->second.root_last_update != root.last_update) {
+            discussions_lru_.erase(itr->second.lru);
+            discussions_.erase(itr);
+            return nullptr;
+        }
+
+        discussions_lru_.splice(discussions_lru_.begin(), discussions_lru_, itr->second.lru);
+        return itr->second.value;
+    }
+
+    void discussion_rankings::store_discussion(const content_object& content, std::shared_ptr<const discussion> d) {
+        if (max_discussions_ == 0) {
+            return;
+        }
+
+        const auto& root = db_.get(content.root_content);
+
+        std::lock_guard<std::mutex> guard(mutex_);
+
+        auto itr = discussions_.find(content.id);
+        if (itr != discussions_.end()) {
+            discussions_lru_.erase(itr->second.lru);
+            discussions_.erase(itr);
+        } else if (discussions_.size() >= max_discussions_) {
+            discussions_.erase(discussions_lru_.back());
+            discussions_lru_.pop_back();
+        }
+
+        discussions_lru_.push_front(content.id);
+        auto& cached = discussions_[content.id];
+        cached.value = std::move(d);
+        cached.root_last_update = root.last_update;
+        cached.lru = discussions_lru_.begin();
+    }
+
+} } } // graphene::plugins::tags
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <graphene/plugins/tags/tags_object.hpp>
+
+#include <array>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace graphene { namespace plugins { namespace tags {
+
+    /**
+     * Sort orders of discussions, which have materialized rankings per tag
+     */
+    enum class ranking_sort: uint8_t {
+        trending,
+        hot,
+        payout,
+        votes,
+        children
+    };
+
+    constexpr std::size_t ranking_sort_count = 5;
+
+    template<typename DiscussionOrder>
+    struct ranking_sort_of {
+        static constexpr bool materialized = false;
+        static constexpr ranking_sort value = ranking_sort::trending;
+    };
+
+    template<>
+    struct ranking_sort_of<sort::by_trending> {
+        static constexpr bool materialized = true;
+        static constexpr ranking_sort value = ranking_sort::trending;
+    };
+
+    template<>
+    struct ranking_sort_of<sort::by_hot> {
+        static constexpr bool materialized = true;
+        static constexpr ranking_sort value = ranking_sort::hot;
+    };
+
+    template<>
+    struct ranking_sort_of<sort::by_net_rshares> {
+        static constexpr bool materialized = true;
+        static constexpr ranking_sort value = ranking_sort::payout;
+    };
+
+    template<>
+    struct ranking_sort_of<sort::by_net_votes> {
+        static constexpr bool materialized = true;
+        static constexpr ranking_sort value = ranking_sort::votes;
+    };
+
+    template<>
+    struct ranking_sort_of<sort::by_children> {
+        static constexpr bool materialized = true;
+        static constexpr ranking_sort value = ranking_sort::children;
+    };
+
+    /**
+     * Sort keys of a discussion in a tag, they are copied from tag_object
+     */
+    struct ranked_discussion final {
+        content_object::id_type id;
+        content_object::id_type parent;
+        account_object::id_type author;
+        double hot = 0;
+        double trending = 0;
+        share_type net_rshares;
+        int32_t net_votes = 0;
+        int32_t children = 0;
+    };
+
+    /**
+     * Returns true if the first discussion is before the second one in the sort order,
+     * the order is the same as the order of sort::by_* for discussions
+     */
+    bool is_ranked_before(ranking_sort sort, const ranked_discussion& first, const ranked_discussion& second);
+
+    /**
+     * The top of discussions of a tag in a sort order
+     */
+    struct discussion_ranking final {
+        std::vector<ranked_discussion> entries;
+
+        /// entries contain all discussions of the tag, otherwise only the top of them
+        bool complete = false;
+    };
+
+    /**
+     * Materialized top-N rankings of discussions per tag and per sort order, and the cache of rendered discussions.
+     *
+     * Rankings of a tag are built from tag_index on the first request and then they are updated incrementally
+     * on each applied block for contents changed by operations of the block. Rendered discussions are cached
+     * until the content is changed. On switching of forks everything is dropped and built again on requests.
+     *
+     * Contents are marked and blocks are applied in the thread, which writes to database; rankings and discussions
+     * are read by API threads under the read lock of database.
+     */
+    class discussion_rankings final {
+    public:
+        discussion_rankings(database& db);
+
+        void configure(uint32_t ranking_size, uint32_t max_tags, uint32_t max_discussions);
+
+        bool enabled() const {
+            return ranking_size_ != 0;
+        }
+
+        uint32_t ranking_size() const {
+            return ranking_size_;
+        }
+
+        /// Marks contents changed by the operation, rankings are updated for them after applying of the block
+        void on_operation(const operation& op);
+
+        /// Updates rankings for contents changed in the block
+        void on_applied_block(const signed_block& block);
+
+        /// Removes the content from rankings of the tag, which is removed outside of blocks
+        void on_tag_removed(const tag_object& tag);
+
+        /// Returns a copy of the ranking of the tag, it's built if it's not materialized yet
+        discussion_ranking get_ranking(const std::string& tag, ranking_sort sort);
+
+        /// Returns the cached discussion, which has the url set, or nullptr if it's changed or not cached
+        std::shared_ptr<const discussion> find_discussion(const content_object& content);
+
+        void store_discussion(const content_object& content, std::shared_ptr<const discussion> d);
+
+    private:
+        using tag_key = std::string;
+
+        struct tag_rankings final {
+            std::array<discussion_ranking, ranking_sort_count> rankings;
+            std::list<tag_key>::iterator lru;
+        };
+
+        struct cached_discussion final {
+            std::shared_ptr<const discussion> value;
+            time_point_sec root_last_update;
+            std::list<content_object::id_type>::iterator lru;
+        };
+
+        struct operation_visitor;
+
+        void mark_changed(const content_object& content);
+
+        bool is_depleted(const tag_rankings& tag) const;
+
+        tag_rankings& build(const tag_key& tag);
+
+        void insert(discussion_ranking& ranking, ranking_sort sort, const ranked_discussion& item) const;
+
+        void remove(discussion_ranking& ranking, const content_object::id_type& id) const;
+
+        void update(const content_object::id_type& id);
+
+        void remove_deleted();
+
+        void clear();
+
+        database& db_;
+
+        uint32_t ranking_size_ = 0;
+        uint32_t max_tags_ = 0;
+        uint32_t max_discussions_ = 0;
+
+        // Used only by the thread, which applies blocks
+        std::set<content_object::id_type> changed_;
+        std::set<account_object::id_type> deleted_authors_;
+        uint32_t last_block_num_ = 0;
+
+        std::mutex mutex_;
+
+        std::map<tag_key, tag_rankings> tags_;
+        std::list<tag_key> tags_lru_;
+
+        // Tags, in which rankings content can be, to remove it on changes
+        std::map<content_object::id_type, std::set<tag_key>> memberships_;
+
+        std::map<content_object::id_type, cached_discussion> discussions_;
+        std::list<content_object::id_type> discussions_lru_;
+    };
+
+} } } // graphene::plugins::tags
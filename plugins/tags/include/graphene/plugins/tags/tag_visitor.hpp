@@ -5,13 +5,20 @@
 #include <graphene/chain/account_object.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <set>
+
 namespace graphene { namespace plugins { namespace tags {
 
     struct operation_visitor {
         operation_visitor(database& db);
+
+        /// Updates of tags on votes and payout updates are deferred to update_changed_tags() at the end of block
+        operation_visitor(database& db, std::set<content_object::id_type>& changed_contents);
+
         using result_type = void;
 
         database& db_;
+        std::set<content_object::id_type>* changed_contents_ = nullptr;
 
         void remove_stats(const tag_object& tag) const;
 
@@ -21,17 +28,16 @@ namespace graphene { namespace plugins { namespace tags {
 
         const tag_stats_object& get_stats(const tag_object&) const;
 
-        void update_tag(const tag_object&, const content_object&, double hot, double trending) const;
+        void update_tag(const tag_object&, const content_object&, double score) const;
 
-        void create_tag(const std::string&, const tag_type, const content_object&, double hot, double trending) const;
+        void create_tag(const std::string&, const tag_type, const content_object&, double score) const;
 
         /**
          * https://medium.com/hacking-and-gonzo/how-reddit-ranking-algorithms-work-ef111e33d0d9#.lcbj6auuw
          */
-        template<int64_t S, int32_t T>
-        double calculate_score(const share_type& score, const time_point_sec& created) const {
+        double calculate_score(const share_type& score) const {
             /// new algorithm
-            auto mod_score = score.value / S;
+            auto mod_score = score.value / tag_score_rshares_divider;
 
             /// reddit algorithm
             double order = log10(std::max<int64_t>(std::abs(mod_score), 1));
@@ -43,16 +49,20 @@ namespace graphene { namespace plugins { namespace tags {
                 sign = -1;
             }
 
-            return sign * order + double(created.sec_since_epoch()) / double(T);
+            return sign * order;
         }
 
-        inline double calculate_hot(const share_type& score, const time_point_sec& created) const;
-
-        inline double calculate_trending(const share_type& score, const time_point_sec& created) const;
-
         /** finds tags that have been added or removed or updated */
         void create_update_tags(const account_name_type& author, const std::string& permlink) const;
         void update_tags(const account_name_type& author, const std::string& permlink) const;
+        void update_content_tags(const content_object& content) const;
+
+        /** marks the content and its parents for update_changed_tags(), or updates tags if they aren't deferred */
+        void defer_update_tags(const account_name_type& author, const std::string& permlink) const;
+
+        /** updates tags of contents changed in the block once per content */
+        void update_changed_tags() const;
+
         void remove_tags(const account_name_type& author, const std::string& permlink) const;
 
         void operator()(const content_operation& op) const;
@@ -42,6 +42,14 @@ namespace graphene { namespace plugins { namespace tags {
 
     using tag_name_type = fc::fixed_string<fc::sha256> ;
 
+    /**
+     * Hot and trending ranks are the log-score of rshares plus the time of creation with different weights.
+     * They are changed only with rshares, so only the log-score is stored and ranks are calculated on comparing.
+     */
+    constexpr int64_t tag_score_rshares_divider = 10000000;
+    constexpr int32_t tag_hot_time_divider = 10000;
+    constexpr int32_t tag_trending_time_divider = 480000;
+
     enum class tag_type: uint8_t {
         tag,
         language
@@ -87,8 +95,15 @@ namespace graphene { namespace plugins { namespace tags {
         int64_t net_rshares = 0;
         int32_t net_votes = 0;
         int32_t children = 0;
-        double hot = 0;
-        double trending = 0;
+        double score = 0; ///< sign(rshares) * log10(|rshares| / tag_score_rshares_divider)
+
+        double hot() const {
+            return score + double(created.sec_since_epoch()) / double(tag_hot_time_divider);
+        }
+
+        double trending() const {
+            return score + double(created.sec_since_epoch()) / double(tag_trending_time_divider);
+        }
 
         /**
          *  Used to track the total rshares^2 of all children, this is used for indexing purposes. A discussion
@@ -210,7 +225,7 @@ namespace graphene { namespace plugins { namespace tags {
                 tag<sort::by_hot>,
                 composite_key<
                     tag_object,
-                    member<tag_object, double, &tag_object::hot>,
+                    const_mem_fun<tag_object, double, &tag_object::hot>,
                     member<tag_object, tag_id_type, &tag_object::id> >,
                 composite_key_compare<
                     std::greater<double>,
@@ -219,7 +234,7 @@ namespace graphene { namespace plugins { namespace tags {
                 tag<sort::by_trending>,
                 composite_key<
                     tag_object,
-                    member<tag_object, double, &tag_object::trending>,
+                    const_mem_fun<tag_object, double, &tag_object::trending>,
                     member<tag_object, tag_id_type, &tag_object::id> >,
                 composite_key_compare<
                     std::greater<double>,
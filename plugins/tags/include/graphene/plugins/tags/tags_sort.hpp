@@ -13,7 +13,8 @@ namespace graphene { namespace plugins { namespace tags { namespace sort {
     using protocol::public_key_type;
 
     struct by_trending {
-        bool operator()(const discussion& first, const discussion& second) const {
+        template<typename Discussion>
+        bool operator()(const Discussion& first, const Discussion& second) const {
             if (std::greater<double>()(first.trending, second.trending)) {
                 return true;
             } else if (std::greater<double>()(second.trending, first.trending)) {
@@ -24,7 +25,8 @@ namespace graphene { namespace plugins { namespace tags { namespace sort {
     };
 
     struct by_created {
-        bool operator()(const discussion& first, const discussion& second) const {
+        template<typename Discussion>
+        bool operator()(const Discussion& first, const Discussion& second) const {
             if (std::greater<time_point_sec>()(first.created, second.created)) {
                 return true;
             } else if (std::equal_to<time_point_sec>()(first.created, second.created)) {
@@ -35,7 +37,8 @@ namespace graphene { namespace plugins { namespace tags { namespace sort {
     };
 
     struct by_active {
-        bool operator()(const discussion& first, const discussion& second) const {
+        template<typename Discussion>
+        bool operator()(const Discussion& first, const Discussion& second) const {
             if (std::greater<time_point_sec>()(first.active, second.active)) {
                 return true;
             } else if (std::equal_to<time_point_sec>()(first.active, second.active)) {
@@ -46,7 +49,8 @@ namespace graphene { namespace plugins { namespace tags { namespace sort {
     };
 
     struct by_updated {
-        bool operator()(const discussion& first, const discussion& second) const {
+        template<typename Discussion>
+        bool operator()(const Discussion& first, const Discussion& second) const {
             if (std::greater<time_point_sec>()(first.last_update, second.last_update)) {
                 return true;
             } else if (std::equal_to<time_point_sec>()(first.last_update, second.last_update)) {
@@ -57,7 +61,8 @@ namespace graphene { namespace plugins { namespace tags { namespace sort {
     };
 
     struct by_cashout {
-        bool operator()(const discussion& first, const discussion& second) const {
+        template<typename Discussion>
+        bool operator()(const Discussion& first, const Discussion& second) const {
             if (std::less<time_point_sec>()(first.cashout_time, second.cashout_time)) {
                 return true;
             } else if (std::equal_to<time_point_sec>()(first.cashout_time, second.cashout_time)) {
@@ -68,7 +73,8 @@ namespace graphene { namespace plugins { namespace tags { namespace sort {
     };
 
     struct by_net_rshares {
-        bool operator()(const discussion& first, const discussion& second) const {
+        template<typename Discussion>
+        bool operator()(const Discussion& first, const Discussion& second) const {
             if (std::greater<share_type>()(first.net_rshares, second.net_rshares)) {
                 return true;
             } else if (std::equal_to<share_type>()(first.net_rshares, second.net_rshares)) {
@@ -79,7 +85,8 @@ namespace graphene { namespace plugins { namespace tags { namespace sort {
     };
 
     struct by_net_votes {
-        bool operator()(const discussion& first, const discussion& second) const {
+        template<typename Discussion>
+        bool operator()(const Discussion& first, const Discussion& second) const {
             if (std::greater<int32_t>()(first.net_votes, second.net_votes)) {
                 return true;
             } else if (std::equal_to<int32_t>()(first.net_votes, second.net_votes)) {
@@ -90,7 +97,8 @@ namespace graphene { namespace plugins { namespace tags { namespace sort {
     };
 
     struct by_children {
-        bool operator()(const discussion& first, const discussion& second) const {
+        template<typename Discussion>
+        bool operator()(const Discussion& first, const Discussion& second) const {
             if (std::less<int32_t>()(first.children, second.children)) {
                 return true;
             } else if (std::equal_to<int32_t>()(first.children, second.children)) {
@@ -101,7 +109,8 @@ namespace graphene { namespace plugins { namespace tags { namespace sort {
     };
 
     struct by_hot {
-        bool operator()(const discussion& first, const discussion& second) const {
+        template<typename Discussion>
+        bool operator()(const Discussion& first, const Discussion& second) const {
             if (std::greater<double>()(first.hot, second.hot)) {
                 return true;
             } else if (std::greater<double>()(second.hot, first.hot)) {
@@ -1,6 +1,7 @@
 #include <boost/program_options/options_description.hpp>
 #include <graphene/plugins/tags/plugin.hpp>
 #include <graphene/plugins/tags/tags_object.hpp>
+#include <graphene/plugins/tags/discussion_rankings.hpp>
 #include <graphene/chain/index.hpp>
 #include <graphene/api/discussion.hpp>
 #include <graphene/plugins/tags/discussion_query.hpp>
@@ -9,6 +10,7 @@
 #include <graphene/api/discussion_helper.hpp>
 // These visitors creates additional tables, we don't really need them in LOW_MEM mode
 #include <graphene/plugins/tags/tag_visitor.hpp>
+#include <graphene/plugins/follow/follow_feed.hpp>
 #include <graphene/chain/operation_notification.hpp>
 
 #define CHECK_ARG_SIZE(_S)                                 \
@@ -33,7 +35,9 @@ namespace graphene { namespace plugins { namespace tags {
     using graphene::api::discussion_helper;
 
     struct tags_plugin::impl final {
-        impl(): database_(appbase::app().get_plugin<chain::plugin>().db()) {
+        impl()
+            : database_(appbase::app().get_plugin<chain::plugin>().db()),
+              rankings_(database_) {
             helper = std::make_unique<discussion_helper>(database_);
         }
 
@@ -43,7 +47,8 @@ namespace graphene { namespace plugins { namespace tags {
 #ifndef IS_LOW_MEM
             try {
                 /// plugins shouldn't ever throw
-                note.op.visit(tags::operation_visitor(database()));
+                note.op.visit(tags::operation_visitor(database(), changed_contents_));
+                rankings_.on_operation(note.op);
             } catch (const fc::exception& e) {
                 edump((e.to_detail_string()));
             } catch (...) {
@@ -52,10 +57,27 @@ namespace graphene { namespace plugins { namespace tags {
 #endif
         }
 
+        void on_applied_block(const signed_block& block) {
+            try {
+#ifndef IS_LOW_MEM
+                tags::operation_visitor(database(), changed_contents_).update_changed_tags();
+#endif
+                rankings_.on_applied_block(block);
+            } catch (const fc::exception& e) {
+                edump((e.to_detail_string()));
+            } catch (...) {
+                elog("unhandled exception");
+            }
+        }
+
         graphene::chain::database& database() {
             return database_;
         }
 
+        discussion_rankings& rankings() {
+            return rankings_;
+        }
+
         graphene::chain::database& database() const {
             return database_;
         }
@@ -78,6 +100,8 @@ namespace graphene { namespace plugins { namespace tags {
         template<typename DatabaseIndex, typename DiscussionIndex>
         std::vector<discussion> select_unordered_discussions(discussion_query& query) const;
 
+        std::vector<discussion> select_feed_discussions(discussion_query& query) const;
+
         template<typename Iterator, typename Order, typename Select, typename Exit>
         void select_discussions(
             std::set<content_object::id_type>& id_set,
@@ -89,6 +113,11 @@ namespace graphene { namespace plugins { namespace tags {
             Order&& order
         ) const;
 
+        template<typename Selector>
+        bool select_ranked_discussions(
+            std::vector<discussion>& result, const discussion_query& query, ranking_sort sort, Selector&& selector
+        ) const;
+
         template<typename DiscussionOrder, typename Selector>
         std::vector<discussion> select_ordered_discussions(discussion_query&, Selector&&) const;
 
@@ -109,7 +138,9 @@ namespace graphene { namespace plugins { namespace tags {
 
         discussion create_discussion(const content_object& o) const;
         discussion create_discussion(const content_object& o, const discussion_query& query) const;
+        std::shared_ptr<const discussion> create_cached_discussion(const content_object& o) const;
         void fill_discussion(discussion& d, const discussion_query& query) const;
+        void fill_cached_discussion(discussion& d, const discussion_query& query) const;
 
         get_languages_result get_languages();
 
@@ -117,6 +148,10 @@ namespace graphene { namespace plugins { namespace tags {
 
     private:
         graphene::chain::database& database_;
+        mutable discussion_rankings rankings_;
+
+        // Contents, whose tags are updated once at the end of block, instead of on each vote
+        std::set<content_object::id_type> changed_contents_;
         std::unique_ptr<discussion_helper> helper;
     };
 
@@ -144,8 +179,24 @@ namespace graphene { namespace plugins { namespace tags {
         return helper->create_discussion(o);
     }
 
+    std::shared_ptr<const discussion> tags_plugin::impl::create_cached_discussion(const content_object& o) const {
+        auto result = rankings_.find_discussion(o);
+        if (!result) {
+            auto d = std::make_shared<discussion>(create_discussion(o));
+            set_url(*d);
+            result = d;
+            rankings_.store_discussion(o, result);
+        }
+        return result;
+    }
+
     void tags_plugin::impl::fill_discussion(discussion& d, const discussion_query& query) const {
         set_url(d);
+        fill_cached_discussion(d, query);
+    }
+
+    // Payout depends on the reward fund and votes aren't cached, so they are always read
+    void tags_plugin::impl::fill_cached_discussion(discussion& d, const discussion_query& query) const {
         set_pending_payout(d);
         select_active_votes(d.active_votes, d.active_votes_count, d.author, d.permlink, query.vote_limit);
         if (query.truncate_body) {
@@ -201,7 +252,14 @@ namespace graphene { namespace plugins { namespace tags {
                                             boost::program_options::options_description &cfg) {
         cli.add_options()
             ("tags-content-lifespan", boost::program_options::value<uint32_t>()->default_value(604800),
-                "Set the sec amount before content remove from tag index");
+                "Set the sec amount before content remove from tag index")
+            ("tags-ranking-size", boost::program_options::value<uint32_t>()->default_value(1000),
+                "Size of materialized top of discussions per tag for trending, hot, payout, votes and children "
+                "sort orders, 0 disables them")
+            ("tags-ranking-max-tags", boost::program_options::value<uint32_t>()->default_value(1000),
+                "Maximum amount of tags with materialized top of discussions, least recently requested are removed")
+            ("tags-discussion-cache-size", boost::program_options::value<uint32_t>()->default_value(10000),
+                "Maximum amount of rendered discussions cached until the content is changed, 0 disables the cache");
         cfg.add(cli);
     }
 
@@ -217,6 +275,14 @@ namespace graphene { namespace plugins { namespace tags {
         add_plugin_index<tags::tag_stats_index>(db);
         add_plugin_index<tags::author_tag_stats_index>(db);
         add_plugin_index<tags::language_index>(db);
+
+        pimpl->rankings().configure(
+            options["tags-ranking-size"].as<uint32_t>(),
+            options["tags-ranking-max-tags"].as<uint32_t>(),
+            options["tags-discussion-cache-size"].as<uint32_t>());
+        db.applied_block.connect([&](const signed_block& block) {
+            pimpl->on_applied_block(block);
+        });
 #endif
 
         if (options.count("tags-content-lifespan")) {
@@ -234,6 +300,7 @@ namespace graphene { namespace plugins { namespace tags {
         time_point_sec lifespan_moment=fc::time_point::now() - fc::seconds(pimpl->content_livespan_);
         for(auto citr_cur = content_idx.begin();citr_cur != content_idx.lower_bound(lifespan_moment); ++citr_cur) {
             const tag_object* tag = &*citr_cur;
+            pimpl->rankings().on_tag_removed(*tag);
             const auto& idx = db.get_index<author_tag_stats_index>().indices().get<by_author_tag_posts>();
             auto itr = idx.lower_bound(std::make_tuple(tag->author, tag->type, tag->name));
             if (itr != idx.end() && itr->author == tag->author && itr->name == tag->name && itr->type == tag->type) {
@@ -364,6 +431,61 @@ namespace graphene { namespace plugins { namespace tags {
         return true;
     }
 
+    std::vector<discussion> tags_plugin::impl::select_feed_discussions(discussion_query& query) const {
+        std::vector<discussion> result;
+
+        if (!filter_start_content(query) || !filter_query(query)) {
+            return result;
+        }
+
+        auto& db = database();
+        const auto fanout_limit = appbase::app().get_plugin<follow::plugin>().feed_fanout_limit();
+        bool can_add = !query.has_start_content();
+
+        result.reserve(query.limit);
+
+        std::set<content_object::id_type> id_set;
+        for (auto aitr = query.select_authors.begin();
+             query.select_authors.end() != aitr && result.size() < query.limit; ++aitr
+        ) {
+            // The stored feed is merged with blogs of followed authors, which aren't copied into feeds
+            follow::feed_reader reader(db, *aitr, ~0, fanout_limit);
+            for (; reader.valid() && result.size() < query.limit; reader.next()) {
+                const auto content_id = reader.current().content;
+                if (!id_set.insert(content_id).second) {
+                    continue;
+                }
+
+                if (!can_add) {
+                    can_add = (query.is_good_start(content_id));
+                    if (!can_add) {
+                        continue;
+                    }
+                }
+
+                const auto* content = db.find(content_id);
+                if (!content) {
+                    continue;
+                }
+
+                if ((query.parent_author && *query.parent_author != content->parent_author) ||
+                    (query.parent_permlink && *query.parent_permlink != to_string(content->parent_permlink))
+                ) {
+                    continue;
+                }
+
+                discussion d = create_discussion(*content);
+                if (!query.is_good_tags(d)) {
+                    continue;
+                }
+
+                fill_discussion(d, query);
+                result.push_back(d);
+            }
+        }
+        return result;
+    }
+
     template<
         typename DatabaseIndex,
         typename DiscussionIndex>
@@ -462,8 +584,8 @@ namespace graphene { namespace plugins { namespace tags {
             }
 
             fill_discussion(d, query);
-            d.hot = itr->hot;
-            d.trending = itr->trending;
+            d.hot = itr->hot();
+            d.trending = itr->trending();
 
             if (query.has_start_content() && !query.is_good_start(d.id) && !order(query.start_content, d)) {
                 continue;
@@ -473,6 +595,82 @@ namespace graphene { namespace plugins { namespace tags {
         }
     }
 
+    template<typename Selector>
+    bool tags_plugin::impl::select_ranked_discussions(
+        std::vector<discussion>& result,
+        const discussion_query& query,
+        ranking_sort sort,
+        Selector&& selector
+    ) const {
+        auto& db = database();
+
+        // The merged order is known only up to the last entry of the shortest incomplete top
+        std::vector<ranked_discussion> ranked;
+        fc::optional<ranked_discussion> bound;
+        for (auto& name: query.select_tags) {
+            auto ranking = rankings_.get_ranking(name, sort);
+            if (!ranking.complete) {
+                if (ranking.entries.empty()) {
+                    return false;
+                }
+                const auto& last = ranking.entries.back();
+                if (!bound || is_ranked_before(sort, last, *bound)) {
+                    bound = last;
+                }
+            }
+            ranked.insert(ranked.end(), ranking.entries.begin(), ranking.entries.end());
+        }
+
+        std::sort(ranked.begin(), ranked.end(), [sort](const ranked_discussion& first, const ranked_discussion& second) {
+            return is_ranked_before(sort, first, second);
+        });
+
+        std::set<content_object::id_type> id_set;
+        bool can_add = !query.has_start_content();
+        for (const auto& item: ranked) {
+            if (bound && is_ranked_before(sort, *bound, item)) {
+                return false;
+            }
+
+            if (!id_set.insert(item.id).second) {
+                continue;
+            }
+
+            if (!query.is_good_parent(item.parent) || !query.is_good_author(item.author)) {
+                continue;
+            }
+
+            const auto* content = db.find(item.id);
+            if (!content) {
+                continue;
+            }
+
+            auto cached = create_cached_discussion(*content);
+            if (!selector(*cached) || !query.is_good_tags(*cached)) {
+                continue;
+            }
+
+            if (!can_add) {
+                can_add = query.is_good_start(item.id);
+                if (!can_add) {
+                    continue;
+                }
+            }
+
+            discussion d = *cached;
+            fill_cached_discussion(d, query);
+            d.hot = item.hot;
+            d.trending = item.trending;
+            result.push_back(std::move(d));
+
+            if (result.size() >= query.limit) {
+                return true;
+            }
+        }
+
+        return !bound;
+    }
+
     template<
         typename DiscussionOrder,
         typename Selector>
@@ -490,6 +688,14 @@ namespace graphene { namespace plugins { namespace tags {
                 return false;
             }
 
+            if (query.has_tags_selector() && ranking_sort_of<DiscussionOrder>::materialized && rankings_.enabled()) {
+                if (select_ranked_discussions(unordered, query, ranking_sort_of<DiscussionOrder>::value, selector)) {
+                    return true;
+                }
+                // The top isn't enough for the query, so all discussions of tags are read
+                unordered.clear();
+            }
+
             std::set<content_object::id_type> id_set;
             if (query.has_tags_selector()) { // seems to have a least complexity
                 const auto& idx = db.get_index<tags::tag_index>().indices().get<tags::by_tag>();
@@ -621,7 +827,7 @@ namespace graphene { namespace plugins { namespace tags {
         FC_ASSERT(db.has_index<follow::feed_index>(), "Node is not running the follow plugin");
 
         return db.with_weak_read_lock([&]() {
-            return pimpl->select_unordered_discussions<follow::feed_index, follow::by_feed>(query);
+            return pimpl->select_feed_discussions(query);
         });
 #endif
         return result;
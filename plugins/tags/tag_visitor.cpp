@@ -7,6 +7,11 @@ namespace graphene { namespace plugins { namespace tags {
         : db_(db) {
     }
 
+    operation_visitor::operation_visitor(database& db, std::set<content_object::id_type>& changed_contents)
+        : db_(db),
+          changed_contents_(&changed_contents) {
+    }
+
     void operation_visitor::remove_stats(const tag_object& tag) const {
         const auto& idx = db_.get_index<tag_stats_index>().indices().get<by_tag>();
         auto itr = idx.find(std::make_tuple(tag.type, tag.name));
@@ -81,10 +86,21 @@ namespace graphene { namespace plugins { namespace tags {
         db_.remove(tag);
     }
 
-    void operation_visitor::update_tag(
-        const tag_object& current, const content_object& content, double hot, double trending
-    ) const {
+    void operation_visitor::update_tag(const tag_object& current, const content_object& content, double score) const {
         auto cashout_time = db_.calculate_discussion_payout_time(content);
+
+        // Each modify checks positions in all indexes, and most of updates don't change anything
+        if (current.active == content.active &&
+            current.cashout == cashout_time &&
+            current.children == content.children &&
+            current.net_rshares == content.net_rshares.value &&
+            current.net_votes == content.net_votes &&
+            current.children_rshares == content.children_rshares &&
+            current.score == score
+        ) {
+            return;
+        }
+
         remove_stats(current);
         db_.modify(current, [&](tag_object& obj) {
             obj.active = content.active;
@@ -93,14 +109,13 @@ namespace graphene { namespace plugins { namespace tags {
             obj.net_rshares = content.net_rshares.value;
             obj.net_votes = content.net_votes;
             obj.children_rshares = content.children_rshares;
-            obj.hot = hot;
-            obj.trending = trending;
+            obj.score = score;
         });
         add_stats(current);
     }
 
     void operation_visitor::create_tag(
-        const std::string& name, const tag_type type, const content_object& content, double hot, double trending
+        const std::string& name, const tag_type type, const content_object& content, double score
     ) const {
         auto author = db_.get_account(content.author).id;
 
@@ -123,8 +138,7 @@ namespace graphene { namespace plugins { namespace tags {
             obj.net_rshares = content.net_rshares.value;
             obj.children_rshares = content.children_rshares;
             obj.author = author;
-            obj.hot = hot;
-            obj.trending = trending;
+            obj.score = score;
         });
 
         add_stats(tag_obj);
@@ -155,20 +169,11 @@ namespace graphene { namespace plugins { namespace tags {
         }
     }
 
-    double operation_visitor::calculate_hot(const share_type& score, const time_point_sec& created) const {
-        return calculate_score<10000000, 10000>(score, created);
-    }
-
-    double operation_visitor::calculate_trending(const share_type& score, const time_point_sec& created) const {
-        return calculate_score<10000000, 480000>(score, created);
-    }
-
     void operation_visitor::create_update_tags(
         const account_name_type& author, const std::string& permlink
     ) const { try {
         const auto& content = db_.get_content(author, permlink);
-        auto hot = calculate_hot(content.net_rshares, content.created);
-        auto trending = calculate_trending(content.net_rshares, content.created);
+        auto score = calculate_score(content.net_rshares);
         const auto& content_idx = db_.get_index<tag_index>().indices().get<by_content>();
 
         auto meta = get_metadata(content_api_object(content, db_));
@@ -204,14 +209,14 @@ namespace graphene { namespace plugins { namespace tags {
         for (const auto& name : meta.tags) {
             auto existing = existing_tags.find(name);
             if (existing == existing_tags.end()) {
-                create_tag(name, tag_type::tag, content, hot, trending);
+                create_tag(name, tag_type::tag, content, score);
             } else {
-                update_tag(*existing->second, content, hot, trending);
+                update_tag(*existing->second, content, score);
             }
         }
 
         if (!meta.language.empty() && (!language_tag || meta.language != language_tag->name)) {
-            create_tag(meta.language, tag_type::language, content, hot, trending);
+            create_tag(meta.language, tag_type::language, content, score);
         }
 
         for (const auto& item : remove_queue) {
@@ -219,22 +224,52 @@ namespace graphene { namespace plugins { namespace tags {
         }
     } FC_CAPTURE_LOG_AND_RETHROW(()) }
 
-    void operation_visitor::update_tags(const account_name_type& author, const std::string& permlink) const {
-        const auto& content = db_.get_content(author, permlink);
-        auto hot = calculate_hot(content.net_rshares, content.created);
-        auto trending = calculate_trending(content.net_rshares, content.created);
+    void operation_visitor::update_content_tags(const content_object& content) const {
+        auto score = calculate_score(content.net_rshares);
         const auto& content_idx = db_.get_index<tag_index>().indices().get<by_content>();
 
         auto citr = content_idx.lower_bound(content.id);
         for (; citr != content_idx.end() && citr->content == content.id; ++citr) {
-            update_tag(*citr, content, hot, trending);
+            update_tag(*citr, content, score);
         }
+    }
+
+    void operation_visitor::update_tags(const account_name_type& author, const std::string& permlink) const {
+        const auto& content = db_.get_content(author, permlink);
+        update_content_tags(content);
 
         if (content.parent_author.size()) {
             update_tags(content.parent_author, to_string(content.parent_permlink));
         }
     }
 
+    void operation_visitor::defer_update_tags(const account_name_type& author, const std::string& permlink) const {
+        if (!changed_contents_) {
+            update_tags(author, permlink);
+            return;
+        }
+
+        const auto* content = &db_.get_content(author, permlink);
+        while (changed_contents_->insert(content->id).second && content->parent_author.size()) {
+            content = &db_.get_content(content->parent_author, content->parent_permlink);
+        }
+    }
+
+    void operation_visitor::update_changed_tags() const {
+        if (!changed_contents_) {
+            return;
+        }
+
+        for (const auto& id: *changed_contents_) {
+            // The content can be deleted after votes in the same block
+            const auto* content = db_.find(id);
+            if (content) {
+                update_content_tags(*content);
+            }
+        }
+        changed_contents_->clear();
+    }
+
     void operation_visitor::remove_tags(const account_name_type& author, const std::string& permlink) const {
         const auto& content = db_.get_content(author, permlink);
         const auto& content_idx = db_.get_index<tag_index>().indices().get<by_content>();
@@ -317,7 +352,7 @@ namespace graphene { namespace plugins { namespace tags {
 
     void operation_visitor::operator()(const vote_operation& op) const {
         // only update existing tags
-        update_tags(op.author, op.permlink);
+        defer_update_tags(op.author, op.permlink);
     }
 
     void operation_visitor::operator()(const content_payout_update_operation& op) const {
@@ -325,7 +360,7 @@ namespace graphene { namespace plugins { namespace tags {
         const auto cashout_time = db_.calculate_discussion_payout_time(content);
 
         if (cashout_time != fc::time_point_sec::maximum()) {
-            update_tags(op.author, op.permlink);
+            defer_update_tags(op.author, op.permlink);
         }
         /*
         else {
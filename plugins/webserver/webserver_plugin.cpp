@@ -107,6 +107,8 @@ namespace graphene {
 
                 plugins::json_rpc::plugin *api;
                 boost::signals2::connection chain_sync_con;
+
+                bool enable_metrics = false;
             };
 
             void webserver_plugin::webserver_plugin_impl::start_webserver() {
@@ -215,6 +217,14 @@ namespace graphene {
 
             void webserver_plugin::webserver_plugin_impl::handle_http_message(websocket_server_type *server, connection_hdl hdl) {
                 auto con = server->get_con_from_hdl(hdl);
+
+                if (enable_metrics && con->get_request().get_method() == "GET" && con->get_resource() == "/metrics") {
+                    con->set_body(api->get_prometheus_metrics());
+                    con->append_header("Content-Type", "text/plain; version=0.0.4");
+                    con->set_status(websocketpp::http::status_code::ok);
+                    return;
+                }
+
                 con->defer_http_response();
 
                 thread_pool_ios.post([con, this]() {
@@ -260,7 +270,9 @@ namespace graphene {
                     ("rpc-endpoint", boost::program_options::value<string>(),
                         "Local http and websocket endpoint for webserver requests. Deprectaed in favor of webserver-http-endpoint and webserver-ws-endpoint")
                     ("webserver-thread-pool-size", boost::program_options::value<thread_pool_size_t>()->default_value(256),
-                        "Number of threads used to handle queries. Default: 256.");
+                        "Number of threads used to handle queries. Default: 256.")
+                    ("webserver-enable-metrics", boost::program_options::value<bool>()->default_value(false),
+                        "Serve statistics of API methods in the Prometheus text format on GET /metrics of http endpoint.");
             }
 
             void webserver_plugin::plugin_initialize(const boost::program_options::variables_map &options) {
@@ -268,6 +280,7 @@ namespace graphene {
                 FC_ASSERT(thread_pool_size > 0, "webserver-thread-pool-size must be greater than 0");
                 ilog("configured with ${tps} thread pool size", ("tps", thread_pool_size));
                 my.reset(new webserver_plugin_impl(thread_pool_size));
+                my->enable_metrics = options.at("webserver-enable-metrics").as<bool>();
 
                 if (options.count("webserver-http-endpoint")) {
                     auto http_endpoint = options.at("webserver-http-endpoint").as<string>();
@@ -0,0 +1,239 @@
+/*
+ * Compares the index of account history with one node per operation of account
+ * and the paged index with delta-encoded ids of operations (plugins/account_history).
+ *
+ * Usage: bench_account_history [accounts] [operations] [queries] [limit]
+ *
+ * Activity of accounts follows the Zipf distribution, so there are a few hot accounts
+ * with millions of operations and a long tail of accounts with a few operations.
+ */
+
+#include <graphene/protocol/types.hpp>
+#include <graphene/plugins/account_history/history_page.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/composite_key.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace boost::multi_index;
+using graphene::protocol::account_name_type;
+using graphene::plugins::account_history::account_history_page_size;
+using graphene::plugins::account_history::append_history_delta;
+using graphene::plugins::account_history::history_page_reader;
+
+static std::size_t allocated_bytes = 0;
+
+template <typename T>
+struct counting_allocator {
+    using value_type = T;
+
+    counting_allocator() = default;
+
+    template <typename U>
+    counting_allocator(const counting_allocator<U> &) {
+    }
+
+    T *allocate(std::size_t n) {
+        allocated_bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *p, std::size_t n) {
+        allocated_bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const counting_allocator<U> &) const {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const counting_allocator<U> &) const {
+        return false;
+    }
+};
+
+// The same layout as the former account_history_object
+struct history_entry {
+    int64_t id;
+    account_name_type account;
+    uint32_t sequence;
+    int64_t op;
+};
+
+struct by_id;
+struct by_account;
+using history_entry_index = multi_index_container<
+    history_entry,
+    indexed_by<
+        ordered_unique<tag<by_id>, member<history_entry, int64_t, &history_entry::id>>,
+        ordered_unique<tag<by_account>,
+            composite_key<history_entry,
+                member<history_entry, account_name_type, &history_entry::account>,
+                member<history_entry, uint32_t, &history_entry::sequence>>,
+            composite_key_compare<std::less<account_name_type>, std::greater<uint32_t>>>>,
+    counting_allocator<history_entry>>;
+
+struct history_page {
+    uint32_t count = 0;
+    int64_t first_op = 0;
+    int64_t last_op = 0;
+    std::vector<char, counting_allocator<char>> data;
+};
+
+using page_key = std::pair<account_name_type, uint32_t>;
+using history_page_index = std::map<
+    page_key, history_page, std::less<page_key>,
+    counting_allocator<std::pair<const page_key, history_page>>>;
+
+using clock_type = std::chrono::steady_clock;
+
+static double elapsed_ms(const clock_type::time_point &start) {
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+    const uint32_t accounts = argc > 1 ? std::stoul(argv[1]) : 100000;
+    const uint64_t operations = argc > 2 ? std::stoull(argv[2]) : 10000000;
+    const uint32_t queries = argc > 3 ? std::stoul(argv[3]) : 1000;
+    const uint32_t limit = argc > 4 ? std::stoul(argv[4]) : 10000;
+
+    std::cout << "accounts: " << accounts << ", operations: " << operations
+              << ", queries: " << queries << ", limit: " << limit << std::endl;
+
+    std::vector<account_name_type> names;
+    names.reserve(accounts);
+    std::vector<double> weights;
+    weights.reserve(accounts);
+    for (uint32_t i = 0; i < accounts; ++i) {
+        names.emplace_back("user" + std::to_string(i));
+        weights.push_back(1.0 / std::pow(i + 1, 1.1));
+    }
+
+    std::mt19937_64 rng(42);
+    std::discrete_distribution<uint32_t> activity(weights.begin(), weights.end());
+    std::bernoulli_distribution second_account(0.5);
+
+    std::vector<uint32_t> sequences(accounts, 0);
+
+    history_entry_index entries;
+    history_page_index pages;
+    std::size_t entries_bytes = 0;
+    std::size_t pages_bytes = 0;
+
+    double entries_insert_ms = 0;
+    double pages_insert_ms = 0;
+
+    int64_t next_entry_id = 0;
+    for (int64_t op = 0; op < int64_t(operations); ++op) {
+        uint32_t impacted[2] = {activity(rng), 0};
+        std::size_t impacted_count = 1;
+        if (second_account(rng)) {
+            impacted[1] = activity(rng);
+            if (impacted[1] != impacted[0]) {
+                ++impacted_count;
+            }
+        }
+
+        for (std::size_t i = 0; i < impacted_count; ++i) {
+            const auto account = impacted[i];
+            const auto sequence = sequences[account]++;
+
+            auto start = clock_type::now();
+            allocated_bytes = entries_bytes;
+            entries.insert(history_entry{next_entry_id++, names[account], sequence, op});
+            entries_bytes = allocated_bytes;
+            entries_insert_ms += elapsed_ms(start);
+
+            start = clock_type::now();
+            allocated_bytes = pages_bytes;
+            auto &page = pages[page_key(names[account], sequence / account_history_page_size)];
+            if (page.count == 0) {
+                page.first_op = op;
+            } else {
+                append_history_delta(page.data, op - page.last_op);
+            }
+            page.last_op = op;
+            ++page.count;
+            pages_bytes = allocated_bytes;
+            pages_insert_ms += elapsed_ms(start);
+        }
+    }
+
+    std::cout << "entries:  " << entries.size() << " nodes, " << entries_bytes / (1024 * 1024) << " MB, "
+              << "insert " << entries_insert_ms << " ms" << std::endl;
+    std::cout << "pages:    " << pages.size() << " pages, " << pages_bytes / (1024 * 1024) << " MB, "
+              << "insert " << pages_insert_ms << " ms" << std::endl;
+
+    // Queries to the hot accounts with the most recent operations, as wallets and exchanges do
+    std::uniform_int_distribution<uint32_t> hot_account(0, std::min<uint32_t>(accounts, 100) - 1);
+    std::vector<int64_t> result;
+    result.reserve(limit + 1);
+    uint64_t checksum_entries = 0;
+    uint64_t checksum_pages = 0;
+
+    double entries_query_ms = 0;
+    double pages_query_ms = 0;
+
+    for (uint32_t q = 0; q < queries; ++q) {
+        const auto account = hot_account(rng);
+        if (sequences[account] == 0) {
+            continue;
+        }
+
+        std::uniform_int_distribution<uint32_t> from_dist(0, sequences[account] - 1);
+        const uint32_t last = from_dist(rng);
+        const uint32_t first = std::max(int64_t(0), int64_t(last) - limit);
+
+        auto start = clock_type::now();
+        result.clear();
+        const auto &idx = entries.get<by_account>();
+        auto itr = idx.lower_bound(std::make_tuple(names[account], last));
+        auto end = idx.upper_bound(std::make_tuple(names[account], first));
+        for (; itr != end; ++itr) {
+            result.push_back(itr->op);
+        }
+        entries_query_ms += elapsed_ms(start);
+        for (auto op: result) {
+            checksum_entries += op;
+        }
+
+        start = clock_type::now();
+        result.clear();
+        for (auto page_num = first / account_history_page_size; page_num <= last / account_history_page_size; ++page_num) {
+            const auto &page = pages.at(page_key(names[account], page_num));
+            history_page_reader reader(page.first_op, page.data.data(), page.data.size());
+            auto sequence = page_num * account_history_page_size;
+            do {
+                if (sequence >= first && sequence <= last) {
+                    result.push_back(reader.op());
+                }
+                ++sequence;
+            } while (sequence <= last && reader.next());
+        }
+        pages_query_ms += elapsed_ms(start);
+        for (auto op: result) {
+            checksum_pages += op;
+        }
+    }
+
+    std::cout << "get_account_history on hot accounts, avg per query:" << std::endl;
+    std::cout << "entries:  " << entries_query_ms / queries << " ms" << std::endl;
+    std::cout << "pages:    " << pages_query_ms / queries << " ms" << std::endl;
+
+    if (checksum_entries != checksum_pages) {
+        std::cerr << "Results of indexes are different" << std::endl;
+        return 1;
+    }
+    return 0;
+}
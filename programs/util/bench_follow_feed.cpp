@@ -0,0 +1,265 @@
+/*
+ * Measures the hybrid feed of the follow plugin (plugins/follow) on a database with the follow indexes:
+ * posts of authors with more than the fan-out limit of followers aren't copied into feeds of followers,
+ * feed_reader merges them from blogs of authors on reading.
+ *
+ * Usage: bench_follow_feed [accounts] [posts] [reads] [max_feed_size] [shared_memory_mb] [limits...]
+ *
+ * Followers of accounts follow the Zipf distribution, so there are a few authors with most of the followers.
+ * For each limit it reports authors and their followers on both sides of the limit, writes into feeds
+ * on posting, and the time of reading the first page of feed with entries taken from the stored feed
+ * (the cache) and entries merged from blogs (misses of the cache).
+ */
+
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/index.hpp>
+#include <graphene/plugins/follow/follow_feed.hpp>
+#include <graphene/plugins/follow/follow_forward.hpp>
+#include <graphene/plugins/follow/follow_objects.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using graphene::chain::database;
+using graphene::chain::content_object;
+using graphene::protocol::account_name_type;
+using namespace graphene::plugins::follow;
+
+using clock_type = std::chrono::steady_clock;
+
+static double elapsed_ms(const clock_type::time_point &start) {
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+struct social_graph {
+    std::vector<std::vector<uint32_t>> followers;
+    std::vector<std::vector<uint32_t>> following;
+};
+
+static social_graph make_graph(uint32_t accounts, std::mt19937_64 &rng) {
+    social_graph graph;
+    graph.followers.resize(accounts);
+    graph.following.resize(accounts);
+
+    std::vector<double> weights;
+    weights.reserve(accounts);
+    for (uint32_t i = 0; i < accounts; ++i) {
+        weights.push_back(1.0 / std::pow(i + 1, 1.1));
+    }
+    std::discrete_distribution<uint32_t> popularity(weights.begin(), weights.end());
+    std::geometric_distribution<uint32_t> following_count(0.02);
+
+    for (uint32_t follower = 0; follower < accounts; ++follower) {
+        std::set<uint32_t> authors;
+        const auto count = std::min<uint32_t>(following_count(rng) + 1, 1000);
+        for (uint32_t i = 0; i < count; ++i) {
+            const auto author = popularity(rng);
+            if (author != follower) {
+                authors.insert(author);
+            }
+        }
+        for (auto author: authors) {
+            graph.followers[author].push_back(follower);
+            graph.following[follower].push_back(author);
+        }
+    }
+    return graph;
+}
+
+static void populate_follows(database &db, const social_graph &graph, const std::vector<account_name_type> &names) {
+    for (uint32_t account = 0; account < names.size(); ++account) {
+        db.create<follow_count_object>([&](follow_count_object &c) {
+            c.account = names[account];
+            c.follower_count = graph.followers[account].size();
+            c.following_count = graph.following[account].size();
+        });
+        for (auto author: graph.following[account]) {
+            db.create<follow_object>([&](follow_object &f) {
+                f.follower = names[account];
+                f.following = names[author];
+                f.what = (1 << blog);
+            });
+        }
+    }
+}
+
+// The same as the follow plugin does on a root post
+static uint64_t add_post(
+        database &db, const account_name_type &author, uint32_t num, fc::time_point_sec created,
+        uint32_t fanout_limit, uint32_t max_feed_size) {
+    const auto &content = db.create<content_object>([&](content_object &c) {
+        c.author = author;
+        graphene::chain::from_string(c.permlink, "post-" + std::to_string(num));
+        c.created = created;
+        c.last_update = created;
+        c.active = created;
+    });
+
+    uint64_t feed_writes = 0;
+    if (!is_feed_pulled(db, author, fanout_limit)) {
+        const auto &idx = db.get_index<follow_index>().indices().get<by_following_follower>();
+        for (auto itr = idx.find(author); itr != idx.end() && itr->following == author; ++itr) {
+            if (itr->what & (1 << blog)) {
+                add_feed_entry(db, itr->follower, content.id, account_name_type(), max_feed_size);
+                ++feed_writes;
+            }
+        }
+    }
+
+    const auto &blog_idx = db.get_index<blog_index>().indices().get<by_blog>();
+    auto last_blog = blog_idx.lower_bound(author);
+    uint32_t next_id = 0;
+    if (last_blog != blog_idx.end() && last_blog->account == author) {
+        next_id = last_blog->blog_feed_id + 1;
+    }
+    db.create<blog_object>([&](blog_object &b) {
+        b.account = author;
+        b.content = content.id;
+        b.blog_feed_id = next_id;
+    });
+
+    return feed_writes;
+}
+
+int main(int argc, char **argv) {
+    try {
+        const uint32_t accounts = argc > 1 ? std::stoul(argv[1]) : 20000;
+        const uint32_t posts = argc > 2 ? std::stoul(argv[2]) : 50000;
+        const uint32_t reads = argc > 3 ? std::stoul(argv[3]) : 10000;
+        const uint32_t max_feed_size = argc > 4 ? std::stoul(argv[4]) : 500;
+        const uint64_t shared_memory_mb = argc > 5 ? std::stoull(argv[5]) : 4096;
+        const uint32_t page_size = 20;
+
+        std::vector<uint32_t> limits;
+        for (int i = 6; i < argc; ++i) {
+            limits.push_back(std::stoul(argv[i]));
+        }
+        if (limits.empty()) {
+            limits = {0, 10000, 1000, 100};
+        }
+
+        std::cout << "accounts: " << accounts << ", posts: " << posts << ", reads: " << reads
+                  << ", max_feed_size: " << max_feed_size << std::endl;
+
+        std::mt19937_64 rng(42);
+        const auto graph = make_graph(accounts, rng);
+
+        std::vector<account_name_type> names;
+        names.reserve(accounts);
+        for (uint32_t i = 0; i < accounts; ++i) {
+            names.emplace_back("user" + std::to_string(i));
+        }
+
+        // Active authors are popular ones, the same sequence of posts and readers is used for each limit
+        std::vector<double> weights;
+        weights.reserve(accounts);
+        for (uint32_t i = 0; i < accounts; ++i) {
+            weights.push_back(1.0 / std::pow(i + 1, 0.8));
+        }
+        std::discrete_distribution<uint32_t> activity(weights.begin(), weights.end());
+        std::vector<uint32_t> authors(posts);
+        for (auto &author: authors) {
+            author = activity(rng);
+        }
+
+        std::vector<uint32_t> readers;
+        std::uniform_int_distribution<uint32_t> any_account(0, accounts - 1);
+        while (readers.size() < reads) {
+            const auto reader = any_account(rng);
+            if (!graph.following[reader].empty()) {
+                readers.push_back(reader);
+            }
+        }
+
+        for (auto limit: limits) {
+            uint64_t pulled_authors = 0;
+            uint64_t pulled_followers = 0;
+            uint64_t fanned_authors = 0;
+            uint64_t fanned_followers = 0;
+            for (uint32_t account = 0; account < accounts; ++account) {
+                const auto followers = graph.followers[account].size();
+                if (followers == 0) {
+                    continue;
+                }
+                if (limit != 0 && followers > limit) {
+                    ++pulled_authors;
+                    pulled_followers += followers;
+                } else {
+                    ++fanned_authors;
+                    fanned_followers += followers;
+                }
+            }
+
+            fc::temp_directory temp_dir(".");
+            auto db = std::make_unique<database>();
+            graphene::chain::add_plugin_index<follow_index>(*db);
+            graphene::chain::add_plugin_index<feed_index>(*db);
+            graphene::chain::add_plugin_index<blog_index>(*db);
+            graphene::chain::add_plugin_index<follow_count_index>(*db);
+            graphene::chain::add_plugin_index<blog_author_stats_index>(*db);
+            db->open(temp_dir.path(), temp_dir.path(), CHAIN_INIT_SUPPLY,
+                shared_memory_mb * 1024 * 1024, chainbase::database::read_write);
+
+            uint64_t feed_writes = 0;
+            double post_ms = 0;
+            db->with_strong_write_lock([&]() {
+                populate_follows(*db, graph, names);
+
+                const auto start_time = db->head_block_time();
+                for (uint32_t i = 0; i < posts; ++i) {
+                    const auto start = clock_type::now();
+                    feed_writes += add_post(*db, names[authors[i]], i, start_time + i, limit, max_feed_size);
+                    post_ms += elapsed_ms(start);
+                }
+            });
+
+            uint64_t cache_hits = 0;
+            uint64_t cache_misses = 0;
+            uint64_t merged_blogs = 0;
+            double read_ms = 0;
+            db->with_strong_read_lock([&]() {
+                for (auto reader: readers) {
+                    const auto start = clock_type::now();
+                    feed_reader feed(*db, names[reader], ~0, limit);
+                    for (uint32_t n = 0; feed.valid() && n < page_size; feed.next(), ++n) {
+                        if (feed.current().feed != nullptr) {
+                            ++cache_hits;
+                        } else {
+                            ++cache_misses;
+                        }
+                    }
+                    read_ms += elapsed_ms(start);
+                    merged_blogs += feed.pulled_authors().size();
+                }
+            });
+
+            const auto stored_entries = db->get_index<feed_index>().indices().size();
+            const auto total_entries = std::max<uint64_t>(cache_hits + cache_misses, 1);
+
+            std::cout << "fan-out limit " << (limit == 0 ? std::string("none") : std::to_string(limit)) << ":" << std::endl;
+            std::cout << "  fanned out: " << fanned_authors << " authors, " << fanned_followers << " followers" << std::endl;
+            std::cout << "  pulled:     " << pulled_authors << " authors, " << pulled_followers << " followers" << std::endl;
+            std::cout << "  posting:    " << feed_writes << " writes into feeds, " << stored_entries
+                      << " stored entries, " << post_ms / posts << " ms per post" << std::endl;
+            std::cout << "  reading:    " << read_ms / reads << " ms per page, "
+                      << double(merged_blogs) / reads << " merged blogs per reader" << std::endl;
+            std::cout << "  cache:      " << cache_hits << " hits, " << cache_misses << " misses ("
+                      << 100.0 * cache_hits / total_entries << "% hits)" << std::endl;
+
+            db->close();
+        }
+    } catch (const fc::exception &e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+/*
+ * Measures throughput of the encrypted p2p socket (libraries/network/stcp_socket) over loopback,
+ * compares reading and writing through the internal 4 KiB buffers with chunked encryption
+ * and encryption of whole messages in place.
+ *
+ * Usage: bench_stcp_socket [megabytes per message size]
+ *
+ * Both ends of the connection run in fibers of the same thread, as connections of the p2p thread,
+ * so the result includes the cost of encryption on both sides.
+ */
+
+#include <graphene/network/stcp_socket.hpp>
+
+#include <fc/network/tcp_socket.hpp>
+#include <fc/network/ip.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using graphene::network::stcp_socket;
+
+enum class transfer_mode {
+    chunked,
+    in_place
+};
+
+static const char *mode_name(transfer_mode mode) {
+    return mode == transfer_mode::chunked ? "chunked" : "in place";
+}
+
+static double run(transfer_mode mode, std::size_t message_size, std::size_t total_size) {
+    fc::tcp_server server;
+    server.listen(fc::ip::endpoint(fc::ip::address("127.0.0.1"), 0));
+
+    stcp_socket sender;
+    stcp_socket receiver;
+
+    auto accepted = fc::async([&]() {
+        server.accept(receiver.get_socket());
+        receiver.accept();
+    }, "bench accept");
+    sender.connect_to(fc::ip::endpoint(fc::ip::address("127.0.0.1"), server.get_port()));
+    accepted.wait();
+
+    const std::size_t messages = std::max<std::size_t>(total_size / message_size, 1);
+    const std::vector<char> payload(message_size, 'v');
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto received = fc::async([&]() {
+        std::unique_ptr<char[]> buffer(new char[message_size]);
+        for (std::size_t i = 0; i < messages; ++i) {
+            if (mode == transfer_mode::chunked) {
+                receiver.read(buffer.get(), message_size);
+            } else {
+                receiver.read_in_place(buffer.get(), message_size);
+            }
+        }
+    }, "bench receive");
+
+    // A message is copied into the padded buffer before sending in both modes, as in message_oriented_connection
+    std::unique_ptr<char[]> buffer(new char[message_size]);
+    for (std::size_t i = 0; i < messages; ++i) {
+        std::memcpy(buffer.get(), payload.data(), message_size);
+        if (mode == transfer_mode::chunked) {
+            sender.write(buffer.get(), message_size);
+        } else {
+            sender.write_in_place(buffer.get(), message_size);
+        }
+    }
+    sender.flush();
+    received.wait();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    sender.close();
+    receiver.close();
+    server.close();
+
+    return double(messages * message_size) / (1024 * 1024) / elapsed.count();
+}
+
+int main(int argc, char **argv) {
+    const std::size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 256;
+    const std::size_t total_size = megabytes * 1024 * 1024;
+
+    // Sizes of messages are multiples of 16, as they are padded before encryption
+    const std::vector<std::size_t> message_sizes = {256, 4096, 64 * 1024, 1024 * 1024};
+
+    try {
+        std::cout << "message size, bytes\tmode\tthroughput, MiB/s" << std::endl;
+        for (auto message_size : message_sizes) {
+            for (auto mode : {transfer_mode::chunked, transfer_mode::in_place}) {
+                double throughput = run(mode, message_size, total_size);
+                std::cout << message_size << "\t" << mode_name(mode) << "\t" << throughput << std::endl;
+            }
+        }
+    } catch (const fc::exception &e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    }
+    return 0;
+}
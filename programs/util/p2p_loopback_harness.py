@@ -0,0 +1,272 @@
+#!/usr/bin/env python3
+
+"""
+Runs several vizd processes on loopback and measures the sync throughput and the block propagation latency
+of the p2p network.
+
+1. The producer node generates a synthetic chain with debug_node.debug_generate_blocks, blocks are signed
+   by the initiator witness "viz" with the key from share/vizd/config/config_debug.ini, so they are valid
+   for other nodes without any edits of the state.
+2. Followers are started with the producer as the seed node (or as a chain, where each node syncs from
+   the previous one) and the time until all of them reach the head block is measured.
+3. The producer is restarted with the witness plugin and stale production, it produces a block on each slot.
+   Heads of all nodes are polled and the delay between the producer and each follower is reported.
+
+The initiator key of the debug key must match CHAIN_INITIATOR_PUBLIC_KEY_STR of the built vizd (it's the case
+for the testnet build, see share/vizd/config/config_debug.ini), otherwise no blocks are generated.
+
+Usage: p2p_loopback_harness.py --vizd programs/vizd/vizd [--nodes 4] [--blocks 20000] [--io-threads 2]
+"""
+
+import argparse
+import json
+import os
+import shutil
+import signal
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+import urllib.request
+
+DEBUG_KEY = "5JVFFWRLwz6JoP9kguuRFfytToGU6cLgBVTL9t6NB3D3BQLbUBS"
+DEBUG_WITNESS = "viz"
+
+CONFIG = """
+p2p-endpoint = 127.0.0.1:{p2p_port}
+{seeds}
+p2p-io-threads = {io_threads}
+webserver-http-endpoint = 127.0.0.1:{http_port}
+webserver-thread-pool-size = 2
+single-write-thread = true
+shared-file-size = 1G
+plugin = {plugins}
+{witness}
+
+[log.console_appender.stderr]
+stream=std_error
+
+[logger.default]
+level=warn
+appenders=stderr
+
+[logger.p2p]
+level=warn
+appenders=stderr
+"""
+
+WITNESS_CONFIG = """
+enable-stale-production = true
+required-participation = 0
+witness = "{witness}"
+private-key = {key}
+"""
+
+
+class Node:
+    def __init__(self, args, index, seeds, producer):
+        self.args = args
+        self.index = index
+        self.seeds = seeds
+        self.producer = producer
+        self.p2p_port = args.base_port + index * 2
+        self.http_port = args.base_port + index * 2 + 1
+        self.data_dir = os.path.join(args.work_dir, "node%d" % index)
+        self.process = None
+        self.log = None
+
+    def write_config(self, with_witness):
+        plugins = "chain p2p json_rpc webserver database_api network_broadcast_api"
+        if self.producer:
+            plugins += " debug_node"
+            if with_witness:
+                plugins += " witness"
+        witness = ""
+        if self.producer and with_witness:
+            witness = WITNESS_CONFIG.format(witness=DEBUG_WITNESS, key=DEBUG_KEY)
+        seeds = "\n".join("p2p-seed-node = 127.0.0.1:%d" % port for port in self.seeds)
+
+        os.makedirs(self.data_dir, exist_ok=True)
+        with open(os.path.join(self.data_dir, "config.ini"), "w") as f:
+            f.write(CONFIG.format(
+                p2p_port=self.p2p_port, seeds=seeds, io_threads=self.args.io_threads,
+                http_port=self.http_port, plugins=plugins, witness=witness))
+
+    def start(self, with_witness=False):
+        self.write_config(with_witness)
+        self.log = open(os.path.join(self.data_dir, "vizd.log"), "a")
+        self.process = subprocess.Popen(
+            [self.args.vizd, "--data-dir", self.data_dir],
+            stdout=self.log, stderr=subprocess.STDOUT)
+        deadline = time.time() + self.args.start_timeout
+        while time.time() < deadline:
+            if self.process.poll() is not None:
+                raise RuntimeError("node%d exited, see %s" % (self.index, self.log.name))
+            try:
+                self.head_block_num()
+                return
+            except OSError:
+                time.sleep(0.2)
+        raise RuntimeError("node%d didn't start in %d seconds" % (self.index, self.args.start_timeout))
+
+    def stop(self):
+        if self.process and self.process.poll() is None:
+            self.process.send_signal(signal.SIGINT)
+            try:
+                self.process.wait(timeout=60)
+            except subprocess.TimeoutExpired:
+                self.process.kill()
+                self.process.wait()
+        self.process = None
+        if self.log:
+            self.log.close()
+            self.log = None
+
+    def call(self, api, method, params, timeout=600):
+        request = json.dumps({"jsonrpc": "2.0", "id": 1, "method": "call", "params": [api, method, params]})
+        response = urllib.request.urlopen(
+            urllib.request.Request(
+                "http://127.0.0.1:%d" % self.http_port, data=request.encode(),
+                headers={"Content-Type": "application/json"}),
+            timeout=timeout)
+        result = json.loads(response.read().decode())
+        if "error" in result:
+            raise RuntimeError("%s.%s failed: %s" % (api, method, result["error"]))
+        return result["result"]
+
+    def head_block_num(self):
+        return self.call("database_api", "get_dynamic_global_properties", [], timeout=5)["head_block_number"]
+
+
+def generate_chain(producer, blocks, chunk=1000):
+    generated = 0
+    start = time.time()
+    while generated < blocks:
+        count = min(chunk, blocks - generated)
+        produced = producer.call("debug_node", "debug_generate_blocks", [DEBUG_KEY, count, 0, 0, False])
+        if produced == 0:
+            raise RuntimeError("No blocks are generated, the debug key isn't the key of the scheduled witness")
+        generated += produced
+    print("generated %d blocks in %.1f s" % (generated, time.time() - start))
+    return producer.head_block_num()
+
+
+def measure_sync(followers, head, timeout):
+    start = time.time()
+    synced = {}
+    last_report = start
+    while len(synced) < len(followers):
+        now = time.time()
+        if now - start > timeout:
+            raise RuntimeError("sync didn't finish in %d seconds" % timeout)
+        for node in followers:
+            if node.index in synced:
+                continue
+            try:
+                if node.head_block_num() >= head:
+                    synced[node.index] = time.time() - start
+            except OSError:
+                pass
+        if now - last_report > 10:
+            heads = ", ".join("node%d: %s" % (n.index, n.head_block_num()) for n in followers)
+            print("  syncing: %s" % heads)
+            last_report = now
+        time.sleep(0.05)
+
+    for node in followers:
+        elapsed = synced[node.index]
+        print("node%d synced %d blocks in %.1f s, %.0f blocks/s" % (node.index, head, elapsed, head / elapsed))
+    slowest = max(synced.values())
+    print("all followers synced in %.1f s, %.0f blocks/s" % (slowest, head / slowest))
+
+
+def measure_latency(producer, followers, blocks, poll_interval):
+    delays = {node.index: [] for node in followers}
+    head = producer.head_block_num()
+    seen = {}
+    deadline = time.time() + blocks * 3 * 4 + 60
+
+    while len(seen) < blocks and time.time() < deadline:
+        num = producer.head_block_num()
+        now = time.time()
+        for n in range(head + 1, num + 1):
+            seen[n] = (now, set())
+        head = num
+
+        for node in followers:
+            try:
+                node_head = node.head_block_num()
+            except OSError:
+                continue
+            now = time.time()
+            for n, (produced_at, reached) in seen.items():
+                if n <= node_head and node.index not in reached:
+                    reached.add(node.index)
+                    delays[node.index].append(now - produced_at)
+        time.sleep(poll_interval)
+
+    print("propagation delays over %d blocks (polling interval %d ms):" % (len(seen), poll_interval * 1000))
+    for node in followers:
+        d = delays[node.index]
+        if not d:
+            print("  node%d: no blocks received" % node.index)
+            continue
+        d.sort()
+        print("  node%d: median %.1f ms, p90 %.1f ms, max %.1f ms" % (
+            node.index, statistics.median(d) * 1000, d[int(len(d) * 0.9)] * 1000, d[-1] * 1000))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Measures p2p sync throughput and latency of vizd on loopback")
+    parser.add_argument("--vizd", required=True, help="path to the vizd binary")
+    parser.add_argument("--nodes", type=int, default=4, help="number of nodes including the producer")
+    parser.add_argument("--blocks", type=int, default=20000, help="length of the synthetic chain")
+    parser.add_argument("--latency-blocks", type=int, default=20, help="number of produced blocks to measure latency")
+    parser.add_argument("--io-threads", type=int, default=2, help="value of p2p-io-threads for all nodes")
+    parser.add_argument("--topology", choices=["star", "chain"], default="star",
+                        help="star: followers sync from the producer, chain: each node syncs from the previous one")
+    parser.add_argument("--base-port", type=int, default=24100)
+    parser.add_argument("--work-dir", help="directory for data of nodes, a temporary one by default")
+    parser.add_argument("--keep", action="store_true", help="don't remove the work directory")
+    parser.add_argument("--start-timeout", type=int, default=120)
+    parser.add_argument("--sync-timeout", type=int, default=3600)
+    parser.add_argument("--poll-interval", type=float, default=0.005)
+    args = parser.parse_args()
+
+    temporary = args.work_dir is None
+    if temporary:
+        args.work_dir = tempfile.mkdtemp(prefix="vizd_p2p_")
+    print("work dir: %s" % args.work_dir)
+
+    producer = Node(args, 0, [], True)
+    followers = []
+    for i in range(1, args.nodes):
+        seed = producer.p2p_port if args.topology == "star" else args.base_port + (i - 1) * 2
+        followers.append(Node(args, i, [seed], False))
+    nodes = [producer] + followers
+
+    try:
+        producer.start()
+        head = generate_chain(producer, args.blocks)
+
+        for node in followers:
+            node.start()
+        measure_sync(followers, head, args.sync_timeout)
+
+        producer.stop()
+        producer.start(with_witness=True)
+        measure_latency(producer, followers, args.latency_blocks, args.poll_interval)
+    finally:
+        for node in nodes:
+            node.stop()
+        if temporary and not args.keep:
+            shutil.rmtree(args.work_dir, ignore_errors=True)
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except (RuntimeError, KeyboardInterrupt) as e:
+        print(e, file=sys.stderr)
+        sys.exit(1)